@@ -11,8 +11,9 @@ public:
     virtual void displayInfo(std::ostream& os) const = 0;
     virtual double getPrice() const = 0;
     virtual int getStock() const = 0;
-    virtual std::string getISBN() const = 0;
-    virtual std::string getTitle() const = 0;
+    // 字符串字段以常量引用返回，比较和排序时不复制
+    virtual const std::string& getISBN() const = 0;
+    virtual const std::string& getTitle() const = 0;
 };
 
 // 基础图书类
@@ -34,8 +35,8 @@ public:
     virtual void displayInfo(std::ostream& os) const override;
     virtual double getPrice() const override { return price; }
     virtual int getStock() const override { return stock; }
-    virtual std::string getISBN() const override { return isbn; }
-    virtual std::string getTitle() const override { return title; }
+    virtual const std::string& getISBN() const override { return isbn; }
+    virtual const std::string& getTitle() const override { return title; }
     
     // 友元函数
     friend std::ostream& operator<<(std::ostream& os, const Book& book);
@@ -67,8 +68,8 @@ public:
         
         double getPrice() const override { return book->getPrice(); }
         int getStock() const override { return book->getStock(); }
-        std::string getISBN() const override { return book->getISBN(); }
-        std::string getTitle() const override { return book->getTitle(); }
+        const std::string& getISBN() const override { return book->getISBN(); }
+        const std::string& getTitle() const override { return book->getTitle(); }
         
         void serialize(std::ostream& os) const override;
         void deserialize(std::istream& is) override;
@@ -101,11 +102,11 @@ public:
         return wrappedBook->getStock();
     }
     
-    std::string getISBN() const override {
+    const std::string& getISBN() const override {
         return wrappedBook->getISBN();
     }
     
-    std::string getTitle() const override {
+    const std::string& getTitle() const override {
         return wrappedBook->getTitle();
     }
 };
@@ -2,6 +2,7 @@
 #define FILE_OPERATIONS_H
 
 #include "BookManager.h"
+#include "AtomicFile.h"
 #include <string>
 
 class FileOperations {
@@ -11,8 +12,8 @@ private:
 public:
     explicit FileOperations(const std::string& file);
     
-    // 保存到文件
-    bool save(BookManager& manager);
+    // 保存到文件，结果同AtomicFile::commit()
+    AtomicFile::CommitResult save(BookManager& manager);
     
     // 从文件加载
     bool load(BookManager& manager);
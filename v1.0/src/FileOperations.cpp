@@ -4,15 +4,18 @@
 
 FileOperations::FileOperations(const std::string& file) : filename(file) {}
 
-bool FileOperations::save(BookManager& manager) {
-    std::ofstream ofs(filename);
-    if (!ofs.is_open()) {
-        return false;
+AtomicFile::CommitResult FileOperations::save(BookManager& manager) {
+    // 先写临时文件再改名覆盖，写到一半失败时原文件保持不变
+    AtomicFile file(filename);
+    if (!file.isOpen()) {
+        return AtomicFile::CommitResult::Failed;
     }
     
-    manager.serialize(ofs);
-    ofs.close();
-    return true;
+    manager.serialize(file.stream());
+    if (!file.stream()) {
+        return AtomicFile::CommitResult::Failed;
+    }
+    return file.commit();
 }
 
 bool FileOperations::load(BookManager& manager) {
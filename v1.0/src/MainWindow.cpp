@@ -183,10 +183,16 @@ void MainWindow::showAllBooks() {
 }
 
 void MainWindow::saveToFile() {
-    if (fileOps.save(bookManager)) {
-        updateDisplay("数据保存成功！");
-    } else {
-        updateDisplay("错误：数据保存失败！");
+    switch (fileOps.save(bookManager)) {
+        case AtomicFile::CommitResult::Replaced:
+            updateDisplay("数据保存成功！");
+            break;
+        case AtomicFile::CommitResult::DirectorySyncFailed:
+            updateDisplay("警告：数据已写入，但目录同步失败，掉电后可能恢复为上次保存的内容！");
+            break;
+        case AtomicFile::CommitResult::Failed:
+            updateDisplay("错误：数据保存失败！");
+            break;
     }
 }
 
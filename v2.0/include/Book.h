@@ -1,25 +1,39 @@
 #ifndef BOOK_H
 #define BOOK_H
 
+#include "StringPool.h"
+#include "IsbnKey.h"
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <fstream>
 
-class Book {
+// 作者/出版社驻留池的持有者登记：作为Book的基类，先于各字段构造、晚于各字段析构，
+// 每本存活的图书在取得驻留编号之前就已登记，池不会在它仍持有编号时被重置
+class PoolHolder {
+protected:
+    PoolHolder();
+    PoolHolder(const PoolHolder&) : PoolHolder() {}
+    PoolHolder& operator=(const PoolHolder&) { return *this; }
+    ~PoolHolder();
+};
+
+class Book : private PoolHolder {
 private:
     std::string title;          // 书名
-    std::string publisher;      // 出版社
-    std::string isbn;           // ISBN号
-    std::string author;         // 作者
+    IsbnKey isbn;               // ISBN号（压缩成64位的键）
+    StringPool::Id publisher;   // 出版社（publisherPool中的编号）
+    StringPool::Id author;      // 作者（authorPool中的编号）
     int stock;                  // 库存量
     double price;               // 价格
+    int reorderThreshold;       // 补货线：库存不高于此值时需要补货
 
 public:
     // 构造函数
     Book();
     Book(const std::string& title, const std::string& publisher, 
          const std::string& isbn, const std::string& author, 
-         int stock, double price);
+         int stock, double price, int reorderThreshold = 0);
     
     // 拷贝构造函数
     Book(const Book& other);
@@ -27,24 +41,41 @@ public:
     // 赋值运算符重载
     Book& operator=(const Book& other);
     
+    // 移动构造/移动赋值：容器扩容和批量加载时直接搬运字符串
+    Book(Book&& other) noexcept;
+    Book& operator=(Book&& other) noexcept;
+    
     // 析构函数
     ~Book();
     
-    // getter方法
-    std::string getTitle() const { return title; }
-    std::string getPublisher() const { return publisher; }
-    std::string getIsbn() const { return isbn; }
-    std::string getAuthor() const { return author; }
+    // 作者和出版社大量重复，全部图书共用这两个驻留池，每本书只存编号
+    static StringPool& authorPool();
+    static StringPool& publisherPool();
+    // 没有存活的图书和其他持有者时清空两个驻留池，释放已不再引用的字符串
+    static void releaseUnusedPools();
+    
+    // getter方法（字符串字段返回常量引用或池内视图，查询和排序时不复制）
+    const std::string& getTitle() const { return title; }
+    std::string_view getPublisher() const { return publisherPool().get(publisher); }
+    std::string getIsbn() const { return isbn.toString(); }
+    IsbnKey getIsbnKey() const { return isbn; }
+    std::string_view getAuthor() const { return authorPool().get(author); }
+    StringPool::Id getPublisherId() const { return publisher; }
+    StringPool::Id getAuthorId() const { return author; }
     int getStock() const { return stock; }
     double getPrice() const { return price; }
+    int getReorderThreshold() const { return reorderThreshold; }
+    // 库存与补货线的差，不大于0表示需要补货
+    int getReorderMargin() const { return stock - reorderThreshold; }
     
     // setter方法
     void setTitle(const std::string& t) { title = t; }
-    void setPublisher(const std::string& p) { publisher = p; }
-    void setIsbn(const std::string& i) { isbn = i; }
-    void setAuthor(const std::string& a) { author = a; }
+    void setPublisher(std::string_view p) { publisher = publisherPool().intern(p); }
+    void setIsbn(std::string_view i) { isbn = IsbnKey::parse(i); }
+    void setAuthor(std::string_view a) { author = authorPool().intern(a); }
     void setStock(int s) { stock = s; }
     void setPrice(double p) { price = p; }
+    void setReorderThreshold(int t) { reorderThreshold = t; }
     
     // 显示图书信息
     void display() const;
@@ -55,6 +86,9 @@ public:
     // 从字符串解析图书信息
     bool fromString(const std::string& str);
     
+    // 从一行文本（不含换行符）解析图书信息，供批量加载直接使用
+    bool parse(std::string_view line);
+    
     // 比较运算符重载（用于排序）
     bool operator<(const Book& other) const;
     bool operator==(const Book& other) const;
@@ -2,20 +2,134 @@
 #define BOOKMANAGER_H
 
 #include "Book.h"
+#include "DirtyTracker.h"
+#include "SegmentedFile.h"
+#include "StatsListener.h"
+#include "StockAlertListener.h"
 #include <vector>
+#include <iosfwd>
 #include <algorithm>
 #include <string>
-#include <memory>
+#include <iterator>
+#include <unordered_map>
+#include <set>
+#include <cstdint>
+
+// 查询结果的只读视图：直接引用索引内部的下标列表和书库的连续存储，不复制
+// 元素为const Book*；注意：对书库的任何增删改操作都会使已返回的视图失效
+class BookView {
+public:
+    class iterator {
+    private:
+        const Book* base;
+        const size_t* pos;
+    
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef const Book* value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const Book* const* pointer;
+        typedef const Book* reference;
+        
+        iterator(const Book* b, const size_t* p) : base(b), pos(p) {}
+        const Book* operator*() const { return base + *pos; }
+        iterator& operator++() { ++pos; return *this; }
+        bool operator==(const iterator& other) const { return pos == other.pos; }
+        bool operator!=(const iterator& other) const { return pos != other.pos; }
+    };
+
+private:
+    const Book* base;
+    const size_t* first;
+    const size_t* last;
+
+public:
+    BookView() : base(nullptr), first(nullptr), last(nullptr) {}
+    BookView(const std::vector<Book>& books, const std::vector<size_t>& ids)
+        : base(books.data()), first(ids.data()), last(ids.data() + ids.size()) {}
+    
+    iterator begin() const { return iterator(base, first); }
+    iterator end() const { return iterator(base, last); }
+    size_t size() const { return static_cast<size_t>(last - first); }
+    bool empty() const { return first == last; }
+    const Book* operator[](size_t i) const { return base + first[i]; }
+};
+
+// 排行依据
+enum class RankKey {
+    Price,
+    Stock
+};
 
 class BookManager {
 private:
-    std::vector<std::shared_ptr<Book>> books;
+    std::vector<Book> books;    // 按值连续存放，不再逐本分配和维护引用计数
+    
+    // 书名 -> books下标列表 的二级索引（精确匹配）
+    typedef std::unordered_map<std::string, std::vector<size_t>> FieldIndex;
+    FieldIndex titleIndex;
+    
+    // 作者/出版社的二级索引：以驻留编号为下标的数组，查询时先把键换成编号
+    typedef std::vector<std::vector<size_t>> PoolIndex;
+    PoolIndex authorIndex;
+    PoolIndex publisherIndex;
+    
+    // 将第index本书加入/移出二级索引
+    void indexBook(size_t index);
+    void unindexBook(size_t index);
+    
+    // 删除第index本书后，二级索引中更靠后的下标整体前移一位
+    void shiftIndexesAfter(size_t index);
+    
+    // 在二级索引中按键查询
+    BookView lookup(const FieldIndex& index, const std::string& key) const;
+    BookView lookup(const PoolIndex& index, const StringPool& pool, const std::string& key) const;
+    
+    // 排行中第[offset, offset+limit)名的下标：只选出并排序需要的部分
+    std::vector<size_t> rankIndices(RankKey key, size_t offset, size_t limit) const;
+    
+    // 数值列：与books按下标一一对应的连续数组，统计时顺序扫描，不必逐本追指针
+    // 所有增删改都经过BookManager维护
+    std::vector<double> priceColumn;
+    std::vector<int> stockColumn;
+    
+    // 有序索引：(价格, ISBN) / (库存, ISBN)，随增删改增量维护
+    // 按价格/库存有序遍历和区间查询不必再排序整个书库
+    std::set<std::pair<double, IsbnKey>> priceOrder;
+    std::set<std::pair<int, IsbnKey>> stockOrder;
+    
+    // 补货索引：(库存 - 补货线, ISBN)，不大于0的前缀就是待补货图书
+    std::set<std::pair<int, IsbnKey>> reorderOrder;
+    std::vector<StockAlertListener*> alertListeners;
+    
+    // 修改后检查是否跨过补货线（wasLow为修改前是否不高于补货线），跨过时通知订阅者
+    void notifyReorder(const Book& book, bool wasLow) const;
+    
+    // 把有序索引中[first, last)范围内的图书按ISBN取出
+    template <typename Iterator>
+    std::vector<const Book*> collect(Iterator first, Iterator last) const;
+    
+    // 修改通知的订阅者（见StatsListener）
+    std::vector<StatsListener*> listeners;
+    
+    // 上次加载的快照已包含的销售日志序号（见SalesJournal）
+    uint64_t loadedJournalSeq;
+    
+    // 自上次保存/加载以来的修改，以及磁盘上的分段布局（segmentSize为0表示单文件存储）
+    mutable DirtyTracker dirty;
+    mutable SegmentedFile::Manifest segmentLayout;
+    
+    // ISBN -> books下标 的哈希索引（整数键），所有增删改操作都要同步维护
+    std::unordered_map<IsbnKey, size_t> isbnIndex;
+    
+    // 从指定下标开始重建ISBN索引（删除图书后下标会整体前移）
+    void rebuildIsbnIndex(size_t from = 0);
     
     // 检查ISBN是否已存在
-    bool isIsbnExists(const std::string& isbn) const;
+    bool isIsbnExists(IsbnKey isbn) const;
     
     // 根据ISBN查找图书索引
-    int findBookIndexByIsbn(const std::string& isbn) const;
+    int findBookIndexByIsbn(IsbnKey isbn) const;
 
 public:
     // 构造函数
@@ -30,29 +144,68 @@ public:
     // 根据ISBN删除图书
     bool deleteBook(const std::string& isbn);
     
+    // 同addBook/deleteBook，但不向控制台输出（多线程访问时在锁内调用）
+    // ISBN无效、已存在或不存在时返回false
+    bool insertBook(const Book& book);
+    bool removeBook(IsbnKey isbn);
+    
     // 根据ISBN更新图书信息
     bool updateBook(const std::string& isbn, const Book& newBook);
     
-    // 根据ISBN号查询图书
-    std::shared_ptr<Book> findBookByIsbn(const std::string& isbn) const;
+    // 根据ISBN号查询图书（ISBN是图书的稳定标识；返回的指针在下一次增删改后失效）
+    const Book* findBookByIsbn(const std::string& isbn) const;
+    const Book* findBookByIsbn(IsbnKey isbn) const;
     
     // 根据书名查询图书
-    std::vector<std::shared_ptr<Book>> findBooksByTitle(const std::string& title) const;
+    BookView findBooksByTitle(const std::string& title) const;
     
     // 根据作者查询图书
-    std::vector<std::shared_ptr<Book>> findBooksByAuthor(const std::string& author) const;
+    BookView findBooksByAuthor(const std::string& author) const;
     
     // 根据出版社查询图书
-    std::vector<std::shared_ptr<Book>> findBooksByPublisher(const std::string& publisher) const;
+    BookView findBooksByPublisher(const std::string& publisher) const;
+    
+    // 获取所有图书（只读引用，不复制；任何增删改都会使其中的引用失效）
+    const std::vector<Book>& getAllBooks() const { return books; }
+    
+    // 订阅/取消订阅修改通知
+    void addListener(StatsListener* listener);
+    void removeListener(StatsListener* listener);
+    
+    // 订阅/取消订阅补货提醒
+    void addAlertListener(StockAlertListener* listener);
+    void removeAlertListener(StockAlertListener* listener);
+    
+    // 价格列/库存列（下标与getAllBooks()一致）
+    const std::vector<double>& getPriceColumn() const { return priceColumn; }
+    const std::vector<int>& getStockColumn() const { return stockColumn; }
     
-    // 获取所有图书
-    std::vector<std::shared_ptr<Book>> getAllBooks() const { return books; }
+    // 排行榜（降序，相同时按加入顺序）：价格/库存最高的k本，O(n log k)
+    std::vector<const Book*> topKByPrice(size_t k) const;
+    std::vector<const Book*> topKByStock(size_t k) const;
+    
+    // 分页排行：第offset名起的limit本（从0开始计名次）
+    std::vector<const Book*> rankRange(RankKey key, size_t offset, size_t limit) const;
+    
+    // 按价格/库存有序的全部图书（遍历有序索引，不排序；相同时按ISBN）
+    std::vector<const Book*> getBooksOrderedBy(RankKey key, bool descending = false) const;
+    
+    // 区间查询（闭区间，结果按价格/库存升序），O(log n + k)
+    std::vector<const Book*> findBooksByPriceRange(double low, double high) const;
+    std::vector<const Book*> findBooksByStockRange(int low, int high) const;
+    
+    // 待补货图书：库存不高于"补货线 + margin"的图书，最紧缺的在前，O(log n + k)
+    std::vector<const Book*> getReorderList(int margin = 0) const;
+    
+    // 设置补货线
+    bool setReorderThreshold(const std::string& isbn, int threshold);
     
     // 获取图书数量
     int getBookCount() const { return books.size(); }
     
     // 更新库存（销售时使用）
     bool updateStock(const std::string& isbn, int quantity);
+    bool updateStock(IsbnKey isbn, int quantity);
     
     // 获取库存量
     int getStock(const std::string& isbn) const;
@@ -66,8 +219,24 @@ public:
     // 从文件加载图书
     bool loadFromFile(const std::string& filename);
     
-    // 保存图书到文件
-    bool saveToFile(const std::string& filename) const;
+    // 保存图书到文件；journalSeq非0时在首行记录快照对应的销售日志序号
+    bool saveToFile(const std::string& filename, uint64_t journalSeq = 0) const;
+    
+    // 按文件格式把全部数据写到输出流
+    void writeTo(std::ostream& out, uint64_t journalSeq = 0) const;
+    
+    // 分段保存：filename作为清单，只重写有修改的段
+    bool saveSegments(const std::string& filename, uint64_t journalSeq = 0) const;
+    
+    // 自上次保存/加载以来是否有修改
+    bool isDirty() const { return dirty.isDirty(); }
+    size_t getDirtyRecordCount() const { return dirty.getDirtyRecordCount(); }
+    
+    // 磁盘上是否为分段存储
+    bool isSegmented() const { return segmentLayout.segmentSize > 0; }
+    
+    // 获取上次加载的快照对应的销售日志序号
+    uint64_t getLoadedJournalSeq() const { return loadedJournalSeq; }
 };
 
 #endif // BOOKMANAGER_H
\ No newline at end of file
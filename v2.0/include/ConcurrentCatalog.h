@@ -0,0 +1,75 @@
+#ifndef CONCURRENTCATALOG_H
+#define CONCURRENTCATALOG_H
+
+#include "BookManager.h"
+#include "SalesManager.h"
+#include <shared_mutex>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+// 多线程访问书库和销售记录：一把读写锁同时保护两个管理器
+// 查询持共享锁，可以任意多个同时进行；修改（购买、进货、增删改、加载和保存）先取得修改锁，
+// 彼此串行，再对读写锁持独占锁修改内存。
+// 购买在修改锁下分两步：共享锁内校验并写日志（含落盘），与查询并行；独占锁内只扣减库存、追加记录。
+// 两步之间没有别的修改者，校验结果仍然有效，不会超卖。
+// 查询结果以副本返回，不把指针或视图带到锁外；临界区内不向控制台输出。
+// 启用后两个管理器的所有访问都应经由本类；统计管理器等订阅者在独占锁内收到通知
+class ConcurrentCatalog {
+private:
+    BookManager* bookManager;
+    SalesManager* salesManager;
+    mutable std::shared_mutex mutex;
+    std::mutex writerMutex;     // 修改者之间串行，先于mutex取得
+
+    // 禁止拷贝
+    ConcurrentCatalog(const ConcurrentCatalog&) = delete;
+    ConcurrentCatalog& operator=(const ConcurrentCatalog&) = delete;
+
+public:
+    // 构造函数（不接管两个管理器的所有权）
+    ConcurrentCatalog(BookManager* bm, SalesManager* sm);
+
+    // 在共享锁下执行只读操作：f(const BookManager&, const SalesManager&)
+    // f返回的指针、视图和引用在锁外无效，应返回副本
+    template <typename F>
+    auto read(F&& f) const {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return f(static_cast<const BookManager&>(*bookManager), static_cast<const SalesManager&>(*salesManager));
+    }
+
+    // 在独占锁下执行修改：f(BookManager&, SalesManager&)
+    // 保存也要经由这里（保存会清除修改标记）
+    template <typename F>
+    auto write(F&& f) {
+        std::lock_guard<std::mutex> writer(writerMutex);
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        return f(*bookManager, *salesManager);
+    }
+
+    // 购买（一篮多本，全部成功或全部不做；不向控制台输出）
+    PurchaseReceipt purchase(const std::vector<PurchaseLine>& lines);
+    bool purchaseBook(const std::string& isbn, int quantity);
+
+    // 进货：库存增加quantity
+    bool restock(const std::string& isbn, int quantity);
+
+    // 增删图书（不向控制台输出）
+    bool addBook(const Book& book);
+    bool deleteBook(const std::string& isbn);
+
+    // 查询（返回副本）
+    std::optional<Book> findBookByIsbn(const std::string& isbn) const;
+    int getStock(const std::string& isbn) const;
+    std::vector<Book> findBooksByTitle(const std::string& title) const;
+    std::vector<Book> findBooksByAuthor(const std::string& author) const;
+    std::vector<Book> findBooksByPublisher(const std::string& publisher) const;
+    std::vector<Book> findBooksByPriceRange(double low, double high) const;
+
+    // 销售汇总
+    size_t getSaleCount() const;
+    double getTotalSales() const;
+};
+
+#endif // CONCURRENTCATALOG_H
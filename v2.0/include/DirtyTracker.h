@@ -0,0 +1,47 @@
+#ifndef DIRTYTRACKER_H
+#define DIRTYTRACKER_H
+
+#include <vector>
+#include <cstddef>
+
+// 记录级与段级的修改标记
+// 数据按位置划分为固定大小的段，某条记录被修改时连同它所在的段一起标记为脏，
+// 保存时可以跳过干净的文件，分段模式下只重写脏段
+class DirtyTracker {
+private:
+    size_t segmentSize;
+    std::vector<bool> records;      // 每条记录自上次保存/加载后是否修改过
+    std::vector<bool> segments;     // 每段是否需要重写
+    size_t dirtyRecords;
+    bool dirty;                     // 是否有任何未保存的修改（删除导致的记录数变化也算）
+    
+    void markSegment(size_t segment);
+
+public:
+    static const size_t DEFAULT_SEGMENT_SIZE = 4096;
+    
+    explicit DirtyTracker(size_t segmentSize = DEFAULT_SEGMENT_SIZE);
+    
+    // 修改或新增了第index条记录
+    void markRecord(size_t index);
+    
+    // 删除等操作使[index, count)范围内的记录位置全部变化
+    void markFrom(size_t index, size_t count);
+    
+    // 整体替换（如清空）
+    void markAll(size_t count);
+    
+    // 保存或加载完成：共count条记录，全部视为干净
+    void reset(size_t count);
+    
+    bool isDirty() const { return dirty; }
+    bool isRecordDirty(size_t index) const { return index < records.size() && records[index]; }
+    bool isSegmentDirty(size_t segment) const { return segment < segments.size() && segments[segment]; }
+    size_t getDirtyRecordCount() const { return dirtyRecords; }
+    size_t getSegmentSize() const { return segmentSize; }
+    
+    // count条记录分成的段数
+    size_t segmentCount(size_t count) const { return (count + segmentSize - 1) / segmentSize; }
+};
+
+#endif // DIRTYTRACKER_H
@@ -3,12 +3,26 @@
 
 #include "BookManager.h"
 #include "SalesManager.h"
+#include "SalesJournal.h"
 #include <string>
+#include <thread>
 
 class FileManager {
 private:
     std::string booksFileName;
     std::string salesFileName;
+    
+    SalesJournal journal;       // 销售预写日志，文件名为"<销售文件>.journal"
+    uint64_t recoveredSeq;      // 加载时快照和日志中出现的最大序号
+    std::thread compactor;      // 后台快照压缩线程
+    bool segmentedMode;         // 分段存储：数据文件只是清单，保存时只重写有修改的段
+    
+    std::string journalFileName() const { return salesFileName + ".journal"; }
+    std::string rotatedJournalFileName() const { return salesFileName + ".journal.old"; }
+    
+    // 写两份快照，首行记录日志序号；销售汇总随后写入，失败时只给出警告（加载时会重建）
+    bool writeSnapshots(const std::string& booksText, const std::string& salesText,
+                        const std::string& rollupText) const;
 
 public:
     // 构造函数
@@ -22,22 +36,38 @@ public:
     void setBooksFileName(const std::string& filename) { booksFileName = filename; }
     void setSalesFileName(const std::string& filename) { salesFileName = filename; }
     
+    // 分段存储模式（大书库自动保存时只重写改动的段）
+    void setSegmentedMode(bool enabled) { segmentedMode = enabled; }
+    bool isSegmentedMode() const { return segmentedMode; }
+    
     // 获取文件名
     std::string getBooksFileName() const { return booksFileName; }
     std::string getSalesFileName() const { return salesFileName; }
     
-    // 保存所有数据
-    bool saveAllData(const BookManager* bookManager, const SalesManager* salesManager) const;
+    // 保存所有数据，未修改的文件直接跳过，成功后清空销售日志
+    bool saveAllData(const BookManager* bookManager, const SalesManager* salesManager);
+    
+    // 加载所有数据，并重放销售日志中快照之后的记录
+    bool loadAllData(BookManager* bookManager, SalesManager* salesManager);
+    
+    // 打开销售日志并挂接到销售管理器，此后购买只追加日志而不重写整个文件
+    bool enableJournal(SalesManager* salesManager,
+                       SalesJournal::SyncPolicy policy = SalesJournal::SyncPolicy::GroupCommit);
+    
+    // 轮换日志后在后台线程写快照，完成后删除旧日志
+    bool compactInBackground(const BookManager* bookManager, const SalesManager* salesManager);
     
-    // 加载所有数据
-    bool loadAllData(BookManager* bookManager, SalesManager* salesManager) const;
+    // 等待后台快照压缩结束
+    void waitForCompaction();
     
-    // 备份数据
-    bool backupData(const std::string& backupDir = "backup") const;
+    // 备份数据：按内存中的数据写完整的单文件快照（含分段存储的全部段和日志中的记录），
+    // 两个文件可以直接作为数据文件恢复
+    bool backupData(const BookManager* bookManager, const SalesManager* salesManager,
+                    const std::string& backupDir = "backup") const;
     
-    // 导出数据为CSV格式
-    bool exportBooksToCSV(const std::string& filename) const;
-    bool exportSalesToCSV(const std::string& filename) const;
+    // 按内存中的数据导出为CSV格式（包含日志中尚未写入快照的销售记录）
+    bool exportBooksToCSV(const BookManager* bookManager, const std::string& filename) const;
+    bool exportSalesToCSV(const SalesManager* salesManager, const std::string& filename) const;
 };
 
 #endif // FILEMANAGER_H
\ No newline at end of file
@@ -0,0 +1,61 @@
+#ifndef ISBNKEY_H
+#define ISBNKEY_H
+
+#include <string>
+#include <string_view>
+#include <iosfwd>
+#include <functional>
+#include <cstdint>
+
+// 压缩成64位整数的ISBN键，查找、哈希和比较都只比整数
+// - 13位数字（可带'-'或空格）按ISBN-13存数值；校验位正确的ISBN-10先换算成978开头的ISBN-13，
+//   因此同一本书的两种写法得到同一个键，保存时统一写成13位数字
+// - 其他不超过10个字符的书库内部编号（数字、字母和'-'）每字符6位打包，最高位置1以区分
+// - 两种都不是的文本（旧数据中的任意编号）原样驻留在进程内的池中，以池编号为键（isLegacy()），
+//   保存时写回原文，加载旧文件时不会丢记录；新录入的图书不接受这种编号
+// 同类键的大小顺序与原字符串的字典序一致（ISBN-13、旧编号、内部编号依次排列；旧编号之间按首次出现的顺序）
+class IsbnKey {
+private:
+    uint64_t value;     // 0表示无效
+
+    explicit IsbnKey(uint64_t v) : value(v) {}
+
+public:
+    IsbnKey() : value(0) {}
+
+    // 解析并规范化；不是ISBN或内部编号时返回旧编号键，只有默认构造的键无效
+    static IsbnKey parse(std::string_view text);
+
+    bool isValid() const { return value != 0; }
+
+    // 是否为原样保存的旧编号（既不是ISBN也不是内部编号）
+    bool isLegacy() const;
+
+    // 是否为13位数字形式的ISBN
+    bool isIsbn13() const;
+
+    // ISBN-13校验位是否正确（内部编号没有校验位，返回false）
+    bool hasValidChecksum() const;
+
+    uint64_t getValue() const { return value; }
+
+    // 规范化后的文本：13位数字、原来的内部编号或旧编号原文
+    std::string toString() const;
+
+    bool operator==(const IsbnKey& other) const { return value == other.value; }
+    bool operator!=(const IsbnKey& other) const { return value != other.value; }
+    bool operator<(const IsbnKey& other) const { return value < other.value; }
+
+    friend std::ostream& operator<<(std::ostream& os, const IsbnKey& key);
+};
+
+namespace std {
+    template <>
+    struct hash<IsbnKey> {
+        size_t operator()(const IsbnKey& key) const noexcept {
+            return std::hash<uint64_t>()(key.getValue());
+        }
+    };
+}
+
+#endif // ISBNKEY_H
@@ -0,0 +1,35 @@
+#ifndef PARALLELLOADER_H
+#define PARALLELLOADER_H
+
+#include "Book.h"
+#include "SaleRecord.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// 文本数据文件的并行加载器
+// 整块读入文件后按换行边界切成若干块，由工作线程并行解析，最后按原始行序合并
+// 首行恰好是"#journal N"时表示该快照已包含销售日志中序号不超过N的记录；其余各行都是数据，
+// 书名等字段以'#'开头也照常加载
+class ParallelLoader {
+private:
+    unsigned threadCount;   // 工作线程数
+    size_t minChunkSize;    // 每块的最小字节数，文件较小时不必拆得太碎
+
+public:
+    // threads为0时使用硬件并发数
+    explicit ParallelLoader(unsigned threads = 0, size_t minChunk = 1 << 20);
+    
+    unsigned getThreadCount() const { return threadCount; }
+    
+    // 加载图书文件（每行：书名|出版社|ISBN|作者|库存|价格）
+    bool loadBooks(const std::string& filename, std::vector<Book>& books,
+                   uint64_t* journalSeq = nullptr) const;
+    
+    // 加载销售记录文件（每行：ISBN|书名|数量|总价|销售时间）
+    bool loadSaleRecords(const std::string& filename,
+                         std::vector<SaleRecord>& records,
+                         uint64_t* journalSeq = nullptr) const;
+};
+
+#endif // PARALLELLOADER_H
@@ -0,0 +1,55 @@
+#ifndef RUNNINGSTATS_H
+#define RUNNINGSTATS_H
+
+#include "StatsListener.h"
+#include <map>
+#include <cstddef>
+
+// 增量维护的统计值：每次修改O(log k)（k为不同价格/库存值的个数），读取O(1)
+// 最值来自按值计数的有序表，删除当前最值的图书后能立即得到新的最值
+class RunningStats : public StatsListener {
+private:
+    size_t bookCount;
+    double priceSum;
+    double totalValue;          // Σ 价格×库存
+    long long stockSum;
+    std::map<double, size_t> priceCounts;   // 价格 -> 图书数
+    std::map<int, size_t> stockCounts;      // 库存 -> 图书数
+    
+    size_t saleCount;
+    int64_t salesCents;         // 销售额（分），与SalesManager一样精确累加
+    
+    template <typename T>
+    static void addValue(std::map<T, size_t>& counts, T value);
+    template <typename T>
+    static void removeValue(std::map<T, size_t>& counts, T value);
+
+public:
+    RunningStats();
+    
+    // StatsListener
+    void onBookAdded(double price, int stock) override;
+    void onBookRemoved(double price, int stock) override;
+    void onBooksCleared() override;
+    // 汇总值由融合内核一次扫描整列得到，只有计数表需要逐本登记
+    void onBooksLoaded(const double* prices, const int* stocks, size_t count) override;
+    void onSaleAdded(int64_t totalCents) override;
+    void onSalesCleared() override;
+    
+    size_t getBookCount() const { return bookCount; }
+    double getPriceSum() const { return priceSum; }
+    double getTotalValue() const { return totalValue; }
+    long long getStockSum() const { return stockSum; }
+    
+    // 书库为空时最值返回0
+    double getMinPrice() const { return priceCounts.empty() ? 0.0 : priceCounts.begin()->first; }
+    double getMaxPrice() const { return priceCounts.empty() ? 0.0 : priceCounts.rbegin()->first; }
+    int getMinStock() const { return stockCounts.empty() ? 0 : stockCounts.begin()->first; }
+    int getMaxStock() const { return stockCounts.empty() ? 0 : stockCounts.rbegin()->first; }
+    
+    size_t getSaleCount() const { return saleCount; }
+    int64_t getSalesCents() const { return salesCents; }
+    double getSalesTotal() const { return static_cast<double>(salesCents) / 100.0; }
+};
+
+#endif // RUNNINGSTATS_H
@@ -1,51 +1,50 @@
 #ifndef SALERECORD_H
 #define SALERECORD_H
 
+#include "IsbnKey.h"
+#include "StringPool.h"
+#include "Timestamp.h"
 #include <string>
-#include <ctime>
+#include <string_view>
+#include <cstdint>
 #include <iostream>
-#include <sstream>
-#include <iomanip>
 
+// 定长的销售记录：ISBN键、书名编号、数量、以分为单位的总价和微秒时间戳，不含任何堆上的字符串
+// 销售时间只在显示、保存和导出时才格式化成文本
 class SaleRecord {
 private:
-    std::string isbn;           // 图书ISBN号
-    std::string bookTitle;      // 图书标题
+    IsbnKey isbn;               // 图书ISBN号
+    int64_t saleTime;           // 销售时间（自1970年起的UTC微秒数）
+    int64_t totalCents;         // 总价格（分）
     int quantity;               // 销售数量
-    double totalPrice;          // 总价格
-    std::string saleTime;       // 销售时间
-    
-    // 获取当前时间字符串
-    std::string getCurrentTime() const;
+    StringPool::Id bookTitle;   // 图书标题（在titlePool()中的编号）
 
 public:
     // 构造函数
     SaleRecord();
-    SaleRecord(const std::string& isbn, const std::string& bookTitle, 
+    SaleRecord(IsbnKey isbn, const std::string& bookTitle, 
                int quantity, double price);
     
-    // 拷贝构造函数
-    SaleRecord(const SaleRecord& other);
-    
-    // 赋值运算符重载
-    SaleRecord& operator=(const SaleRecord& other);
+    // 所有销售记录共享的书名驻留池
+    static StringPool& titlePool();
     
-    // 析构函数
-    ~SaleRecord();
-    
-    // getter方法
-    std::string getIsbn() const { return isbn; }
-    std::string getBookTitle() const { return bookTitle; }
+    // getter方法（按ISBN筛选时比较getIsbnKey()，按时间筛选时比较getTimestamp()）
+    std::string getIsbn() const { return isbn.toString(); }
+    IsbnKey getIsbnKey() const { return isbn; }
+    std::string_view getBookTitle() const { return titlePool().get(bookTitle); }
     int getQuantity() const { return quantity; }
-    double getTotalPrice() const { return totalPrice; }
-    std::string getSaleTime() const { return saleTime; }
+    double getTotalPrice() const { return static_cast<double>(totalCents) / 100.0; }
+    int64_t getTotalCents() const { return totalCents; }
+    std::string getSaleTime() const { return Timestamp::format(saleTime); }
+    int64_t getTimestamp() const { return saleTime; }
     
-    // setter方法
-    void setIsbn(const std::string& i) { isbn = i; }
-    void setBookTitle(const std::string& t) { bookTitle = t; }
+    // setter方法（setSaleTime()解析"YYYY-MM-DD HH:MM:SS[.ffffff]"，格式不对时返回false且不修改）
+    void setIsbn(std::string_view i) { isbn = IsbnKey::parse(i); }
+    void setBookTitle(std::string_view t) { bookTitle = titlePool().intern(t); }
     void setQuantity(int q) { quantity = q; }
-    void setTotalPrice(double p) { totalPrice = p; }
-    void setSaleTime(const std::string& t) { saleTime = t; }
+    void setTotalPrice(double p);
+    bool setSaleTime(std::string_view t) { return Timestamp::parse(t, saleTime); }
+    void setTimestamp(int64_t micros) { saleTime = micros; }
     
     // 显示销售记录
     void display() const;
@@ -56,6 +55,9 @@ public:
     // 从字符串解析销售记录
     bool fromString(const std::string& str);
     
+    // 从一行文本（不含换行符）解析销售记录，供批量加载直接使用
+    bool parse(std::string_view line);
+    
     // 友元函数
     friend std::ostream& operator<<(std::ostream& os, const SaleRecord& record);
     friend std::istream& operator>>(std::istream& is, SaleRecord& record);
@@ -0,0 +1,106 @@
+#ifndef SALESJOURNAL_H
+#define SALESJOURNAL_H
+
+#include "SaleRecord.h"
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <chrono>
+#include <functional>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+// 销售预写日志（只追加）
+// 每次购买追加一帧：负载长度(u32) | CRC32C(u32) | 序号(u64) | 负载（SaleRecord::toString()）
+// 批量购买的多条记录以'\n'分隔放在同一帧里，整帧校验，恢复时要么全部重放要么全部丢弃
+// 快照文件首行记录"#journal 序号"，恢复时只重放序号更大的帧
+// GroupCommit策略下由后台线程在间隔到期时补一次fsync，之后没有新购买时记录也不会一直停在缓存里；
+// 各方法内部加锁，可与后台线程同时调用
+class SalesJournal {
+public:
+    // 落盘策略
+    enum class SyncPolicy {
+        None,           // 只写入操作系统缓存，进程崩溃不丢数据，掉电可能丢失
+        EveryRecord,    // 每条记录都fsync
+        GroupCommit     // 攒够一批或超过时间间隔再fsync（间隔到期时后台线程fsync）
+    };
+    
+    // 重放回调：序号 + 销售记录
+    typedef std::function<void(uint64_t, const SaleRecord&)> ReplayHandler;
+
+private:
+    std::string path;
+    FILE* file;
+    uint64_t lastSeq;           // 最后写入（或重放）的序号
+    SyncPolicy policy;
+    size_t groupSize;           // GroupCommit：攒够多少条fsync一次
+    std::chrono::milliseconds groupInterval;    // GroupCommit：最长间隔
+    size_t pending;             // 尚未fsync的记录数
+    std::chrono::steady_clock::time_point lastSync;
+    
+    // 保护以上状态；后台落盘线程在有未落盘的记录时等到间隔到期再fsync
+    mutable std::mutex mutex;
+    std::condition_variable wakeup;
+    std::thread flusher;
+    bool stopping;
+    
+    // 禁止拷贝
+    SalesJournal(const SalesJournal&) = delete;
+    SalesJournal& operator=(const SalesJournal&) = delete;
+    
+    // 调用方已持有mutex
+    bool flushToDisk();
+    
+    // 后台落盘线程的主循环；停止并等待它退出（调用方不能持有mutex）
+    void flushLoop();
+    void stopFlusher();
+    
+    // 追加一帧并按落盘策略处理
+    bool appendFrame(const std::string& payload, size_t records);
+
+public:
+    SalesJournal();
+    ~SalesJournal();
+    
+    // 打开日志用于追加；会截掉末尾不完整的帧，lastSeq至少为minSeq
+    bool open(const std::string& filename, uint64_t minSeq = 0);
+    void close();
+    bool isOpen() const { return file != nullptr; }
+    
+    // 设置落盘策略
+    void setSyncPolicy(SyncPolicy p, size_t batch = 32,
+                       std::chrono::milliseconds interval = std::chrono::milliseconds(50));
+    
+    // 追加一条销售记录，返回是否成功
+    bool append(const SaleRecord& record);
+    
+    // 把一批销售记录作为一帧追加（同一个序号），返回是否成功
+    bool appendBatch(const std::vector<SaleRecord>& records);
+    
+    // 立即把已追加的记录fsync到磁盘
+    bool sync();
+    
+    // 把当前日志改名为rotatedName并重新开始一个空日志（后台快照压缩用）
+    bool rotate(const std::string& rotatedName);
+    
+    // 清空日志（快照已经包含全部记录时使用）
+    bool truncate();
+    
+    uint64_t getLastSeq() const { return lastSeq; }
+    
+    // 已追加但尚未fsync的记录数
+    size_t getPendingCount() const;
+    const std::string& getPath() const { return path; }
+    
+    // 重放日志文件中序号大于afterSeq的帧，遇到损坏的帧即停止
+    // validBytes返回最后一个完整帧的结束位置；文件不存在视为空日志
+    static bool replay(const std::string& filename, uint64_t afterSeq, const ReplayHandler& handler,
+                       uint64_t* lastSeq = nullptr, uint64_t* validBytes = nullptr);
+    
+    // CRC32C校验
+    static uint32_t crc32c(const char* data, size_t length);
+};
+
+#endif // SALESJOURNAL_H
@@ -3,13 +3,155 @@
 
 #include "SaleRecord.h"
 #include "BookManager.h"
+#include "SalesJournal.h"
+#include "StatsListener.h"
+#include "SalesRollup.h"
 #include <vector>
-#include <memory>
+#include <unordered_map>
+#include <iosfwd>
+#include <iterator>
+#include <cstddef>
+#include <string_view>
+
+// 单个ISBN的销售汇总：随每次购买增量维护，加载时重建
+struct IsbnSales {
+    IsbnKey isbn;
+    int unitsSold;              // 累计销量
+    int64_t revenueCents;       // 累计销售额（分）
+    int64_t firstSaleTime;      // 最早/最近一次销售的时间戳（微秒）
+    int64_t lastSaleTime;
+    std::vector<size_t> records;    // 该ISBN的销售记录在全部记录中的下标（按追加顺序）
+    
+    double getRevenue() const { return static_cast<double>(revenueCents) / 100.0; }
+};
+
+// 批量购买中的一行
+struct PurchaseLine {
+    std::string isbn;
+    int quantity;
+};
+
+// 批量购买的结果：成功时lines与请求逐行对应，所有记录共用同一个销售时间；
+// 失败时书库和销售记录都没有任何改动，failedLine是第一条出问题的行
+struct PurchaseReceipt {
+    enum class Status { Ok, Empty, InvalidQuantity, BookNotFound, InsufficientStock, JournalFailed };
+    
+    struct Line {
+        IsbnKey isbn;
+        std::string_view title;     // 指向SaleRecord::titlePool()，与池同寿命
+        int quantity;
+        int64_t unitCents;
+        int64_t amountCents;
+    };
+    
+    Status status = Status::Ok;
+    size_t failedLine = 0;
+    std::vector<Line> lines;
+    int64_t totalCents = 0;
+    int64_t saleTime = 0;
+    
+    bool ok() const { return status == Status::Ok; }
+    double getTotal() const { return static_cast<double>(totalCents) / 100.0; }
+    
+    // 失败原因（成功时为"成功"）
+    const char* describe() const;
+};
+
+// 已校验并写入日志、尚未修改书库和销售记录的批量购买（见SalesManager::preparePurchase）
+struct PreparedPurchase {
+    PurchaseReceipt receipt;
+    std::vector<SaleRecord> records;
+    std::unordered_map<IsbnKey, int> demand;    // 每个ISBN的累计购买数量
+};
+
+// 按时间区间查询的结果视图：逐条迭代，不生成结果数组
+// 销售记录按时间有序时就是连续存储中的一段；否则经由按时间排序的下标表访问
+// 元素为const SaleRecord&；任何购买、加载或清空都会使已返回的视图失效
+class SaleRange {
+public:
+    class iterator {
+    private:
+        const SaleRecord* base;
+        const size_t* order;    // 为空时直接按位置访问
+        size_t pos;
+    
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef SaleRecord value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const SaleRecord* pointer;
+        typedef const SaleRecord& reference;
+        
+        iterator(const SaleRecord* b, const size_t* o, size_t p) : base(b), order(o), pos(p) {}
+        const SaleRecord& operator*() const { return base[order ? order[pos] : pos]; }
+        const SaleRecord* operator->() const { return &**this; }
+        iterator& operator++() { ++pos; return *this; }
+        bool operator==(const iterator& other) const { return pos == other.pos; }
+        bool operator!=(const iterator& other) const { return pos != other.pos; }
+    };
+
+private:
+    const SaleRecord* base;
+    const size_t* order;
+    size_t first;
+    size_t last;
+
+public:
+    SaleRange() : base(nullptr), order(nullptr), first(0), last(0) {}
+    SaleRange(const SaleRecord* b, const size_t* o, size_t f, size_t l) : base(b), order(o), first(f), last(l) {}
+    
+    iterator begin() const { return iterator(base, order, first); }
+    iterator end() const { return iterator(base, order, last); }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+    const SaleRecord& operator[](size_t i) const { return base[order ? order[first + i] : first + i]; }
+};
 
 class SalesManager {
 private:
-    std::vector<std::shared_ptr<SaleRecord>> saleRecords;
+    std::vector<SaleRecord> saleRecords;       // 按值连续存放，通常按销售时间有序
+    
+    // 按时间排序的下标表：只在出现时间早于已有记录的追加（日志重放、系统时钟回拨）后才建立，
+    // 为空表示saleRecords本身就按时间有序，时间区间查询直接在记录上二分查找
+    std::vector<size_t> timeOrder;
+    
+    // 把第index条记录放入时间顺序；deferred为真时乱序的下标只追加到表尾，由sortDeferredOrder统一排序
+    void orderRecord(size_t index, bool deferred = false);
+    
+    // 对批量恢复时追加到表尾的乱序下标排序，并与前面已有序的部分归并
+    void sortDeferredOrder();
+    
+    // 按ISBN的销售汇总与倒排表：isbnSales连续存放，salesIndex为ISBN到其下标的映射
+    std::vector<IsbnSales> isbnSales;
+    std::unordered_map<IsbnKey, size_t> salesIndex;
+    int64_t totalCents;        // 全部销售额（分）
+    
+    // 把第index条记录计入汇总
+    void indexRecord(size_t index);
+    
+    // 按现有记录重建汇总
+    void rebuildIndex();
+    
+    // 按时间分桶的预汇总：购买时更新，随销售数据保存到"<销售文件>.rollup"
+    SalesRollup rollup;
+    
+    // 按现有记录重建时间分桶汇总（出版社取当前书库中的值）
+    void rebuildRollup();
+    
+    // 售出时该书出版社的驻留编号（书库中没有这本书时为空字符串）
+    StringPool::Id publisherOf(IsbnKey isbn) const;
+    
     BookManager* bookManager;  // 指向图书管理器的指针
+    SalesJournal* journal;     // 销售预写日志（可为空）
+    uint64_t loadedJournalSeq; // 上次加载的快照对应的日志序号
+    std::vector<StatsListener*> listeners;  // 修改通知的订阅者
+    
+    // 追加一条记录并通知订阅者
+    void appendRecord(SaleRecord record, bool deferOrder = false);
+    
+    // 自上次保存/加载以来的修改，以及磁盘上的分段布局（销售记录只追加，通常只有最后一段变脏）
+    mutable DirtyTracker dirty;
+    mutable SegmentedFile::Manifest segmentLayout;
 
 public:
     // 构造函数
@@ -18,20 +160,70 @@ public:
     // 析构函数
     ~SalesManager();
     
-    // 购买图书
+    // 购买图书（单行的批量购买，结果输出到控制台）
     bool purchaseBook(const std::string& isbn, int quantity);
     
-    // 获取所有销售记录
-    std::vector<std::shared_ptr<SaleRecord>> getAllSaleRecords() const { return saleRecords; }
+    // 批量购买：先校验全部行（同一ISBN的多行合并检查库存），再把全部记录作为一帧写入日志，
+    // 最后扣减库存并追加记录；任何一行不通过则什么都不改。不向控制台输出
+    PurchaseReceipt purchaseBatch(const std::vector<PurchaseLine>& lines);
+    
+    // purchaseBatch的两步：preparePurchase只读书库和销售记录、只写日志，失败时prepared.receipt说明原因；
+    // commitPurchase扣减库存并追加记录。两步之间不能有其他修改，见ConcurrentCatalog::purchase
+    bool preparePurchase(const std::vector<PurchaseLine>& lines, PreparedPurchase& prepared);
+    PurchaseReceipt commitPurchase(PreparedPurchase& prepared);
+    
+    // 挂接销售日志：此后每次购买先追加日志再修改内存
+    void attachJournal(SalesJournal* j) { journal = j; }
+    SalesJournal* getJournal() const { return journal; }
+    
+    // 订阅/取消订阅修改通知
+    void addListener(StatsListener* listener);
+    void removeListener(StatsListener* listener);
+    
+    // 恢复时重放一条日志中的销售记录（不再写日志）
+    void restoreSaleRecord(const SaleRecord& record);
+    
+    // 一次重放多条日志记录：全部追加后只排序一次时间顺序，乱序记录多时不必逐条插入
+    void restoreSaleRecords(std::vector<SaleRecord> records);
+    
+    // 获取所有销售记录（只读引用，不复制；任何修改都会使其中的引用失效）
+    const std::vector<SaleRecord>& getAllSaleRecords() const { return saleRecords; }
     
-    // 根据ISBN获取销售记录
-    std::vector<std::shared_ptr<SaleRecord>> getSaleRecordsByIsbn(const std::string& isbn) const;
+    // 根据ISBN获取销售记录（按倒排表取出，O(命中数)；指向内部存储，购买或加载后失效）
+    std::vector<const SaleRecord*> getSaleRecordsByIsbn(const std::string& isbn) const;
+    std::vector<const SaleRecord*> getSaleRecordsByIsbn(IsbnKey isbn) const;
+    
+    // 某个ISBN的销售汇总，没有销售过时返回nullptr（购买或加载后失效）
+    const IsbnSales* getSalesByIsbn(const std::string& isbn) const;
+    const IsbnSales* getSalesByIsbn(IsbnKey isbn) const;
+    
+    // 全部有销售的ISBN的汇总（按首次销售的顺序）
+    const std::vector<IsbnSales>& getAllIsbnSales() const { return isbnSales; }
+    
+    // 畅销图书：按销量从高到低（同销量按销售额）取前limit种，O(种数)
+    std::vector<const IsbnSales*> getBestSellers(size_t limit) const;
+    
+    // 销售时间在[from, to)内的记录（微秒时间戳，按时间顺序），二分查找到区间两端，O(log n)
+    SaleRange getSaleRecordsBetween(int64_t from, int64_t to) const;
+    
+    // 同上，时间为本地时间"YYYY-MM-DD HH:MM:SS"；格式不对时返回空结果
+    SaleRange getSaleRecordsBetween(const std::string& from, const std::string& to) const;
+    
+    // 按时间分桶的销售汇总（按天/按月的销售额、按出版社的区间合计等）
+    const SalesRollup& getRollup() const { return rollup; }
+    
+    // 时间分桶汇总的附属文件名
+    static std::string rollupFileName(const std::string& filename) { return filename + ".rollup"; }
+    
+    // 把时间分桶汇总写到输出流（后台快照压缩时使用）
+    void writeRollupTo(std::ostream& out) const;
     
     // 获取销售记录数量
     int getSaleRecordCount() const { return saleRecords.size(); }
     
-    // 计算总销售额
-    double getTotalSales() const;
+    // 总销售额（增量维护，O(1)）
+    double getTotalSales() const { return static_cast<double>(totalCents) / 100.0; }
+    int64_t getTotalCents() const { return totalCents; }
     
     // 显示所有销售记录
     void displayAllSaleRecords() const;
@@ -42,8 +234,23 @@ public:
     // 从文件加载销售记录
     bool loadFromFile(const std::string& filename);
     
-    // 保存销售记录到文件
-    bool saveToFile(const std::string& filename) const;
+    // 保存销售记录到文件；journalSeq非0时在首行记录快照对应的日志序号
+    bool saveToFile(const std::string& filename, uint64_t journalSeq = 0) const;
+    
+    // 按文件格式把全部数据写到输出流
+    void writeTo(std::ostream& out, uint64_t journalSeq = 0) const;
+    
+    // 分段保存：filename作为清单，只重写有修改的段
+    bool saveSegments(const std::string& filename, uint64_t journalSeq = 0) const;
+    
+    // 自上次保存/加载以来是否有修改
+    bool isDirty() const { return dirty.isDirty(); }
+    
+    // 磁盘上是否为分段存储
+    bool isSegmented() const { return segmentLayout.segmentSize > 0; }
+    
+    // 获取上次加载的快照对应的日志序号
+    uint64_t getLoadedJournalSeq() const { return loadedJournalSeq; }
 };
 
 #endif // SALESMANAGER_H
\ No newline at end of file
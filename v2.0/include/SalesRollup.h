@@ -0,0 +1,85 @@
+#ifndef SALESROLLUP_H
+#define SALESROLLUP_H
+
+#include "SaleRecord.h"
+#include "StringPool.h"
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <iosfwd>
+
+// 按时间分桶的销售预汇总（小时/天/月三种粒度，时间按本地时区划分）
+// 每种粒度是一张按桶号排序的表，每个桶内有合计以及按ISBN、按出版社的哈希表；
+// 每次购买每种粒度更新一个桶，区间查询只访问区间内的桶，与销售记录的总数无关
+// 天和月的桶都能由小时桶推出，因此只持久化小时粒度，加载时再汇总成天和月
+class SalesRollup {
+public:
+    enum class Granularity { Hour, Day, Month };
+    
+    struct Totals {
+        int units = 0;              // 销量
+        int64_t revenueCents = 0;   // 销售额（分）
+        int sales = 0;              // 销售记录数
+        
+        double getRevenue() const { return static_cast<double>(revenueCents) / 100.0; }
+        void add(const Totals& other);
+    };
+    
+private:
+    struct Bucket {
+        Totals total;
+        std::unordered_map<IsbnKey, Totals> byIsbn;
+        std::unordered_map<StringPool::Id, Totals> byPublisher;
+    };
+    typedef std::map<int64_t, Bucket> Buckets;
+    static const int GRANULARITIES = 3;
+    
+    Buckets cubes[GRANULARITIES];   // 按Granularity的顺序，桶号 -> 桶
+    StringPool::Lease publisherLease;   // 存有出版社编号期间持有出版社驻留池
+    
+    const Buckets& cube(Granularity g) const { return cubes[static_cast<int>(g)]; }
+    
+    // 把某个小时桶里按ISBN/按出版社的一份合计计入三种粒度
+    void addIsbn(int64_t hour, IsbnKey isbn, const Totals& totals);
+    void addPublisher(int64_t hour, StringPool::Id publisher, const Totals& totals);
+
+public:
+    // 时间戳所在的桶号：本地时间自1970年起的小时数/天数/月数
+    static int64_t bucketOf(Granularity g, int64_t micros);
+    
+    // 某年某月的月桶号
+    static int64_t monthBucket(int year, unsigned month);
+    
+    // 桶的文字标签："2024-03-05 14时"、"2024-03-05"、"2024-03"
+    static std::string bucketLabel(Granularity g, int64_t bucket);
+    
+    // 计入一条销售记录（publisher为售出时该书出版社的驻留编号）
+    void add(const SaleRecord& record, StringPool::Id publisher);
+    
+    // 清空
+    void clear();
+    
+    // 桶号在[first, last]内的每个非空桶的合计（按时间顺序）
+    std::vector<std::pair<int64_t, Totals>> getSeries(Granularity g, int64_t first, int64_t last) const;
+    
+    // 桶号在[first, last]内的总合计
+    Totals getTotals(Granularity g, int64_t first, int64_t last) const;
+    
+    // 某个ISBN在[first, last]内的合计（逐桶查找，不扫描其他ISBN）
+    Totals getIsbnTotals(Granularity g, IsbnKey isbn, int64_t first, int64_t last) const;
+    
+    // [first, last]内按出版社的合计（按出版社名称排序）
+    std::vector<std::pair<std::string_view, Totals>> getTotalsByPublisher(Granularity g, int64_t first, int64_t last) const;
+    
+    // 持久化：首行"#rollup 记录数 总销售额(分)"，用于加载时判断与销售数据是否一致
+    void writeTo(std::ostream& out, size_t recordCount, int64_t totalCents) const;
+    bool saveToFile(const std::string& filename, size_t recordCount, int64_t totalCents) const;
+    
+    // 加载；文件不存在、格式错误或与销售数据不一致时返回false且保持为空，由调用方从销售记录重建
+    bool loadFromFile(const std::string& filename, size_t recordCount, int64_t totalCents);
+};
+
+#endif // SALESROLLUP_H
@@ -0,0 +1,51 @@
+#ifndef SEGMENTEDFILE_H
+#define SEGMENTEDFILE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <ostream>
+#include <functional>
+#include "AtomicFile.h"
+
+// 分段存储：主文件只是一份清单，数据按固定记录数分段存放在同目录的段文件中
+//
+//   #segments <每段记录数> <代数>
+//   #journal <日志序号>
+//   <第0段文件名>
+//   <第1段文件名>
+//   ...
+//
+// 只重写修改过的段：新段写入"<主文件>.seg<段号>.<代数>"，原子替换清单后再删除不再引用的旧段文件，
+// 清单替换前崩溃时旧清单和旧段文件都完好
+class SegmentedFile {
+public:
+    struct Manifest {
+        size_t segmentSize = 0;
+        uint64_t generation = 0;
+        uint64_t journalSeq = 0;
+        std::vector<std::string> segments;  // 段文件名（不含目录）
+        std::vector<std::string> retired;   // 清单改名后目录没能落盘时暂留的旧段文件，下次清单落盘后再删除
+    };
+    
+    // 写出[first, last)范围的记录
+    typedef std::function<void(size_t first, size_t last, std::ostream& out)> RangeWriter;
+    
+    // 读取清单，主文件不是清单时返回false
+    static bool readManifest(const std::string& filename, Manifest& manifest);
+    
+    // 段文件的完整路径
+    static std::string segmentPath(const std::string& filename, const std::string& segment);
+    
+    // 保存count条记录：manifest是当前磁盘上的布局（可为空），needsWrite判断某段是否需要重写
+    // 替换清单后manifest更新为新布局，rewritten返回实际重写的段数；结果同AtomicFile::commit()，
+    // 其中DirectorySyncFailed时旧段文件暂不删除（掉电后旧清单可能重新生效）
+    static AtomicFile::CommitResult save(const std::string& filename, size_t count, size_t segmentSize, uint64_t journalSeq,
+                     Manifest& manifest, const std::function<bool(size_t)>& needsWrite,
+                     const RangeWriter& writer, size_t* rewritten = nullptr);
+    
+    // 删除清单引用的全部段文件和暂留的旧段文件（改回单文件存储后调用）
+    static void removeSegments(const std::string& filename, const Manifest& manifest);
+};
+
+#endif // SEGMENTEDFILE_H
@@ -3,6 +3,7 @@
 
 #include "BookManager.h"
 #include "SalesManager.h"
+#include "RunningStats.h"
 #include <vector>
 #include <algorithm>
 #include <map>
@@ -11,22 +12,39 @@ class StatisticsManager {
 private:
     BookManager* bookManager;
     SalesManager* salesManager;
+    RunningStats running;       // 订阅两个管理器的修改通知，报告直接读取
+    
+    // 禁止拷贝（订阅关系不能复制）
+    StatisticsManager(const StatisticsManager&) = delete;
+    StatisticsManager& operator=(const StatisticsManager&) = delete;
 
 public:
     // 构造函数
     StatisticsManager(BookManager* bm, SalesManager* sm);
     
-    // 析构函数
+    // 析构函数（须先于两个管理器销毁）
     ~StatisticsManager();
     
     // 统计所有图书信息
     void printAllBooksInfo() const;
     
-    // 按价格排序统计（从高到低）
-    void printBooksSortedByPrice() const;
+    // 按价格排序统计（从高到低），只列出前limit本
+    void printBooksSortedByPrice(size_t limit = 20) const;
+    
+    // 按库存量排序统计（从多到少），只列出前limit本
+    void printBooksSortedByStock(size_t limit = 20) const;
+    
+    // 价格在[low, high]内的图书（按价格从低到高）
+    void printBooksInPriceRange(double low, double high) const;
+    
+    // 库存低于threshold册的图书（按库存从少到多）
+    void printLowStockBooks(int threshold) const;
     
-    // 按库存量排序统计（从多到少）
-    void printBooksSortedByStock() const;
+    // 待补货图书：库存不高于各自补货线的图书（最紧缺的在前）
+    void printReorderList() const;
+    
+    // 畅销图书：按销量从高到低列出前limit种
+    void printBestSellers(size_t limit = 10) const;
     
     // 按作者统计
     void printBooksByAuthor() const;
@@ -48,13 +66,20 @@ public:
     
     // 获取库存统计信息
     struct StockStats {
-        int totalBooks;     // 总图书种类数
-        int totalStock;     // 总库存量
-        int maxStock;       // 最大库存量
-        int minStock;       // 最小库存量
-        double avgStock;    // 平均库存量
+        int totalBooks;         // 总图书种类数
+        long long totalStock;   // 总库存量（各书库存之和可能超出int）
+        int maxStock;           // 最大库存量
+        int minStock;           // 最小库存量
+        double avgStock;        // 平均库存量
     };
     StockStats getStockStatistics() const;
+    
+    // 一致性检查：全量重算（融合内核扫描价格/库存列，逐条累加销售额），与增量维护的结果比较
+    bool verifyRunningStats() const;
+    
+private:
+    // 从增量维护的统计值读出价格统计和库存统计，O(1)
+    void computeStatistics(PriceStats& price, StockStats& stock) const;
 };
 
 #endif // STATISTICSMANAGER_H
\ No newline at end of file
@@ -0,0 +1,42 @@
+#ifndef STATSKERNELS_H
+#define STATSKERNELS_H
+
+#include <cstddef>
+
+// 价格/库存列的融合聚合内核：一次遍历同时算出统计报告需要的全部汇总值
+// 提供AVX2、SSE2和标量三种实现，运行时按CPU支持情况选择
+namespace StatsKernels {
+    // 一次遍历的汇总结果（count为0时其余字段均为0）
+    struct Aggregates {
+        size_t count;
+        double priceSum;
+        double priceMin;
+        double priceMax;
+        double totalValue;  // Σ 价格×库存
+        double stockSum;    // 库存以double累加，2^53以内精确
+        int stockMin;
+        int stockMax;
+    };
+    
+    enum class Kernel {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+    
+    // 当前CPU是否支持该实现
+    bool isSupported(Kernel kernel);
+    
+    // 当前CPU上最快的实现（首次调用时检测，之后缓存）
+    Kernel bestKernel();
+    
+    const char* kernelName(Kernel kernel);
+    
+    // 用最快的实现聚合
+    Aggregates aggregate(const double* price, const int* stock, size_t count);
+    
+    // 用指定实现聚合（不支持时退回标量实现），供测试和基准对比
+    Aggregates aggregateWith(Kernel kernel, const double* price, const int* stock, size_t count);
+}
+
+#endif // STATSKERNELS_H
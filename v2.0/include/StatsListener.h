@@ -0,0 +1,28 @@
+#ifndef STATSLISTENER_H
+#define STATSLISTENER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// 数据变化通知：BookManager/SalesManager在每次修改后回调，统计引擎据此增量维护汇总值
+// 修改一本书的价格或库存按"移除旧值 + 加入新值"通知
+class StatsListener {
+public:
+    virtual ~StatsListener() = default;
+    
+    virtual void onBookAdded(double price, int stock) = 0;
+    virtual void onBookRemoved(double price, int stock) = 0;
+    virtual void onBooksCleared() = 0;
+    
+    // 整体加载：书库清空后一次性给出全部图书的价格/库存列，默认逐本转为onBookAdded
+    virtual void onBooksLoaded(const double* prices, const int* stocks, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            onBookAdded(prices[i], stocks[i]);
+        }
+    }
+    
+    virtual void onSaleAdded(int64_t totalCents) = 0;   // 销售额以分为单位
+    virtual void onSalesCleared() = 0;
+};
+
+#endif // STATSLISTENER_H
@@ -0,0 +1,19 @@
+#ifndef STOCKALERTLISTENER_H
+#define STOCKALERTLISTENER_H
+
+#include "Book.h"
+
+// 补货提醒：某本书的修改使库存跨过补货线时由BookManager回调
+// 只在跨越的那一次修改时通知（加载文件和清空书库不通知）
+class StockAlertListener {
+public:
+    virtual ~StockAlertListener() = default;
+    
+    // 库存降到补货线及以下（包括新加入的图书本身就不高于补货线）
+    virtual void onReorderNeeded(const Book& book) = 0;
+    
+    // 补货或调高库存后重新高于补货线
+    virtual void onStockReplenished(const Book& book) { (void)book; }
+};
+
+#endif // STOCKALERTLISTENER_H
@@ -0,0 +1,95 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <shared_mutex>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// 字符串驻留池：相同内容只存一份，以32位编号引用
+// 字符数据按大块分配（arena），驻留后地址不再变化，编号和get()返回的视图在池的生命期内一直有效
+// intern()/find()可在多个线程中同时调用（并行加载时逐行驻留）；get()不加锁
+// 持有编号的对象通过acquire()/release()登记，没有持有者时resetIfUnused()释放全部内存
+class StringPool {
+public:
+    typedef uint32_t Id;
+    static constexpr Id NOT_FOUND = 0xFFFFFFFFu;
+    static constexpr Id EMPTY = 0;              // 空字符串预先驻留为0号
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+    static constexpr unsigned PAGE_BITS = 12;
+    static constexpr size_t PAGE_SIZE = size_t(1) << PAGE_BITS;
+    static constexpr size_t MAX_PAGES = 4096;   // 最多约1600万个不同的字符串
+
+    // 编号 -> 视图：固定大小的页，页本身只追加不搬动，读者无需加锁
+    std::unique_ptr<std::string_view[]> pages[MAX_PAGES];
+    size_t count;
+
+    // 字符数据所在的内存块；当前块剩余空间不足时再分配新块
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* cursor;
+    size_t remaining;
+    size_t bytes;
+
+    std::unordered_map<std::string_view, Id> ids;
+    mutable std::shared_mutex mutex;
+    std::atomic<size_t> users;
+
+    // 禁止拷贝（视图指向池内的内存块）
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+
+    // 把字符复制到内存块中
+    std::string_view store(std::string_view s);
+    
+    // 新增一个字符串（调用方已持有写锁且确认不存在）
+    Id insert(std::string_view s);
+
+public:
+    StringPool();
+
+    // 驻留字符串，返回其编号（已存在时返回原编号）
+    Id intern(std::string_view s);
+
+    // 查找已驻留的字符串，不存在时返回NOT_FOUND（不会新增）
+    Id find(std::string_view s) const;
+
+    // 编号对应的字符串
+    std::string_view get(Id id) const { return pages[id >> PAGE_BITS][id & (PAGE_SIZE - 1)]; }
+
+    // 不同字符串的个数（编号都小于该值）
+    size_t size() const;
+
+    // 内存块、编号页和哈希表占用的字节数（近似）
+    size_t memoryUsage() const;
+    
+    // 持有者登记：在取得第一个编号之前acquire()，不再使用任何编号和视图之后release()
+    void acquire() { users.fetch_add(1, std::memory_order_relaxed); }
+    void release() { users.fetch_sub(1, std::memory_order_release); }
+    
+    // 没有持有者时清空整个池（只保留0号空串）并返回true；此前get()得到的视图随之失效
+    bool resetIfUnused();
+    
+    // 持有凭证：按需登记为持有者，复制时各自登记，析构时自动注销
+    class Lease {
+    private:
+        StringPool* pool;
+    
+    public:
+        Lease() : pool(nullptr) {}
+        Lease(const Lease& other) : pool(nullptr) { if (other.pool) acquire(*other.pool); }
+        Lease& operator=(const Lease& other);
+        ~Lease() { release(); }
+        
+        void acquire(StringPool& p);    // 已持有时不重复登记
+        void release();
+        bool held() const { return pool != nullptr; }
+    };
+};
+
+#endif // STRINGPOOL_H
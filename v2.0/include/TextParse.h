@@ -0,0 +1,59 @@
+#ifndef TEXTPARSE_H
+#define TEXTPARSE_H
+
+#include <string_view>
+#include <charconv>
+#include <cstdint>
+
+// 以'|'分隔的文本记录的解析辅助函数
+// 手工切分字段 + std::from_chars，避免stringstream的区域设置与分配开销
+namespace TextParse {
+
+    // 去掉首尾空白（数值字段允许两侧带空格）
+    inline std::string_view trim(std::string_view s) {
+        while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+        while (!s.empty() && (s.back() == ' ' || s.back() == '\t' || s.back() == '\r')) s.remove_suffix(1);
+        return s;
+    }
+
+    // 取出下一个以'|'结尾的字段；找不到分隔符时返回false
+    inline bool nextField(std::string_view& rest, std::string_view& field) {
+        size_t pos = rest.find('|');
+        if (pos == std::string_view::npos) {
+            return false;
+        }
+        field = rest.substr(0, pos);
+        rest.remove_prefix(pos + 1);
+        return true;
+    }
+
+    // 取出下一个字段；没有分隔符时取剩余全部内容
+    inline std::string_view nextFieldOrRest(std::string_view& rest) {
+        std::string_view field;
+        if (!nextField(rest, field)) {
+            field = rest;
+            rest = std::string_view();
+        }
+        return field;
+    }
+
+    inline bool toInt(std::string_view s, int& value) {
+        s = trim(s);
+        auto result = std::from_chars(s.data(), s.data() + s.size(), value);
+        return result.ec == std::errc() && result.ptr == s.data() + s.size();
+    }
+
+    inline bool toInt(std::string_view s, int64_t& value) {
+        s = trim(s);
+        auto result = std::from_chars(s.data(), s.data() + s.size(), value);
+        return result.ec == std::errc() && result.ptr == s.data() + s.size();
+    }
+
+    inline bool toDouble(std::string_view s, double& value) {
+        s = trim(s);
+        auto result = std::from_chars(s.data(), s.data() + s.size(), value);
+        return result.ec == std::errc() && result.ptr == s.data() + s.size();
+    }
+}
+
+#endif // TEXTPARSE_H
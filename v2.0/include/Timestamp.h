@@ -0,0 +1,40 @@
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+// 时间戳：自1970-01-01 00:00:00 UTC起的微秒数
+// 只在显示、保存和导出时才格式化成本地时间"YYYY-MM-DD HH:MM:SS"（保存时带上微秒）；
+// 日期换算用纯整数算法，时区偏移按15分钟为单位在每个线程里缓存，批量格式化/解析几乎不调用localtime
+namespace Timestamp {
+
+    const int64_t MICROS_PER_SECOND = 1000000;
+
+    // 当前时间
+    int64_t nowMicros();
+
+    // 格式化为本地时间，写入out开始的19个字符（不含结尾的'\0'）
+    void formatTo(int64_t micros, char* out);
+
+    // 格式化为本地时间字符串
+    std::string format(int64_t micros);
+
+    // 保存用的完整精度：微秒部分不为0时在秒后追加".ffffff"
+    // 写入out开始的19或26个字符（不含结尾的'\0'），返回写入的字符数
+    const size_t PRECISE_LENGTH = 26;
+    size_t formatPreciseTo(int64_t micros, char* out);
+
+    // 解析本地时间"YYYY-MM-DD HH:MM:SS"，秒后可带1~6位小数（两侧允许空白）；格式不对时返回false
+    bool parse(std::string_view text, int64_t& micros);
+
+    // 本地时间自1970-01-01 00:00:00起的秒数（按小时/天/月分桶用）
+    int64_t toLocalSeconds(int64_t micros);
+
+    // 公历日期与距1970-01-01的天数互相换算
+    int64_t daysFromCivil(int64_t year, unsigned month, unsigned day);
+    void civilFromDays(int64_t days, int64_t& year, unsigned& month, unsigned& day);
+}
+
+#endif // TIMESTAMP_H
@@ -1,21 +1,27 @@
 #include "../include/Book.h"
+#include "../include/TextParse.h"
 #include <sstream>
 #include <iomanip>
+#include <utility>
 
 // 默认构造函数
-Book::Book() : title(""), publisher(""), isbn(""), author(""), stock(0), price(0.0) {}
+Book::Book()
+    : title(""), isbn(), publisher(StringPool::EMPTY), author(StringPool::EMPTY),
+      stock(0), price(0.0), reorderThreshold(0) {}
 
 // 带参数的构造函数
 Book::Book(const std::string& title, const std::string& publisher, 
            const std::string& isbn, const std::string& author, 
-           int stock, double price)
-    : title(title), publisher(publisher), isbn(isbn), author(author), 
-      stock(stock), price(price) {}
+           int stock, double price, int reorderThreshold)
+    : title(title), isbn(IsbnKey::parse(isbn)), publisher(publisherPool().intern(publisher)),
+      author(authorPool().intern(author)), stock(stock), price(price),
+      reorderThreshold(reorderThreshold) {}
 
 // 拷贝构造函数
 Book::Book(const Book& other)
-    : title(other.title), publisher(other.publisher), isbn(other.isbn),
-      author(other.author), stock(other.stock), price(other.price) {}
+    : PoolHolder(other), title(other.title), isbn(other.isbn), publisher(other.publisher),
+      author(other.author), stock(other.stock), price(other.price),
+      reorderThreshold(other.reorderThreshold) {}
 
 // 赋值运算符重载
 Book& Book::operator=(const Book& other) {
@@ -26,6 +32,27 @@ Book& Book::operator=(const Book& other) {
         author = other.author;
         stock = other.stock;
         price = other.price;
+        reorderThreshold = other.reorderThreshold;
+    }
+    return *this;
+}
+
+// 移动构造函数
+Book::Book(Book&& other) noexcept
+    : title(std::move(other.title)), isbn(other.isbn), publisher(other.publisher),
+      author(other.author), stock(other.stock), price(other.price),
+      reorderThreshold(other.reorderThreshold) {}
+
+// 移动赋值
+Book& Book::operator=(Book&& other) noexcept {
+    if (this != &other) {
+        title = std::move(other.title);
+        isbn = other.isbn;
+        publisher = other.publisher;
+        author = other.author;
+        stock = other.stock;
+        price = other.price;
+        reorderThreshold = other.reorderThreshold;
     }
     return *this;
 }
@@ -33,39 +60,84 @@ Book& Book::operator=(const Book& other) {
 // 析构函数
 Book::~Book() {}
 
+// 驻留池在首次使用时构造
+StringPool& Book::authorPool() {
+    static StringPool pool;
+    return pool;
+}
+
+StringPool& Book::publisherPool() {
+    static StringPool pool;
+    return pool;
+}
+
+void Book::releaseUnusedPools() {
+    authorPool().resetIfUnused();
+    publisherPool().resetIfUnused();
+}
+
+PoolHolder::PoolHolder() {
+    Book::authorPool().acquire();
+    Book::publisherPool().acquire();
+}
+
+PoolHolder::~PoolHolder() {
+    Book::authorPool().release();
+    Book::publisherPool().release();
+}
+
 // 显示图书信息
 void Book::display() const {
     std::cout << "====================================" << std::endl;
     std::cout << "书名: " << title << std::endl;
-    std::cout << "出版社: " << publisher << std::endl;
+    std::cout << "出版社: " << getPublisher() << std::endl;
     std::cout << "ISBN号: " << isbn << std::endl;
-    std::cout << "作者: " << author << std::endl;
+    std::cout << "作者: " << getAuthor() << std::endl;
     std::cout << "库存量: " << stock << std::endl;
     std::cout << "价格: ¥" << std::fixed << std::setprecision(2) << price << std::endl;
+    if (reorderThreshold > 0) {
+        std::cout << "补货线: " << reorderThreshold << std::endl;
+    }
     std::cout << "====================================" << std::endl;
 }
 
 // 获取图书信息的字符串表示
 std::string Book::toString() const {
     std::stringstream ss;
-    ss << title << "|" << publisher << "|" << isbn << "|" 
-       << author << "|" << stock << "|" << std::fixed << std::setprecision(2) << price;
+    ss << title << "|" << getPublisher() << "|" << isbn << "|" 
+       << getAuthor() << "|" << stock << "|" << std::fixed << std::setprecision(2) << price;
+    // 补货线为可选的第7个字段，未设置时不写，与旧文件格式保持一致
+    if (reorderThreshold > 0) {
+        ss << "|" << reorderThreshold;
+    }
     return ss.str();
 }
 
 // 从字符串解析图书信息
 bool Book::fromString(const std::string& str) {
-    std::stringstream ss(str);
-    std::string temp;
-    
-    if (!std::getline(ss, title, '|')) return false;
-    if (!std::getline(ss, publisher, '|')) return false;
-    if (!std::getline(ss, isbn, '|')) return false;
-    if (!std::getline(ss, author, '|')) return false;
-    if (!std::getline(ss, temp, '|')) return false;
-    stock = std::stoi(temp);
-    if (!(ss >> price)) return false;
+    return parse(str);
+}
+
+// 格式：书名|出版社|ISBN|作者|库存|价格[|补货线]（ISBN不是标准形式时按旧编号原样保留）
+bool Book::parse(std::string_view line) {
+    std::string_view fields[5];
+    for (auto& field : fields) {
+        if (!TextParse::nextField(line, field)) return false;
+    }
     
+    int newStock;
+    double newPrice;
+    if (!TextParse::toInt(fields[4], newStock)) return false;
+    if (!TextParse::toDouble(TextParse::nextFieldOrRest(line), newPrice)) return false;
+    int newThreshold = 0;
+    if (!line.empty() && !TextParse::toInt(line, newThreshold)) return false;
+    title.assign(fields[0]);
+    isbn = IsbnKey::parse(fields[2]);
+    publisher = publisherPool().intern(fields[1]);
+    author = authorPool().intern(fields[3]);
+    stock = newStock;
+    price = newPrice;
+    reorderThreshold = newThreshold;
     return true;
 }
 
@@ -1,136 +1,463 @@
 #include "../include/BookManager.h"
+#include "../include/ParallelLoader.h"
+#include "../include/AtomicFile.h"
 #include <fstream>
 #include <iostream>
 #include <algorithm>
+#include <iterator>
+#include <limits>
 
 // 构造函数
-BookManager::BookManager() {}
+BookManager::BookManager() : loadedJournalSeq(0) {}
 
 // 析构函数
 BookManager::~BookManager() {}
 
+// 订阅修改通知
+void BookManager::addListener(StatsListener* listener) {
+    listeners.push_back(listener);
+}
+
+// 取消订阅
+void BookManager::removeListener(StatsListener* listener) {
+    listeners.erase(std::remove(listeners.begin(), listeners.end(), listener), listeners.end());
+}
+
+// 订阅补货提醒
+void BookManager::addAlertListener(StockAlertListener* listener) {
+    alertListeners.push_back(listener);
+}
+
+// 取消订阅补货提醒
+void BookManager::removeAlertListener(StockAlertListener* listener) {
+    alertListeners.erase(std::remove(alertListeners.begin(), alertListeners.end(), listener), alertListeners.end());
+}
+
+// 跨过补货线时通知
+void BookManager::notifyReorder(const Book& book, bool wasLow) const {
+    bool isLow = book.getReorderMargin() <= 0;
+    if (isLow == wasLow) {
+        return;
+    }
+    for (auto* listener : alertListeners) {
+        if (isLow) {
+            listener->onReorderNeeded(book);
+        } else {
+            listener->onStockReplenished(book);
+        }
+    }
+}
+
 // 检查ISBN是否已存在
-bool BookManager::isIsbnExists(const std::string& isbn) const {
+bool BookManager::isIsbnExists(IsbnKey isbn) const {
     return findBookIndexByIsbn(isbn) != -1;
 }
 
 // 根据ISBN查找图书索引
-int BookManager::findBookIndexByIsbn(const std::string& isbn) const {
-    for (size_t i = 0; i < books.size(); ++i) {
-        if (books[i]->getIsbn() == isbn) {
-            return static_cast<int>(i);
+int BookManager::findBookIndexByIsbn(IsbnKey isbn) const {
+    auto it = isbnIndex.find(isbn);
+    if (it == isbnIndex.end()) {
+        return -1;
+    }
+    return static_cast<int>(it->second);
+}
+
+// 从指定下标开始重建ISBN索引
+void BookManager::rebuildIsbnIndex(size_t from) {
+    if (from == 0) {
+        isbnIndex.clear();
+        isbnIndex.reserve(books.size());
+    }
+    for (size_t i = from; i < books.size(); ++i) {
+        isbnIndex[books[i].getIsbnKey()] = i;
+    }
+}
+
+// 将第index本书加入二级索引
+void BookManager::indexBook(size_t index) {
+    const Book& book = books[index];
+    titleIndex[book.getTitle()].push_back(index);
+    auto addTo = [index](PoolIndex& poolIndex, StringPool::Id id) {
+        if (id >= poolIndex.size()) {
+            poolIndex.resize(id + 1);
+        }
+        poolIndex[id].push_back(index);
+    };
+    addTo(authorIndex, book.getAuthorId());
+    addTo(publisherIndex, book.getPublisherId());
+}
+
+// 将第index本书移出二级索引，列表为空时删除该键
+void BookManager::unindexBook(size_t index) {
+    auto removeFrom = [index](FieldIndex& fieldIndex, const std::string& key) {
+        auto it = fieldIndex.find(key);
+        if (it == fieldIndex.end()) {
+            return;
+        }
+        auto& list = it->second;
+        list.erase(std::remove(list.begin(), list.end(), index), list.end());
+        if (list.empty()) {
+            fieldIndex.erase(it);
         }
+    };
+    const Book& book = books[index];
+    removeFrom(titleIndex, book.getTitle());
+    auto removeId = [index](PoolIndex& poolIndex, StringPool::Id id) {
+        auto& list = poolIndex[id];
+        list.erase(std::remove(list.begin(), list.end(), index), list.end());
+    };
+    removeId(authorIndex, book.getAuthorId());
+    removeId(publisherIndex, book.getPublisherId());
+}
+
+// 删除第index本书后，二级索引中更靠后的下标前移一位
+void BookManager::shiftIndexesAfter(size_t index) {
+    auto shift = [index](std::vector<size_t>& list) {
+        for (size_t& id : list) {
+            if (id > index) {
+                --id;
+            }
+        }
+    };
+    for (auto& entry : titleIndex) {
+        shift(entry.second);
     }
-    return -1;
+    for (PoolIndex* poolIndex : {&authorIndex, &publisherIndex}) {
+        for (auto& list : *poolIndex) {
+            shift(list);
+        }
+    }
+}
+
+// 在二级索引中按键查询
+BookView BookManager::lookup(const FieldIndex& index, const std::string& key) const {
+    auto it = index.find(key);
+    if (it == index.end()) {
+        return BookView();
+    }
+    return BookView(books, it->second);
+}
+
+// 在以驻留编号为下标的索引中查询：池中没有该字符串时必然无匹配
+BookView BookManager::lookup(const PoolIndex& index, const StringPool& pool, const std::string& key) const {
+    StringPool::Id id = pool.find(key);
+    if (id >= index.size()) {
+        return BookView();
+    }
+    return BookView(books, index[id]);
+}
+
+// 在idx中选出第[offset, end)名并排好序（nth_element定位起点，partial_sort排需要的部分）
+template <typename Column>
+static void selectRange(std::vector<size_t>& idx, const Column& column, size_t offset, size_t end) {
+    auto higher = [&column](size_t a, size_t b) {
+        return column[a] > column[b] || (column[a] == column[b] && a < b);
+    };
+    if (offset > 0) {
+        std::nth_element(idx.begin(), idx.begin() + offset, idx.end(), higher);
+    }
+    std::partial_sort(idx.begin() + offset, idx.begin() + end, idx.end(), higher);
+    idx.resize(end);
+    idx.erase(idx.begin(), idx.begin() + offset);
+}
+
+// 排行中第[offset, offset+limit)名的下标（比较只读数值列）
+std::vector<size_t> BookManager::rankIndices(RankKey key, size_t offset, size_t limit) const {
+    size_t n = books.size();
+    if (offset >= n || limit == 0) {
+        return {};
+    }
+    size_t end = limit > n - offset ? n : offset + limit;
+    
+    std::vector<size_t> idx(n);
+    for (size_t i = 0; i < n; ++i) {
+        idx[i] = i;
+    }
+    if (key == RankKey::Price) {
+        selectRange(idx, priceColumn, offset, end);
+    } else {
+        selectRange(idx, stockColumn, offset, end);
+    }
+    return idx;
+}
+
+// 价格最高的k本
+std::vector<const Book*> BookManager::topKByPrice(size_t k) const {
+    return rankRange(RankKey::Price, 0, k);
+}
+
+// 库存最多的k本
+std::vector<const Book*> BookManager::topKByStock(size_t k) const {
+    return rankRange(RankKey::Stock, 0, k);
+}
+
+// 分页排行
+std::vector<const Book*> BookManager::rankRange(RankKey key, size_t offset, size_t limit) const {
+    std::vector<const Book*> result;
+    for (size_t i : rankIndices(key, offset, limit)) {
+        result.push_back(&books[i]);
+    }
+    return result;
+}
+
+// 把有序索引中[first, last)范围内的图书按ISBN取出
+template <typename Iterator>
+std::vector<const Book*> BookManager::collect(Iterator first, Iterator last) const {
+    std::vector<const Book*> result;
+    for (; first != last; ++first) {
+        result.push_back(&books[isbnIndex.at(first->second)]);
+    }
+    return result;
+}
+
+// 按价格/库存有序的全部图书
+std::vector<const Book*> BookManager::getBooksOrderedBy(RankKey key, bool descending) const {
+    if (key == RankKey::Price) {
+        return descending ? collect(priceOrder.rbegin(), priceOrder.rend())
+                          : collect(priceOrder.begin(), priceOrder.end());
+    }
+    return descending ? collect(stockOrder.rbegin(), stockOrder.rend())
+                      : collect(stockOrder.begin(), stockOrder.end());
+}
+
+// 价格在[low, high]内的图书
+std::vector<const Book*> BookManager::findBooksByPriceRange(double low, double high) const {
+    if (low > high) {
+        return {};
+    }
+    // 无效键是最小的ISBN；上界逐个前进即可，反正结果本身就要逐个取出
+    auto first = priceOrder.lower_bound(std::make_pair(low, IsbnKey()));
+    auto last = first;
+    while (last != priceOrder.end() && last->first <= high) {
+        ++last;
+    }
+    return collect(first, last);
+}
+
+// 库存在[low, high]内的图书
+std::vector<const Book*> BookManager::findBooksByStockRange(int low, int high) const {
+    if (low > high) {
+        return {};
+    }
+    auto first = stockOrder.lower_bound(std::make_pair(low, IsbnKey()));
+    auto last = high == std::numeric_limits<int>::max()
+                    ? stockOrder.end()
+                    : stockOrder.lower_bound(std::make_pair(high + 1, IsbnKey()));
+    return collect(first, last);
+}
+
+// 待补货图书
+std::vector<const Book*> BookManager::getReorderList(int margin) const {
+    auto last = margin == std::numeric_limits<int>::max()
+                    ? reorderOrder.end()
+                    : reorderOrder.lower_bound(std::make_pair(margin + 1, IsbnKey()));
+    return collect(reorderOrder.begin(), last);
+}
+
+// 设置补货线
+bool BookManager::setReorderThreshold(const std::string& isbn, int threshold) {
+    IsbnKey key = IsbnKey::parse(isbn);
+    int index = findBookIndexByIsbn(key);
+    if (index == -1) {
+        std::cout << "错误：该编号 " << isbn << " 不存在！" << std::endl;
+        return false;
+    }
+    
+    Book& book = books[index];
+    int oldMargin = book.getReorderMargin();
+    reorderOrder.erase(std::make_pair(oldMargin, key));
+    book.setReorderThreshold(threshold);
+    reorderOrder.emplace(book.getReorderMargin(), key);
+    dirty.markRecord(index);
+    notifyReorder(book, oldMargin <= 0);
+    return true;
 }
 
 // 添加图书
 bool BookManager::addBook(const Book& book) {
-    if (isIsbnExists(book.getIsbn())) {
-        std::cout << "错误：ISBN号 " << book.getIsbn() << " 已存在！" << std::endl;
+    IsbnKey key = book.getIsbnKey();
+    if (!key.isValid() || key.isLegacy()) {
+        std::cout << "错误：ISBN号格式无效！" << std::endl;
+        return false;
+    }
+    if (isIsbnExists(key)) {
+        std::cout << "错误：ISBN号 " << key << " 已存在！" << std::endl;
         return false;
     }
     
-    books.push_back(std::make_shared<Book>(book));
+    insertBook(book);
     std::cout << "图书添加成功！" << std::endl;
     return true;
 }
 
+// 添加图书（不输出）
+bool BookManager::insertBook(const Book& book) {
+    IsbnKey key = book.getIsbnKey();
+    if (!key.isValid() || key.isLegacy() || isIsbnExists(key)) {
+        return false;
+    }
+    
+    isbnIndex.emplace(key, books.size());
+    books.push_back(book);
+    priceColumn.push_back(book.getPrice());
+    stockColumn.push_back(book.getStock());
+    priceOrder.emplace(book.getPrice(), key);
+    stockOrder.emplace(book.getStock(), key);
+    reorderOrder.emplace(book.getReorderMargin(), key);
+    indexBook(books.size() - 1);
+    dirty.markRecord(books.size() - 1);
+    for (auto* listener : listeners) {
+        listener->onBookAdded(book.getPrice(), book.getStock());
+    }
+    notifyReorder(book, false);
+    return true;
+}
+
 // 根据ISBN删除图书
 bool BookManager::deleteBook(const std::string& isbn) {
-    int index = findBookIndexByIsbn(isbn);
-    if (index == -1) {
+    if (!removeBook(IsbnKey::parse(isbn))) {
         std::cout << "错误：该编号 " << isbn << " 不存在！" << std::endl;
         return false;
     }
+    std::cout << "图书删除成功！" << std::endl;
+    return true;
+}
+
+// 删除图书（不输出）
+bool BookManager::removeBook(IsbnKey key) {
+    int index = findBookIndexByIsbn(key);
+    if (index == -1) {
+        return false;
+    }
     
+    unindexBook(index);
+    shiftIndexesAfter(index);
+    for (auto* listener : listeners) {
+        listener->onBookRemoved(priceColumn[index], stockColumn[index]);
+    }
+    priceOrder.erase(std::make_pair(priceColumn[index], key));
+    stockOrder.erase(std::make_pair(stockColumn[index], key));
+    reorderOrder.erase(std::make_pair(books[index].getReorderMargin(), key));
+    isbnIndex.erase(key);
     books.erase(books.begin() + index);
-    std::cout << "图书删除成功！" << std::endl;
+    priceColumn.erase(priceColumn.begin() + index);
+    stockColumn.erase(stockColumn.begin() + index);
+    rebuildIsbnIndex(index);  // 被删除位置之后的图书下标都前移了一位
+    dirty.markFrom(index, books.size());
     return true;
 }
 
 // 根据ISBN更新图书信息
 bool BookManager::updateBook(const std::string& isbn, const Book& newBook) {
-    int index = findBookIndexByIsbn(isbn);
+    IsbnKey key = IsbnKey::parse(isbn);
+    IsbnKey newKey = newBook.getIsbnKey();
+    int index = findBookIndexByIsbn(key);
     if (index == -1) {
         std::cout << "错误：该编号 " << isbn << " 不存在！" << std::endl;
         return false;
     }
     
     // 如果新ISBN与旧ISBN不同，检查是否已存在
-    if (newBook.getIsbn() != isbn && isIsbnExists(newBook.getIsbn())) {
-        std::cout << "错误：新ISBN号 " << newBook.getIsbn() << " 已存在！" << std::endl;
+    if (!newKey.isValid() || (newKey.isLegacy() && newKey != key)) {
+        std::cout << "错误：新ISBN号格式无效！" << std::endl;
+        return false;
+    }
+    if (newKey != key && isIsbnExists(newKey)) {
+        std::cout << "错误：新ISBN号 " << newKey << " 已存在！" << std::endl;
         return false;
     }
     
-    *books[index] = newBook;
+    unindexBook(index);
+    for (auto* listener : listeners) {
+        listener->onBookRemoved(priceColumn[index], stockColumn[index]);
+        listener->onBookAdded(newBook.getPrice(), newBook.getStock());
+    }
+    priceOrder.erase(std::make_pair(priceColumn[index], key));
+    stockOrder.erase(std::make_pair(stockColumn[index], key));
+    int oldMargin = books[index].getReorderMargin();
+    reorderOrder.erase(std::make_pair(oldMargin, key));
+    if (newKey != key) {
+        isbnIndex.erase(key);
+        isbnIndex[newKey] = index;
+    }
+    books[index] = newBook;
+    priceColumn[index] = newBook.getPrice();
+    stockColumn[index] = newBook.getStock();
+    priceOrder.emplace(newBook.getPrice(), newKey);
+    stockOrder.emplace(newBook.getStock(), newKey);
+    reorderOrder.emplace(newBook.getReorderMargin(), newKey);
+    indexBook(index);
+    dirty.markRecord(index);
+    notifyReorder(books[index], oldMargin <= 0);
     std::cout << "图书信息更新成功！" << std::endl;
     return true;
 }
 
 // 根据ISBN号查询图书
-std::shared_ptr<Book> BookManager::findBookByIsbn(const std::string& isbn) const {
+const Book* BookManager::findBookByIsbn(const std::string& isbn) const {
+    return findBookByIsbn(IsbnKey::parse(isbn));
+}
+
+const Book* BookManager::findBookByIsbn(IsbnKey isbn) const {
     int index = findBookIndexByIsbn(isbn);
     if (index != -1) {
-        return books[index];
+        return &books[index];
     }
     return nullptr;
 }
 
 // 根据书名查询图书
-std::vector<std::shared_ptr<Book>> BookManager::findBooksByTitle(const std::string& title) const {
-    std::vector<std::shared_ptr<Book>> result;
-    for (const auto& book : books) {
-        if (book->getTitle() == title) {
-            result.push_back(book);
-        }
-    }
-    return result;
+BookView BookManager::findBooksByTitle(const std::string& title) const {
+    return lookup(titleIndex, title);
 }
 
 // 根据作者查询图书
-std::vector<std::shared_ptr<Book>> BookManager::findBooksByAuthor(const std::string& author) const {
-    std::vector<std::shared_ptr<Book>> result;
-    for (const auto& book : books) {
-        if (book->getAuthor() == author) {
-            result.push_back(book);
-        }
-    }
-    return result;
+BookView BookManager::findBooksByAuthor(const std::string& author) const {
+    return lookup(authorIndex, Book::authorPool(), author);
 }
 
 // 根据出版社查询图书
-std::vector<std::shared_ptr<Book>> BookManager::findBooksByPublisher(const std::string& publisher) const {
-    std::vector<std::shared_ptr<Book>> result;
-    for (const auto& book : books) {
-        if (book->getPublisher() == publisher) {
-            result.push_back(book);
-        }
-    }
-    return result;
+BookView BookManager::findBooksByPublisher(const std::string& publisher) const {
+    return lookup(publisherIndex, Book::publisherPool(), publisher);
 }
 
 // 更新库存（销售时使用）
 bool BookManager::updateStock(const std::string& isbn, int quantity) {
+    return updateStock(IsbnKey::parse(isbn), quantity);
+}
+
+bool BookManager::updateStock(IsbnKey isbn, int quantity) {
     int index = findBookIndexByIsbn(isbn);
     if (index == -1) {
         return false;
     }
     
-    int currentStock = books[index]->getStock();
+    int currentStock = books[index].getStock();
     if (currentStock + quantity < 0) {
         return false; // 库存不足
     }
     
-    books[index]->setStock(currentStock + quantity);
+    int oldMargin = books[index].getReorderMargin();
+    books[index].setStock(currentStock + quantity);
+    stockColumn[index] = currentStock + quantity;
+    stockOrder.erase(std::make_pair(currentStock, isbn));
+    stockOrder.emplace(currentStock + quantity, isbn);
+    reorderOrder.erase(std::make_pair(oldMargin, isbn));
+    reorderOrder.emplace(oldMargin + quantity, isbn);
+    for (auto* listener : listeners) {
+        listener->onBookRemoved(priceColumn[index], currentStock);
+        listener->onBookAdded(priceColumn[index], currentStock + quantity);
+    }
+    dirty.markRecord(index);
+    notifyReorder(books[index], oldMargin <= 0);
     return true;
 }
 
 // 获取库存量
 int BookManager::getStock(const std::string& isbn) const {
-    int index = findBookIndexByIsbn(isbn);
+    int index = findBookIndexByIsbn(IsbnKey::parse(isbn));
     if (index != -1) {
-        return books[index]->getStock();
+        return books[index].getStock();
     }
     return -1;
 }
@@ -138,6 +465,21 @@ int BookManager::getStock(const std::string& isbn) const {
 // 清空所有图书
 void BookManager::clear() {
     books.clear();
+    priceColumn.clear();
+    stockColumn.clear();
+    priceOrder.clear();
+    stockOrder.clear();
+    reorderOrder.clear();
+    isbnIndex.clear();
+    titleIndex.clear();
+    authorIndex.clear();
+    publisherIndex.clear();
+    dirty.markAll(0);
+    for (auto* listener : listeners) {
+        listener->onBooksCleared();
+    }
+    // 若这是最后一批图书，顺带释放驻留池中已无人引用的作者/出版社
+    Book::releaseUnusedPools();
 }
 
 // 显示所有图书
@@ -149,47 +491,177 @@ void BookManager::displayAllBooks() const {
     
     std::cout << "\n当前书库中的图书总数: " << books.size() << std::endl;
     for (const auto& book : books) {
-        book->display();
+        book.display();
     }
 }
 
-// 从文件加载图书
+// 从文件加载图书（分块并行解析，结果保持文件中的行序）
 bool BookManager::loadFromFile(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
+    std::vector<Book> loaded;
+    uint64_t journalSeq = 0;
+    SegmentedFile::Manifest manifest;
+    bool aligned = true;    // 各段记录数是否与段大小一致（否则下次保存全部重写）
+    bool segmented = SegmentedFile::readManifest(filename, manifest);
+    
+    // 文件都能打开时先清空旧数据再解析：旧图书析构后驻留池才能重置，反复加载不会让池无限增长
+    // 打不开时保持原有数据不变；只有打开后读取失败才会留下空书库
+    std::vector<std::string> paths;
+    if (segmented) {
+        for (const auto& segment : manifest.segments) {
+            paths.push_back(SegmentedFile::segmentPath(filename, segment));
+        }
+    } else {
+        paths.push_back(filename);
+    }
+    for (const auto& path : paths) {
+        if (!std::ifstream(path).is_open()) {
+            std::cout << "无法打开文件: " << path << std::endl;
+            return false;
+        }
+    }
+    clear();
+    
+    if (segmented) {
+        journalSeq = manifest.journalSeq;
+        for (size_t i = 0; i < manifest.segments.size(); ++i) {
+            std::vector<Book> part;
+            const std::string& path = paths[i];
+            if (!ParallelLoader().loadBooks(path, part)) {
+                std::cout << "无法打开文件: " << path << std::endl;
+                return false;
+            }
+            aligned = aligned && (i + 1 == manifest.segments.size() || part.size() == manifest.segmentSize);
+            std::move(part.begin(), part.end(), std::back_inserter(loaded));
+        }
+    } else if (!ParallelLoader().loadBooks(filename, loaded, &journalSeq)) {
         std::cout << "无法打开文件: " << filename << std::endl;
         return false;
     }
     
-    books.clear();
-    std::string line;
-    while (std::getline(file, line)) {
-        if (!line.empty()) {
-            Book book;
-            if (book.fromString(line)) {
-                books.push_back(std::make_shared<Book>(book));
-            }
+    loadedJournalSeq = journalSeq;
+    books.reserve(loaded.size());
+    priceColumn.reserve(loaded.size());
+    stockColumn.reserve(loaded.size());
+    int duplicates = 0;
+    int badChecksums = 0;
+    for (auto& book : loaded) {
+        // 借助索引在O(1)内剔除重复ISBN，保留第一次出现的记录
+        if (!isbnIndex.emplace(book.getIsbnKey(), books.size()).second) {
+            ++duplicates;
+            continue;
+        }
+        if (book.getIsbnKey().isIsbn13() && !book.getIsbnKey().hasValidChecksum()) {
+            ++badChecksums;
         }
+        priceColumn.push_back(book.getPrice());
+        stockColumn.push_back(book.getStock());
+        books.push_back(std::move(book));
+        indexBook(books.size() - 1);
+    }
+    // 统计值在整列就绪后一次性重算，不逐本通知
+    for (auto* listener : listeners) {
+        listener->onBooksLoaded(priceColumn.data(), stockColumn.data(), books.size());
+    }
+    
+    // 先排好序再整体构造有序索引：有序输入时逐个插入末尾，O(n log n)排序之外只需线性时间
+    std::vector<std::pair<double, IsbnKey>> prices;
+    std::vector<std::pair<int, IsbnKey>> stocks;
+    std::vector<std::pair<int, IsbnKey>> margins;
+    prices.reserve(books.size());
+    stocks.reserve(books.size());
+    margins.reserve(books.size());
+    for (size_t i = 0; i < books.size(); ++i) {
+        prices.emplace_back(priceColumn[i], books[i].getIsbnKey());
+        stocks.emplace_back(stockColumn[i], books[i].getIsbnKey());
+        margins.emplace_back(books[i].getReorderMargin(), books[i].getIsbnKey());
+    }
+    std::sort(prices.begin(), prices.end());
+    std::sort(stocks.begin(), stocks.end());
+    std::sort(margins.begin(), margins.end());
+    priceOrder.insert(prices.begin(), prices.end());
+    stockOrder.insert(stocks.begin(), stocks.end());
+    reorderOrder.insert(margins.begin(), margins.end());
+    
+    if (duplicates > 0 || manifest.segmentSize != dirty.getSegmentSize()) {
+        aligned = false;
+    }
+    if (!aligned) {
+        manifest.segmentSize = 0;
     }
+    segmentLayout = manifest;
+    dirty.reset(books.size());
     
-    file.close();
     std::cout << "从文件加载了 " << books.size() << " 本图书" << std::endl;
+    if (duplicates > 0) {
+        std::cout << "警告：跳过了 " << duplicates << " 条ISBN重复的记录" << std::endl;
+    }
+    if (badChecksums > 0) {
+        std::cout << "警告：" << badChecksums << " 本图书的ISBN校验位不正确" << std::endl;
+    }
     return true;
 }
 
+// 按文件格式输出全部数据；journalSeq非0时首行写"#journal N"
+void BookManager::writeTo(std::ostream& out, uint64_t journalSeq) const {
+    if (journalSeq > 0) {
+        out << "#journal " << journalSeq << '\n';
+    }
+    for (const auto& book : books) {
+        out << book.toString() << '\n';
+    }
+}
+
 // 保存图书到文件
-bool BookManager::saveToFile(const std::string& filename) const {
-    std::ofstream file(filename);
-    if (!file.is_open()) {
+bool BookManager::saveToFile(const std::string& filename, uint64_t journalSeq) const {
+    // 先写临时文件再改名覆盖，写到一半失败时原文件保持不变
+    AtomicFile file(filename);
+    if (!file.isOpen()) {
         std::cout << "无法创建文件: " << filename << std::endl;
         return false;
     }
     
-    for (const auto& book : books) {
-        file << book->toString() << std::endl;
+    writeTo(file.stream(), journalSeq);
+    AtomicFile::CommitResult result = file.commit();
+    if (result == AtomicFile::CommitResult::Failed) {
+        std::cout << "写入文件失败: " << filename << std::endl;
+        return false;
+    }
+    if (result == AtomicFile::CommitResult::DirectorySyncFailed) {
+        // 新文件已生效但掉电后可能变回旧文件：保留旧段文件和修改标记，下次保存时重写
+        std::cout << "警告：已写入 " << filename << "，但目录同步失败，掉电后可能恢复为上次保存的内容" << std::endl;
+        return false;
     }
     
-    file.close();
+    // 原来是分段存储时，清单已被单文件覆盖，删掉残留的段文件
+    SegmentedFile::removeSegments(filename, segmentLayout);
+    segmentLayout = SegmentedFile::Manifest();
+    dirty.reset(books.size());
     std::cout << "图书信息已保存到文件: " << filename << std::endl;
     return true;
+}
+
+// 分段保存图书
+bool BookManager::saveSegments(const std::string& filename, uint64_t journalSeq) const {
+    size_t rewritten = 0;
+    AtomicFile::CommitResult result = SegmentedFile::save(
+        filename, books.size(), dirty.getSegmentSize(), journalSeq, segmentLayout,
+        [this](size_t segment) { return dirty.isSegmentDirty(segment); },
+        [this](size_t first, size_t last, std::ostream& out) {
+            for (size_t i = first; i < last; ++i) {
+                out << books[i].toString() << '\n';
+            }
+        },
+        &rewritten);
+    if (result == AtomicFile::CommitResult::Failed) {
+        std::cout << "写入文件失败: " << filename << std::endl;
+        return false;
+    }
+    if (result == AtomicFile::CommitResult::DirectorySyncFailed) {
+        std::cout << "警告：已写入 " << filename << "，但目录同步失败，掉电后可能恢复为上次保存的内容" << std::endl;
+        return false;
+    }
+    
+    dirty.reset(books.size());
+    std::cout << "图书信息已分段保存到文件: " << filename << "（重写了 " << rewritten << " 段）" << std::endl;
+    return true;
 }
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "../include/ConcurrentCatalog.h"
+
+namespace {
+    // 把查询结果复制出来（视图中的指针在解锁后可能失效）
+    template <typename Range>
+    std::vector<Book> copyBooks(const Range& range) {
+        std::vector<Book> result;
+        result.reserve(range.size());
+        for (const Book* book : range) {
+            result.push_back(*book);
+        }
+        return result;
+    }
+}
+
+// 构造函数
+ConcurrentCatalog::ConcurrentCatalog(BookManager* bm, SalesManager* sm) : bookManager(bm), salesManager(sm) {}
+
+// 购买：校验和写日志只持共享锁，独占锁只用于修改内存
+PurchaseReceipt ConcurrentCatalog::purchase(const std::vector<PurchaseLine>& lines) {
+    std::lock_guard<std::mutex> writer(writerMutex);
+    PreparedPurchase prepared;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        if (!salesManager->preparePurchase(lines, prepared)) {
+            return prepared.receipt;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    return salesManager->commitPurchase(prepared);
+}
+
+bool ConcurrentCatalog::purchaseBook(const std::string& isbn, int quantity) {
+    return purchase({PurchaseLine{isbn, quantity}}).ok();
+}
+
+// 进货
+bool ConcurrentCatalog::restock(const std::string& isbn, int quantity) {
+    if (quantity <= 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> writer(writerMutex);
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    return bookManager->updateStock(isbn, quantity);
+}
+
+// 增删图书
+bool ConcurrentCatalog::addBook(const Book& book) {
+    std::lock_guard<std::mutex> writer(writerMutex);
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    return bookManager->insertBook(book);
+}
+
+bool ConcurrentCatalog::deleteBook(const std::string& isbn) {
+    IsbnKey key = IsbnKey::parse(isbn);
+    std::lock_guard<std::mutex> writer(writerMutex);
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    return bookManager->removeBook(key);
+}
+
+// 查询
+std::optional<Book> ConcurrentCatalog::findBookByIsbn(const std::string& isbn) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    const Book* book = bookManager->findBookByIsbn(isbn);
+    if (!book) {
+        return std::nullopt;
+    }
+    return *book;
+}
+
+int ConcurrentCatalog::getStock(const std::string& isbn) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return bookManager->getStock(isbn);
+}
+
+std::vector<Book> ConcurrentCatalog::findBooksByTitle(const std::string& title) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return copyBooks(bookManager->findBooksByTitle(title));
+}
+
+std::vector<Book> ConcurrentCatalog::findBooksByAuthor(const std::string& author) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return copyBooks(bookManager->findBooksByAuthor(author));
+}
+
+std::vector<Book> ConcurrentCatalog::findBooksByPublisher(const std::string& publisher) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return copyBooks(bookManager->findBooksByPublisher(publisher));
+}
+
+std::vector<Book> ConcurrentCatalog::findBooksByPriceRange(double low, double high) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return copyBooks(bookManager->findBooksByPriceRange(low, high));
+}
+
+// 销售汇总
+size_t ConcurrentCatalog::getSaleCount() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return salesManager->getAllSaleRecords().size();
+}
+
+double ConcurrentCatalog::getTotalSales() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return salesManager->getTotalSales();
+}
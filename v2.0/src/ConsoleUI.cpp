@@ -6,12 +6,22 @@
 #include "../include/StatisticsManager.h"
 #include "../include/FileManager.h"
 
+// 控制台补货提醒：库存跨过补货线时立即打印
+class ReorderNotice : public StockAlertListener {
+public:
+    void onReorderNeeded(const Book& book) override {
+        std::cout << "提醒：《" << book.getTitle() << "》库存 " << book.getStock()
+                  << " 册，已不高于补货线 " << book.getReorderThreshold() << " 册，请及时补货" << std::endl;
+    }
+};
+
 class ConsoleUI {
 private:
     BookManager* bookManager;
     SalesManager* salesManager;
     StatisticsManager* statisticsManager;
     FileManager* fileManager;
+    ReorderNotice reorderNotice;
     
     // 显示主菜单
     void displayMainMenu() {
@@ -57,13 +67,17 @@ private:
     void displayStatisticsMenu() {
         std::cout << "\n========== 统计查询 ==========" << std::endl;
         std::cout << "1. 显示所有图书" << std::endl;
-        std::cout << "2. 按价格排序统计" << std::endl;
-        std::cout << "3. 按库存量排序统计" << std::endl;
+        std::cout << "2. 按价格排序统计（前20名）" << std::endl;
+        std::cout << "3. 按库存量排序统计（前20名）" << std::endl;
         std::cout << "4. 按作者统计" << std::endl;
         std::cout << "5. 按出版社统计" << std::endl;
         std::cout << "6. 生成综合统计报告" << std::endl;
         std::cout << "7. 显示销售记录" << std::endl;
-        std::cout << "8. 返回主菜单" << std::endl;
+        std::cout << "8. 按价格区间查询" << std::endl;
+        std::cout << "9. 库存预警" << std::endl;
+        std::cout << "10. 待补货图书" << std::endl;
+        std::cout << "11. 畅销图书（前10名）" << std::endl;
+        std::cout << "12. 返回主菜单" << std::endl;
         std::cout << "==============================" << std::endl;
         std::cout << "请选择操作: ";
     }
@@ -71,7 +85,7 @@ private:
     // 添加图书
     void addBook() {
         std::string title, publisher, isbn, author;
-        int stock;
+        int stock, threshold;
         double price;
         
         std::cout << "\n请输入图书信息:" << std::endl;
@@ -85,6 +99,13 @@ private:
         std::cout << "ISBN号: ";
         std::getline(std::cin, isbn);
         
+        // 手工录入时校验：13位数字必须校验位正确（ISBN-10在解析时已校验）
+        IsbnKey key = IsbnKey::parse(isbn);
+        if (!key.isValid() || key.isLegacy() || (key.isIsbn13() && !key.hasValidChecksum())) {
+            std::cout << "错误：ISBN号无效或校验位不正确！" << std::endl;
+            return;
+        }
+        
         std::cout << "作者: ";
         std::getline(std::cin, author);
         
@@ -94,7 +115,10 @@ private:
         std::cout << "价格: ";
         std::cin >> price;
         
-        Book newBook(title, publisher, isbn, author, stock, price);
+        std::cout << "补货线（库存不高于此值时提醒）: ";
+        std::cin >> threshold;
+        
+        Book newBook(title, publisher, isbn, author, stock, price, threshold);
         if (bookManager->addBook(newBook)) {
             std::cout << "图书添加成功！" << std::endl;
         }
@@ -223,7 +247,12 @@ private:
         std::getline(std::cin, priceStr);
         price = priceStr.empty() ? book->getPrice() : std::stod(priceStr);
         
-        Book updatedBook(title, publisher, isbn, author, stock, price);
+        std::cout << "补货线 [" << book->getReorderThreshold() << "]: ";
+        std::string thresholdStr;
+        std::getline(std::cin, thresholdStr);
+        int threshold = thresholdStr.empty() ? book->getReorderThreshold() : std::stoi(thresholdStr);
+        
+        Book updatedBook(title, publisher, isbn, author, stock, price, threshold);
         if (bookManager->updateBook(isbn, updatedBook)) {
             std::cout << "图书信息更新成功！" << std::endl;
         }
@@ -267,6 +296,24 @@ private:
         }
     }
     
+    // 按价格区间查询
+    void showPriceRange() {
+        double low, high;
+        std::cout << "请输入最低价格: ";
+        std::cin >> low;
+        std::cout << "请输入最高价格: ";
+        std::cin >> high;
+        statisticsManager->printBooksInPriceRange(low, high);
+    }
+    
+    // 库存预警
+    void showLowStock() {
+        int threshold;
+        std::cout << "请输入库存预警线: ";
+        std::cin >> threshold;
+        statisticsManager->printLowStockBooks(threshold);
+    }
+    
     // 显示统计信息
     void showStatistics() {
         int choice;
@@ -298,6 +345,18 @@ private:
                     salesManager->displayAllSaleRecords();
                     break;
                 case 8:
+                    showPriceRange();
+                    break;
+                case 9:
+                    showLowStock();
+                    break;
+                case 10:
+                    statisticsManager->printReorderList();
+                    break;
+                case 11:
+                    statisticsManager->printBestSellers();
+                    break;
+                case 12:
                     return;
                 default:
                     std::cout << "无效的选择！" << std::endl;
@@ -326,13 +385,15 @@ public:
         salesManager = new SalesManager(bookManager);
         statisticsManager = new StatisticsManager(bookManager, salesManager);
         fileManager = new FileManager();
+        bookManager->addAlertListener(&reorderNotice);
     }
     
     // 析构函数
     ~ConsoleUI() {
+        delete statisticsManager;   // 统计引擎订阅了两个管理器，先销毁
+        bookManager->removeAlertListener(&reorderNotice);
         delete bookManager;
         delete salesManager;
-        delete statisticsManager;
         delete fileManager;
     }
     
@@ -346,6 +407,9 @@ public:
         std::cout << "正在加载数据..." << std::endl;
         fileManager->loadAllData(bookManager, salesManager);
         
+        // 之后的每笔销售先追加到日志，不必重写整个销售文件
+        fileManager->enableJournal(salesManager);
+        
         while (true) {
             displayMainMenu();
             std::cin >> choice;
@@ -0,0 +1,50 @@
+#include "../include/DirtyTracker.h"
+
+// 构造函数
+DirtyTracker::DirtyTracker(size_t size)
+    : segmentSize(size > 0 ? size : 1), dirtyRecords(0), dirty(false) {}
+
+void DirtyTracker::markSegment(size_t segment) {
+    if (segment >= segments.size()) {
+        segments.resize(segment + 1, false);
+    }
+    segments[segment] = true;
+}
+
+// 标记单条记录
+void DirtyTracker::markRecord(size_t index) {
+    if (index >= records.size()) {
+        records.resize(index + 1, false);
+    }
+    if (!records[index]) {
+        records[index] = true;
+        ++dirtyRecords;
+    }
+    markSegment(index / segmentSize);
+    dirty = true;
+}
+
+// 标记一段位置发生变化的记录
+void DirtyTracker::markFrom(size_t index, size_t count) {
+    for (size_t i = index; i < count; ++i) {
+        markRecord(i);
+    }
+    // 记录数减少时，原来最后一段可能整段消失，文件仍需重写
+    if (index < count || index % segmentSize != 0) {
+        markSegment(index / segmentSize);
+    }
+    dirty = true;
+}
+
+// 全部标记
+void DirtyTracker::markAll(size_t count) {
+    markFrom(0, count);
+}
+
+// 全部清除
+void DirtyTracker::reset(size_t count) {
+    records.assign(count, false);
+    segments.assign(segmentCount(count), false);
+    dirtyRecords = 0;
+    dirty = false;
+}
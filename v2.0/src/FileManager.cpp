@@ -1,36 +1,112 @@
 #include "../include/FileManager.h"
+#include "../include/AtomicFile.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <filesystem>
 #include <ctime>
+#include <iomanip>
+#include <algorithm>
 
 namespace fs = std::filesystem;
 
+namespace {
+    // 写一个CSV字段：含逗号、引号或换行时加引号，内部的引号写两次
+    void writeCsvField(std::ostream& out, std::string_view field) {
+        if (field.find_first_of(",\"\r\n") == std::string_view::npos) {
+            out << field;
+            return;
+        }
+        out << '"';
+        for (char c : field) {
+            if (c == '"') {
+                out << '"';
+            }
+            out << c;
+        }
+        out << '"';
+    }
+}
+
 // 构造函数
 FileManager::FileManager(const std::string& booksFile, const std::string& salesFile)
-    : booksFileName(booksFile), salesFileName(salesFile) {}
+    : booksFileName(booksFile), salesFileName(salesFile), recoveredSeq(0), segmentedMode(false) {}
 
 // 析构函数
-FileManager::~FileManager() {}
+FileManager::~FileManager() {
+    waitForCompaction();
+}
+
+// 写两份快照
+bool FileManager::writeSnapshots(const std::string& booksText, const std::string& salesText,
+                                 const std::string& rollupText) const {
+    bool success = true;
+    
+    // 改名后目录没能落盘时快照掉电后可能变回旧的，也按失败处理，旧日志留到下一次快照
+    auto writeSnapshot = [&success](const std::string& filename, const std::string& text, const char* name) {
+        AtomicFile file(filename);
+        auto result = file.isOpen() && (file.stream() << text) ? file.commit() : AtomicFile::CommitResult::Failed;
+        if (result == AtomicFile::CommitResult::Failed) {
+            std::cout << "警告：" << name << "保存失败！" << std::endl;
+            success = false;
+        } else if (result == AtomicFile::CommitResult::DirectorySyncFailed) {
+            std::cout << "警告：" << name << "已写入，但目录同步失败！" << std::endl;
+            success = false;
+        }
+    };
+    writeSnapshot(booksFileName, booksText, "图书数据");
+    writeSnapshot(salesFileName, salesText, "销售数据");
+    
+    AtomicFile rollupFile(SalesManager::rollupFileName(salesFileName));
+    if (success && (!rollupFile.isOpen() || !(rollupFile.stream() << rollupText)
+                    || rollupFile.commit() == AtomicFile::CommitResult::Failed)) {
+        std::cout << "警告：销售汇总保存失败！" << std::endl;
+    }
+    
+    return success;
+}
 
 // 保存所有数据
-bool FileManager::saveAllData(const BookManager* bookManager, const SalesManager* salesManager) const {
+bool FileManager::saveAllData(const BookManager* bookManager, const SalesManager* salesManager) {
+    waitForCompaction();
+    
+    // 快照包含到目前为止的全部日志记录
+    uint64_t seq = std::max(recoveredSeq, journal.getLastSeq());
     bool success = true;
     
+    // 文件存在、存储方式一致且内存中没有修改时跳过；跳过的文件首行序号较旧，
+    // 但它没有修改说明这期间的日志记录与它无关，恢复时重放也不会影响它
+    auto upToDate = [this](const std::string& filename, bool dirty, bool segmented) {
+        return !dirty && segmented == segmentedMode && fs::exists(filename);
+    };
+    
     // 保存图书数据
-    if (!bookManager->saveToFile(booksFileName)) {
+    if (upToDate(booksFileName, bookManager->isDirty(), bookManager->isSegmented())) {
+        std::cout << "图书数据未修改，跳过保存" << std::endl;
+    } else if (!(segmentedMode ? bookManager->saveSegments(booksFileName, seq)
+                               : bookManager->saveToFile(booksFileName, seq))) {
         std::cout << "警告：图书数据保存失败！" << std::endl;
         success = false;
     }
     
     // 保存销售数据
-    if (!salesManager->saveToFile(salesFileName)) {
+    if (upToDate(salesFileName, salesManager->isDirty(), salesManager->isSegmented())) {
+        std::cout << "销售数据未修改，跳过保存" << std::endl;
+    } else if (!(segmentedMode ? salesManager->saveSegments(salesFileName, seq)
+                               : salesManager->saveToFile(salesFileName, seq))) {
         std::cout << "警告：销售数据保存失败！" << std::endl;
         success = false;
     }
     
     if (success) {
+        // 快照已经包含全部日志记录，可以清空日志
+        std::error_code ec;
+        fs::remove(rotatedJournalFileName(), ec);
+        if (journal.isOpen()) {
+            journal.truncate();
+        } else {
+            fs::remove(journalFileName(), ec);
+        }
         std::cout << "所有数据保存成功！" << std::endl;
     }
     
@@ -38,7 +114,8 @@ bool FileManager::saveAllData(const BookManager* bookManager, const SalesManager
 }
 
 // 加载所有数据
-bool FileManager::loadAllData(BookManager* bookManager, SalesManager* salesManager) const {
+bool FileManager::loadAllData(BookManager* bookManager, SalesManager* salesManager) {
+    waitForCompaction();
     bool success = true;
     
     // 加载图书数据
@@ -53,6 +130,33 @@ bool FileManager::loadAllData(BookManager* bookManager, SalesManager* salesManag
         success = false;
     }
     
+    // 两份快照可能不是同时写成的，各自只补上自己缺少的日志记录
+    uint64_t booksSeq = bookManager->getLoadedJournalSeq();
+    uint64_t salesSeq = salesManager->getLoadedJournalSeq();
+    recoveredSeq = std::max(booksSeq, salesSeq);
+    std::vector<SaleRecord> replayed;   // 全部读完后一次交给销售管理器
+    auto apply = [&](uint64_t seq, const SaleRecord& record) {
+        if (seq > salesSeq) {
+            replayed.push_back(record);
+        }
+        if (seq > booksSeq) {
+            bookManager->updateStock(record.getIsbnKey(), -record.getQuantity());
+        }
+    };
+    
+    // 先重放轮换出去但尚未压缩完成的旧日志，再重放当前日志
+    journal.sync();
+    uint64_t lastSeq = 0;
+    SalesJournal::replay(rotatedJournalFileName(), std::min(booksSeq, salesSeq), apply, &lastSeq);
+    recoveredSeq = std::max(recoveredSeq, lastSeq);
+    SalesJournal::replay(journalFileName(), std::min(booksSeq, salesSeq), apply, &lastSeq);
+    recoveredSeq = std::max(recoveredSeq, lastSeq);
+    if (!replayed.empty()) {
+        size_t count = replayed.size();
+        salesManager->restoreSaleRecords(std::move(replayed));
+        std::cout << "从销售日志恢复了 " << count << " 条销售记录" << std::endl;
+    }
+    
     if (success) {
         std::cout << "所有数据加载成功！" << std::endl;
     }
@@ -60,8 +164,57 @@ bool FileManager::loadAllData(BookManager* bookManager, SalesManager* salesManag
     return success;
 }
 
-// 备份数据
-bool FileManager::backupData(const std::string& backupDir) const {
+// 打开销售日志
+bool FileManager::enableJournal(SalesManager* salesManager, SalesJournal::SyncPolicy policy) {
+    if (!journal.isOpen() && !journal.open(journalFileName(), recoveredSeq)) {
+        std::cout << "警告：无法打开销售日志: " << journalFileName() << std::endl;
+        return false;
+    }
+    journal.setSyncPolicy(policy);
+    salesManager->attachJournal(&journal);
+    return true;
+}
+
+// 后台快照压缩
+bool FileManager::compactInBackground(const BookManager* bookManager, const SalesManager* salesManager) {
+    // 分段存储本身只重写改动的段，直接同步保存即可
+    if (!journal.isOpen() || segmentedMode) {
+        return saveAllData(bookManager, salesManager);
+    }
+    waitForCompaction();
+    
+    // 上一次轮换出的旧日志还在时不再轮换，快照序号覆盖两份日志即可
+    if (!fs::exists(rotatedJournalFileName()) && !journal.rotate(rotatedJournalFileName())) {
+        std::cout << "警告：销售日志轮换失败！" << std::endl;
+        return false;
+    }
+    
+    // 在调用线程里生成快照文本，后台线程只负责写文件
+    uint64_t seq = std::max(recoveredSeq, journal.getLastSeq());
+    std::ostringstream booksText, salesText, rollupText;
+    bookManager->writeTo(booksText, seq);
+    salesManager->writeTo(salesText, seq);
+    salesManager->writeRollupTo(rollupText);
+    
+    compactor = std::thread([this, books = booksText.str(), sales = salesText.str(), rollup = rollupText.str()]() {
+        if (writeSnapshots(books, sales, rollup)) {
+            std::error_code ec;
+            fs::remove(rotatedJournalFileName(), ec);
+        }
+    });
+    return true;
+}
+
+// 等待后台快照压缩结束
+void FileManager::waitForCompaction() {
+    if (compactor.joinable()) {
+        compactor.join();
+    }
+}
+
+// 备份数据：按内存中的数据各写一份完整的单文件快照
+bool FileManager::backupData(const BookManager* bookManager, const SalesManager* salesManager,
+                             const std::string& backupDir) const {
     try {
         // 创建备份目录
         if (!fs::exists(backupDir)) {
@@ -75,20 +228,53 @@ bool FileManager::backupData(const std::string& backupDir) const {
         ss << std::put_time(&tm, "%Y%m%d_%H%M%S");
         std::string timestamp = ss.str();
         
-        // 备份图书文件
-        if (fs::exists(booksFileName)) {
-            std::string backupBooksFile = backupDir + "/books_" + timestamp + ".txt";
-            fs::copy_file(booksFileName, backupBooksFile);
-            std::cout << "图书数据已备份到: " << backupBooksFile << std::endl;
+        // 与保存时一样在首行记录日志序号：备份已包含目前为止的全部日志记录，
+        // 恢复后再重放同一份日志不会重复计入
+        uint64_t seq = std::max(recoveredSeq, journal.getLastSeq());
+        
+        // 备份图书数据
+        std::string backupBooksFile = backupDir + "/books_" + timestamp + ".txt";
+        AtomicFile booksFile(backupBooksFile);
+        if (!booksFile.isOpen()) {
+            std::cout << "备份失败：无法创建文件 " << backupBooksFile << std::endl;
+            return false;
         }
+        bookManager->writeTo(booksFile.stream(), seq);
+        AtomicFile::CommitResult booksResult = booksFile.commit();
+        if (booksResult == AtomicFile::CommitResult::Failed) {
+            std::cout << "备份失败：写入文件出错 " << backupBooksFile << std::endl;
+            return false;
+        }
+        std::cout << "图书数据已备份到: " << backupBooksFile << std::endl;
         
-        // 备份销售文件
-        if (fs::exists(salesFileName)) {
-            std::string backupSalesFile = backupDir + "/sales_" + timestamp + ".txt";
-            fs::copy_file(salesFileName, backupSalesFile);
-            std::cout << "销售数据已备份到: " << backupSalesFile << std::endl;
+        // 备份销售数据（汇总文件可以从销售记录重建，写入失败只给出警告）
+        std::string backupSalesFile = backupDir + "/sales_" + timestamp + ".txt";
+        AtomicFile salesFile(backupSalesFile);
+        if (!salesFile.isOpen()) {
+            std::cout << "备份失败：无法创建文件 " << backupSalesFile << std::endl;
+            return false;
+        }
+        salesManager->writeTo(salesFile.stream(), seq);
+        AtomicFile::CommitResult salesResult = salesFile.commit();
+        if (salesResult == AtomicFile::CommitResult::Failed) {
+            std::cout << "备份失败：写入文件出错 " << backupSalesFile << std::endl;
+            return false;
+        }
+        AtomicFile rollupFile(SalesManager::rollupFileName(backupSalesFile));
+        if (rollupFile.isOpen()) {
+            salesManager->writeRollupTo(rollupFile.stream());
         }
+        if (!rollupFile.isOpen() || rollupFile.commit() == AtomicFile::CommitResult::Failed) {
+            std::cout << "警告：销售汇总备份失败" << std::endl;
+        }
+        std::cout << "销售数据已备份到: " << backupSalesFile << std::endl;
         
+        // 备份文件都已写好，但目录没能落盘时掉电后可能丢失，不能当作已备份
+        if (booksResult == AtomicFile::CommitResult::DirectorySyncFailed
+            || salesResult == AtomicFile::CommitResult::DirectorySyncFailed) {
+            std::cout << "备份失败：备份文件已写入，但目录同步失败 " << backupDir << std::endl;
+            return false;
+        }
         return true;
     } catch (const std::exception& e) {
         std::cout << "备份失败: " << e.what() << std::endl;
@@ -96,62 +282,60 @@ bool FileManager::backupData(const std::string& backupDir) const {
     }
 }
 
-// 导出图书数据为CSV格式
-bool FileManager::exportBooksToCSV(const std::string& filename) const {
-    std::ifstream booksFile(booksFileName);
+// 导出图书数据为CSV格式（按内存中的书库）
+bool FileManager::exportBooksToCSV(const BookManager* bookManager, const std::string& filename) const {
     std::ofstream csvFile(filename);
-    
-    if (!booksFile.is_open() || !csvFile.is_open()) {
+    if (!csvFile.is_open()) {
         std::cout << "导出失败：无法打开文件" << std::endl;
         return false;
     }
     
-    // 写入CSV头
-    csvFile << "书名,出版社,ISBN,作者,库存量,价格" << std::endl;
-    
-    // 转换数据
-    std::string line;
-    while (std::getline(booksFile, line)) {
-        if (!line.empty()) {
-            // 将分隔符从|改为,
-            std::replace(line.begin(), line.end(), '|', ',');
-            csvFile << line << std::endl;
-        }
+    // 写入CSV头；补货线总是单独一列，未设置时为0
+    csvFile << "书名,出版社,ISBN,作者,库存量,价格,补货线\n";
+    for (const Book& book : bookManager->getAllBooks()) {
+        writeCsvField(csvFile, book.getTitle());
+        csvFile << ',';
+        writeCsvField(csvFile, book.getPublisher());
+        csvFile << ',';
+        writeCsvField(csvFile, book.getIsbn());
+        csvFile << ',';
+        writeCsvField(csvFile, book.getAuthor());
+        csvFile << ',' << book.getStock() << ',' << std::fixed << std::setprecision(2) << book.getPrice()
+                << ',' << book.getReorderThreshold() << '\n';
     }
     
-    booksFile.close();
     csvFile.close();
-    
+    if (!csvFile) {
+        std::cout << "导出失败：写入文件出错" << std::endl;
+        return false;
+    }
     std::cout << "图书数据已导出到CSV文件: " << filename << std::endl;
     return true;
 }
 
-// 导出销售数据为CSV格式
-bool FileManager::exportSalesToCSV(const std::string& filename) const {
-    std::ifstream salesFile(salesFileName);
+// 导出销售数据为CSV格式（按内存中的销售记录，包含只在日志中的记录）
+bool FileManager::exportSalesToCSV(const SalesManager* salesManager, const std::string& filename) const {
     std::ofstream csvFile(filename);
-    
-    if (!salesFile.is_open() || !csvFile.is_open()) {
+    if (!csvFile.is_open()) {
         std::cout << "导出失败：无法打开文件" << std::endl;
         return false;
     }
     
-    // 写入CSV头
-    csvFile << "ISBN,书名,销售数量,总价格,销售时间" << std::endl;
-    
-    // 转换数据
-    std::string line;
-    while (std::getline(salesFile, line)) {
-        if (!line.empty()) {
-            // 将分隔符从|改为,
-            std::replace(line.begin(), line.end(), '|', ',');
-            csvFile << line << std::endl;
-        }
+    csvFile << "ISBN,书名,销售数量,总价格,销售时间\n";
+    for (const SaleRecord& record : salesManager->getAllSaleRecords()) {
+        writeCsvField(csvFile, record.getIsbn());
+        csvFile << ',';
+        writeCsvField(csvFile, record.getBookTitle());
+        char time[Timestamp::PRECISE_LENGTH];
+        csvFile << ',' << record.getQuantity() << ',' << std::fixed << std::setprecision(2) << record.getTotalPrice()
+                << ',' << std::string_view(time, Timestamp::formatPreciseTo(record.getTimestamp(), time)) << '\n';
     }
     
-    salesFile.close();
     csvFile.close();
-    
+    if (!csvFile) {
+        std::cout << "导出失败：写入文件出错" << std::endl;
+        return false;
+    }
     std::cout << "销售数据已导出到CSV文件: " << filename << std::endl;
     return true;
 }
\ No newline at end of file
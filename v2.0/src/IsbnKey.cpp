@@ -0,0 +1,160 @@
+#include "../include/IsbnKey.h"
+#include "../include/StringPool.h"
+#include <ostream>
+
+namespace {
+    const uint64_t LOCAL_TAG = uint64_t(1) << 63;   // 内部编号的标记位
+    const uint64_t LEGACY_TAG = uint64_t(1) << 62;  // 旧编号的标记位（ISBN-13的数值远小于它）
+    const size_t LOCAL_MAX_LENGTH = 10;
+
+    // 内部编号的字符 -> 1..63，按ASCII顺序编码以保持字典序；不允许的字符返回0
+    unsigned encodeChar(char c) {
+        if (c == '-') return 1;
+        if (c >= '0' && c <= '9') return 2 + (c - '0');
+        if (c >= 'A' && c <= 'Z') return 12 + (c - 'A');
+        if (c >= 'a' && c <= 'z') return 38 + (c - 'a');
+        return 0;
+    }
+
+    char decodeChar(unsigned code) {
+        if (code == 1) return '-';
+        if (code < 12) return static_cast<char>('0' + (code - 2));
+        if (code < 38) return static_cast<char>('A' + (code - 12));
+        return static_cast<char>('a' + (code - 38));
+    }
+
+    // ISBN-13前12位对应的校验位
+    unsigned isbn13CheckDigit(const char* digits) {
+        unsigned sum = 0;
+        for (int i = 0; i < 12; ++i) {
+            sum += static_cast<unsigned>(digits[i] - '0') * (i % 2 == 0 ? 1 : 3);
+        }
+        return (10 - sum % 10) % 10;
+    }
+
+    // ISBN-10校验：加权和（权重10..1，末位X表示10）能被11整除
+    bool isbn10Valid(const char* digits) {
+        unsigned sum = 0;
+        for (int i = 0; i < 10; ++i) {
+            unsigned d = (i == 9 && (digits[i] == 'X' || digits[i] == 'x')) ? 10 : static_cast<unsigned>(digits[i] - '0');
+            sum += d * static_cast<unsigned>(10 - i);
+        }
+        return sum % 11 == 0;
+    }
+
+    bool isDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    // 旧编号的原文：进程内只增不减（键可能保存在任何地方，不能重置）
+    StringPool& legacyPool() {
+        static StringPool pool;
+        return pool;
+    }
+}
+
+// 解析ISBN或内部编号
+IsbnKey IsbnKey::parse(std::string_view text) {
+    // 先去掉分隔符，看是否是ISBN-13或ISBN-10
+    char digits[13];
+    size_t length = 0;
+    bool onlyIsbnChars = true;
+    for (char c : text) {
+        if (c == '-' || c == ' ') {
+            continue;
+        }
+        if (length == 13 || !(isDigit(c) || ((c == 'X' || c == 'x') && length == 9))) {
+            onlyIsbnChars = false;
+            break;
+        }
+        digits[length++] = c;
+    }
+
+    if (onlyIsbnChars && length == 13 && isDigit(digits[9])) {
+        uint64_t number = 0;
+        for (size_t i = 0; i < 13; ++i) {
+            number = number * 10 + static_cast<uint64_t>(digits[i] - '0');
+        }
+        return IsbnKey(number + 1);
+    }
+    if (onlyIsbnChars && length == 10 && isbn10Valid(digits)) {
+        // 978 + 前9位 + 重新计算的校验位
+        char isbn13[13] = {'9', '7', '8'};
+        for (int i = 0; i < 9; ++i) {
+            isbn13[3 + i] = digits[i];
+        }
+        isbn13[12] = static_cast<char>('0' + isbn13CheckDigit(isbn13));
+        uint64_t number = 0;
+        for (char c : isbn13) {
+            number = number * 10 + static_cast<uint64_t>(c - '0');
+        }
+        return IsbnKey(number + 1);
+    }
+
+    // 内部编号：原样按字符打包，左对齐，短的在低位补0
+    bool packable = !text.empty() && text.size() <= LOCAL_MAX_LENGTH;
+    uint64_t packed = 0;
+    for (size_t i = 0; packable && i < LOCAL_MAX_LENGTH; ++i) {
+        unsigned code = 0;
+        if (i < text.size()) {
+            code = encodeChar(text[i]);
+            packable = code != 0;
+        }
+        packed = (packed << 6) | code;
+    }
+    if (packable) {
+        return IsbnKey(LOCAL_TAG | packed);
+    }
+    
+    // 都不是：按原文驻留
+    return IsbnKey(LEGACY_TAG | legacyPool().intern(text));
+}
+
+bool IsbnKey::isIsbn13() const {
+    return value != 0 && value < LEGACY_TAG;
+}
+
+bool IsbnKey::isLegacy() const {
+    return (value & (LOCAL_TAG | LEGACY_TAG)) == LEGACY_TAG;
+}
+
+// 校验位检查
+bool IsbnKey::hasValidChecksum() const {
+    if (!isIsbn13()) {
+        return false;
+    }
+    std::string digits = toString();
+    return isbn13CheckDigit(digits.data()) == static_cast<unsigned>(digits[12] - '0');
+}
+
+// 还原成文本
+std::string IsbnKey::toString() const {
+    if (value == 0) {
+        return std::string();
+    }
+    if (isIsbn13()) {
+        std::string digits(13, '0');
+        uint64_t number = value - 1;
+        for (size_t i = 13; i-- > 0 && number > 0;) {
+            digits[i] = static_cast<char>('0' + number % 10);
+            number /= 10;
+        }
+        return digits;
+    }
+    if (isLegacy()) {
+        return std::string(legacyPool().get(static_cast<StringPool::Id>(value & ~LEGACY_TAG)));
+    }
+    std::string code;
+    for (size_t i = 0; i < LOCAL_MAX_LENGTH; ++i) {
+        unsigned c = static_cast<unsigned>((value >> (6 * (LOCAL_MAX_LENGTH - 1 - i))) & 63);
+        if (c == 0) {
+            break;
+        }
+        code.push_back(decodeChar(c));
+    }
+    return code;
+}
+
+std::ostream& operator<<(std::ostream& os, const IsbnKey& key) {
+    return os << key.toString();
+}
@@ -0,0 +1,160 @@
+#include "../include/ParallelLoader.h"
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <charconv>
+#include <system_error>
+#include <iterator>
+
+namespace {
+    // 以大块读取整个文件
+    bool readWholeFile(const std::string& filename, std::string& buffer) {
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+        file.seekg(0, std::ios::end);
+        std::streamoff size = file.tellg();
+        file.seekg(0, std::ios::beg);
+        if (size < 0) {
+            return false;
+        }
+        
+        buffer.resize(static_cast<size_t>(size));
+        const size_t blockSize = 8 << 20;
+        size_t done = 0;
+        while (done < buffer.size()) {
+            size_t n = std::min(blockSize, buffer.size() - done);
+            if (!file.read(&buffer[done], static_cast<std::streamsize>(n))) {
+                return false;
+            }
+            done += n;
+        }
+        return true;
+    }
+    
+    // 解析首行的"#journal N"标记：整行恰好是该格式时返回true并从data中去掉这一行
+    bool takeJournalMark(std::string_view& data, uint64_t& seq) {
+        const std::string_view prefix = "#journal ";
+        size_t newline = data.find('\n');
+        std::string_view line = data.substr(0, newline);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (line.substr(0, prefix.size()) != prefix) {
+            return false;
+        }
+        line.remove_prefix(prefix.size());
+        auto result = std::from_chars(line.data(), line.data() + line.size(), seq);
+        if (line.empty() || result.ec != std::errc() || result.ptr != line.data() + line.size()) {
+            return false;
+        }
+        data.remove_prefix(newline == std::string_view::npos ? data.size() : newline + 1);
+        return true;
+    }
+    
+    // 按换行边界把缓冲区切成大致均匀的若干块
+    std::vector<std::string_view> splitChunks(std::string_view data, size_t targetSize) {
+        std::vector<std::string_view> chunks;
+        while (!data.empty()) {
+            size_t cut = std::min(targetSize, data.size());
+            size_t newline = data.find('\n', cut > 0 ? cut - 1 : 0);
+            cut = (newline == std::string_view::npos) ? data.size() : newline + 1;
+            chunks.push_back(data.substr(0, cut));
+            data.remove_prefix(cut);
+        }
+        return chunks;
+    }
+    
+    // 逐行解析一块数据（跳过空行与解析失败的行）
+    template <typename T>
+    void parseChunk(std::string_view chunk, std::vector<T>& out) {
+        while (!chunk.empty()) {
+            size_t newline = chunk.find('\n');
+            std::string_view line = chunk.substr(0, newline);
+            chunk.remove_prefix(newline == std::string_view::npos ? chunk.size() : newline + 1);
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (line.empty()) {
+                continue;
+            }
+            T item;
+            if (item.parse(line)) {
+                out.push_back(std::move(item));
+            }
+        }
+    }
+    
+    // 工作线程从共享计数器领取数据块，结果按块号存放，最后按序合并
+    template <typename T>
+    bool loadParallel(const std::string& filename, unsigned threads, size_t minChunk,
+                      std::vector<T>& result, uint64_t* journalSeq) {
+        std::string buffer;
+        if (!readWholeFile(filename, buffer)) {
+            return false;
+        }
+        std::string_view data(buffer);
+        uint64_t seq = 0;
+        if (!takeJournalMark(data, seq)) {
+            seq = 0;
+        }
+        if (journalSeq) {
+            *journalSeq = seq;
+        }
+        
+        size_t target = std::max(minChunk, data.size() / (static_cast<size_t>(threads) * 4) + 1);
+        std::vector<std::string_view> chunks = splitChunks(data, target);
+        std::vector<std::vector<T>> parsed(chunks.size());
+        
+        std::atomic<size_t> next(0);
+        auto worker = [&]() {
+            for (size_t i = next++; i < chunks.size(); i = next++) {
+                parseChunk(chunks[i], parsed[i]);
+            }
+        };
+        
+        unsigned workers = static_cast<unsigned>(std::min<size_t>(threads, chunks.size()));
+        std::vector<std::thread> pool;
+        for (unsigned t = 1; t < workers; ++t) {
+            pool.emplace_back(worker);
+        }
+        worker();   // 当前线程也参与解析
+        for (auto& thread : pool) {
+            thread.join();
+        }
+        
+        size_t total = 0;
+        for (const auto& part : parsed) {
+            total += part.size();
+        }
+        result.clear();
+        result.reserve(total);
+        for (auto& part : parsed) {
+            std::move(part.begin(), part.end(), std::back_inserter(result));
+        }
+        return true;
+    }
+}
+
+// 构造函数
+ParallelLoader::ParallelLoader(unsigned threads, size_t minChunk)
+    : threadCount(threads), minChunkSize(std::max<size_t>(minChunk, 1)) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+// 加载图书文件
+bool ParallelLoader::loadBooks(const std::string& filename,
+                               std::vector<Book>& books, uint64_t* journalSeq) const {
+    return loadParallel(filename, threadCount, minChunkSize, books, journalSeq);
+}
+
+// 加载销售记录文件
+bool ParallelLoader::loadSaleRecords(const std::string& filename,
+                                     std::vector<SaleRecord>& records,
+                                     uint64_t* journalSeq) const {
+    return loadParallel(filename, threadCount, minChunkSize, records, journalSeq);
+}
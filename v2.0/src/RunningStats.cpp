@@ -0,0 +1,75 @@
+#include "../include/RunningStats.h"
+#include "../include/StatsKernels.h"
+
+// 构造函数
+RunningStats::RunningStats()
+    : bookCount(0), priceSum(0.0), totalValue(0.0), stockSum(0), saleCount(0), salesCents(0) {}
+
+template <typename T>
+void RunningStats::addValue(std::map<T, size_t>& counts, T value) {
+    ++counts[value];
+}
+
+template <typename T>
+void RunningStats::removeValue(std::map<T, size_t>& counts, T value) {
+    auto it = counts.find(value);
+    if (it != counts.end() && --it->second == 0) {
+        counts.erase(it);
+    }
+}
+
+void RunningStats::onBookAdded(double price, int stock) {
+    ++bookCount;
+    priceSum += price;
+    totalValue += price * stock;
+    stockSum += stock;
+    addValue(priceCounts, price);
+    addValue(stockCounts, stock);
+}
+
+void RunningStats::onBookRemoved(double price, int stock) {
+    --bookCount;
+    priceSum -= price;
+    totalValue -= price * stock;
+    stockSum -= stock;
+    removeValue(priceCounts, price);
+    removeValue(stockCounts, stock);
+    
+    // 书库清空时把浮点累计误差一并清零
+    if (bookCount == 0) {
+        onBooksCleared();
+    }
+}
+
+void RunningStats::onBooksCleared() {
+    bookCount = 0;
+    priceSum = 0.0;
+    totalValue = 0.0;
+    stockSum = 0;
+    priceCounts.clear();
+    stockCounts.clear();
+}
+
+// 整体加载：求和交给SIMD内核，计数表仍按值登记（不同值的个数通常远小于图书数）
+void RunningStats::onBooksLoaded(const double* prices, const int* stocks, size_t count) {
+    onBooksCleared();
+    StatsKernels::Aggregates total = StatsKernels::aggregate(prices, stocks, count);
+    bookCount = total.count;
+    priceSum = total.priceSum;
+    totalValue = total.totalValue;
+    stockSum = static_cast<long long>(total.stockSum);
+    for (size_t i = 0; i < count; ++i) {
+        addValue(priceCounts, prices[i]);
+        addValue(stockCounts, stocks[i]);
+    }
+}
+
+void RunningStats::onSaleAdded(int64_t totalCents) {
+    ++saleCount;
+    salesCents += totalCents;
+}
+
+void RunningStats::onSalesCleared() {
+    saleCount = 0;
+    salesCents = 0;
+}
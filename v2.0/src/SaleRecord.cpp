@@ -1,82 +1,94 @@
 #include "../include/SaleRecord.h"
-#include <chrono>
+#include "../include/TextParse.h"
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
 
-// 获取当前时间字符串
-std::string SaleRecord::getCurrentTime() const {
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    auto tm = *std::localtime(&time_t);
-    
-    std::stringstream ss;
-    ss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
-    return ss.str();
+namespace {
+    // 金额 -> 分（四舍五入）
+    int64_t toCents(double amount) {
+        return static_cast<int64_t>(std::llround(amount * 100.0));
+    }
 }
 
-// 默认构造函数
-SaleRecord::SaleRecord() : isbn(""), bookTitle(""), quantity(0), totalPrice(0.0) {
-    saleTime = getCurrentTime();
-}
+// 默认构造函数（只用于随后从文件解析，不生成当前时间）
+SaleRecord::SaleRecord() : isbn(), saleTime(0), totalCents(0), quantity(0), bookTitle(StringPool::EMPTY) {}
 
-// 带参数的构造函数
-SaleRecord::SaleRecord(const std::string& isbn, const std::string& bookTitle, 
+// 带参数的构造函数：只记录当前时刻的微秒数，不做任何格式化
+SaleRecord::SaleRecord(IsbnKey isbn, const std::string& bookTitle, 
                        int quantity, double price)
-    : isbn(isbn), bookTitle(bookTitle), quantity(quantity) {
-    totalPrice = quantity * price;
-    saleTime = getCurrentTime();
-}
+    : isbn(isbn), saleTime(Timestamp::nowMicros()), totalCents(toCents(price) * quantity),
+      quantity(quantity), bookTitle(titlePool().intern(bookTitle)) {}
 
-// 拷贝构造函数
-SaleRecord::SaleRecord(const SaleRecord& other)
-    : isbn(other.isbn), bookTitle(other.bookTitle), quantity(other.quantity),
-      totalPrice(other.totalPrice), saleTime(other.saleTime) {}
-
-// 赋值运算符重载
-SaleRecord& SaleRecord::operator=(const SaleRecord& other) {
-    if (this != &other) {
-        isbn = other.isbn;
-        bookTitle = other.bookTitle;
-        quantity = other.quantity;
-        totalPrice = other.totalPrice;
-        saleTime = other.saleTime;
-    }
-    return *this;
+// 书名驻留池（函数内静态对象，避免静态初始化顺序问题）
+StringPool& SaleRecord::titlePool() {
+    static StringPool pool;
+    return pool;
 }
 
-// 析构函数
-SaleRecord::~SaleRecord() {}
+void SaleRecord::setTotalPrice(double p) {
+    totalCents = toCents(p);
+}
 
 // 显示销售记录
 void SaleRecord::display() const {
     std::cout << "====================================" << std::endl;
     std::cout << "ISBN: " << isbn << std::endl;
-    std::cout << "书名: " << bookTitle << std::endl;
+    std::cout << "书名: " << getBookTitle() << std::endl;
     std::cout << "销售数量: " << quantity << std::endl;
-    std::cout << "总价格: ¥" << std::fixed << std::setprecision(2) << totalPrice << std::endl;
-    std::cout << "销售时间: " << saleTime << std::endl;
+    std::cout << "总价格: ¥" << std::fixed << std::setprecision(2) << getTotalPrice() << std::endl;
+    std::cout << "销售时间: " << getSaleTime() << std::endl;
     std::cout << "====================================" << std::endl;
 }
 
-// 获取销售记录的字符串表示
+// 获取销售记录的字符串表示（格式与以前相同：ISBN|书名|数量|总价|销售时间，时间不是整秒时带微秒）
 std::string SaleRecord::toString() const {
-    std::stringstream ss;
-    ss << isbn << "|" << bookTitle << "|" << quantity << "|" 
-       << std::fixed << std::setprecision(2) << totalPrice << "|" << saleTime;
-    return ss.str();
+    std::string_view title = getBookTitle();
+    std::string text;
+    text.reserve(13 + title.size() + 48);
+    text += isbn.toString();
+    text += '|';
+    text += title;
+    text += '|';
+    text += std::to_string(quantity);
+    text += '|';
+
+    char price[32];
+    int length = std::snprintf(price, sizeof(price), "%s%lld.%02lld", totalCents < 0 ? "-" : "",
+                               static_cast<long long>(std::llabs(totalCents) / 100),
+                               static_cast<long long>(std::llabs(totalCents) % 100));
+    text.append(price, static_cast<size_t>(length));
+    text += '|';
+
+    // 保存和写日志都走这里，带上微秒，重新加载后时间顺序和区间查询结果不变
+    char time[Timestamp::PRECISE_LENGTH];
+    text.append(time, Timestamp::formatPreciseTo(saleTime, time));
+    return text;
 }
 
 // 从字符串解析销售记录
 bool SaleRecord::fromString(const std::string& str) {
-    std::stringstream ss(str);
-    std::string temp;
-    
-    if (!std::getline(ss, isbn, '|')) return false;
-    if (!std::getline(ss, bookTitle, '|')) return false;
-    if (!std::getline(ss, temp, '|')) return false;
-    quantity = std::stoi(temp);
-    if (!std::getline(ss, temp, '|')) return false;
-    totalPrice = std::stod(temp);
-    if (!std::getline(ss, saleTime)) return false;
+    return parse(str);
+}
+
+// 格式：ISBN|书名|数量|总价|销售时间
+bool SaleRecord::parse(std::string_view line) {
+    std::string_view fields[4];
+    for (auto& field : fields) {
+        if (!TextParse::nextField(line, field)) return false;
+    }
     
+    int newQuantity;
+    double newTotal;
+    int64_t newTime;
+    if (!TextParse::toInt(fields[2], newQuantity)) return false;
+    if (!TextParse::toDouble(fields[3], newTotal)) return false;
+    if (!Timestamp::parse(line, newTime)) return false;   // 销售时间是行内剩余的全部内容
+    isbn = IsbnKey::parse(fields[0]);
+    bookTitle = titlePool().intern(fields[1]);
+    quantity = newQuantity;
+    totalCents = toCents(newTotal);
+    saleTime = newTime;
     return true;
 }
 
@@ -0,0 +1,324 @@
+#include "../include/SalesJournal.h"
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include <filesystem>
+#include <algorithm>
+#include <iterator>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+    const size_t FRAME_HEADER_SIZE = 16;    // 长度 + CRC + 序号
+    
+    // 把FILE*中的数据真正写到磁盘
+    bool syncFile(FILE* file) {
+        if (std::fflush(file) != 0) {
+            return false;
+        }
+#ifdef _WIN32
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+    
+    template <typename T>
+    void put(std::string& out, T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    
+    template <typename T>
+    T get(const char* p) {
+        T value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+}
+
+// 构造函数
+SalesJournal::SalesJournal()
+    : file(nullptr), lastSeq(0), policy(SyncPolicy::GroupCommit), groupSize(32),
+      groupInterval(50), pending(0), lastSync(std::chrono::steady_clock::now()), stopping(false) {}
+
+// 析构函数
+SalesJournal::~SalesJournal() {
+    close();
+}
+
+// CRC32C（Castagnoli多项式，逐字节查表）
+uint32_t SalesJournal::crc32c(const char* data, size_t length) {
+    static const std::vector<uint32_t> table = [] {
+        std::vector<uint32_t> t(256);
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+    
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; ++i) {
+        crc = (crc >> 8) ^ table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF];
+    }
+    return ~crc;
+}
+
+// 打开日志用于追加
+bool SalesJournal::open(const std::string& filename, uint64_t minSeq) {
+    close();
+    
+    // 先扫描一遍，截掉上次崩溃时写了一半的帧
+    uint64_t seq = 0;
+    uint64_t validBytes = 0;
+    if (!replay(filename, UINT64_MAX, nullptr, &seq, &validBytes)) {
+        return false;
+    }
+    std::error_code ec;
+    if (fs::exists(filename, ec) && fs::file_size(filename, ec) > validBytes) {
+        fs::resize_file(filename, validBytes, ec);
+        if (ec) {
+            return false;
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    file = std::fopen(filename.c_str(), "ab");
+    if (!file) {
+        return false;
+    }
+    path = filename;
+    lastSeq = std::max(seq, minSeq);
+    pending = 0;
+    lastSync = std::chrono::steady_clock::now();
+    return true;
+}
+
+// 关闭日志（关闭前把未落盘的记录fsync）
+void SalesJournal::close() {
+    stopFlusher();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (file) {
+        flushToDisk();
+        std::fclose(file);
+        file = nullptr;
+    }
+}
+
+// 停止后台落盘线程
+void SalesJournal::stopFlusher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    if (flusher.joinable()) {
+        flusher.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = false;
+}
+
+// 后台落盘：有未落盘的记录时等到上次fsync后满一个间隔再fsync
+void SalesJournal::flushLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        if (pending == 0 || policy != SyncPolicy::GroupCommit) {
+            wakeup.wait(lock);
+            continue;
+        }
+        auto deadline = lastSync + groupInterval;
+        if (std::chrono::steady_clock::now() < deadline) {
+            wakeup.wait_until(lock, deadline);
+            continue;
+        }
+        if (!flushToDisk()) {
+            lastSync = std::chrono::steady_clock::now();    // 失败时隔一个间隔再试，不空转
+        }
+    }
+}
+
+// 设置落盘策略
+void SalesJournal::setSyncPolicy(SyncPolicy p, size_t batch, std::chrono::milliseconds interval) {
+    std::lock_guard<std::mutex> lock(mutex);
+    policy = p;
+    groupSize = batch > 0 ? batch : 1;
+    groupInterval = interval;
+}
+
+bool SalesJournal::flushToDisk() {
+    if (pending == 0) {
+        return true;
+    }
+    if (!syncFile(file)) {
+        return false;
+    }
+    pending = 0;
+    lastSync = std::chrono::steady_clock::now();
+    return true;
+}
+
+// 追加一条销售记录
+bool SalesJournal::append(const SaleRecord& record) {
+    return appendFrame(record.toString(), 1);
+}
+
+// 批量追加：一帧写入全部记录
+bool SalesJournal::appendBatch(const std::vector<SaleRecord>& records) {
+    std::string payload;
+    for (const auto& record : records) {
+        if (!payload.empty()) {
+            payload += '\n';
+        }
+        payload += record.toString();
+    }
+    return appendFrame(payload, records.size());
+}
+
+// 追加一帧
+bool SalesJournal::appendFrame(const std::string& payload, size_t records) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file) {
+        return false;
+    }
+    
+    uint64_t seq = lastSeq + 1;
+    std::string frame;
+    frame.reserve(FRAME_HEADER_SIZE + payload.size());
+    put<uint32_t>(frame, static_cast<uint32_t>(payload.size()));
+    put<uint32_t>(frame, 0);    // CRC占位，覆盖序号和负载
+    put<uint64_t>(frame, seq);
+    frame += payload;
+    uint32_t crc = crc32c(frame.data() + 8, frame.size() - 8);
+    std::memcpy(&frame[4], &crc, sizeof(crc));
+    
+    // 整帧一次写入并推送到操作系统，进程崩溃时最多留下一个被截断的尾帧
+    if (std::fwrite(frame.data(), 1, frame.size(), file) != frame.size() || std::fflush(file) != 0) {
+        return false;
+    }
+    lastSeq = seq;
+    pending += records;
+    
+    switch (policy) {
+        case SyncPolicy::None:
+            pending = 0;
+            return true;
+        case SyncPolicy::EveryRecord:
+            return flushToDisk();
+        case SyncPolicy::GroupCommit:
+            if (pending >= groupSize || std::chrono::steady_clock::now() - lastSync >= groupInterval) {
+                return flushToDisk();
+            }
+            // 没有后续购买时由后台线程在间隔到期后fsync
+            if (!flusher.joinable()) {
+                flusher = std::thread(&SalesJournal::flushLoop, this);
+            }
+            wakeup.notify_one();
+            return true;
+    }
+    return true;
+}
+
+// 立即fsync
+bool SalesJournal::sync() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return file && flushToDisk();
+}
+
+size_t SalesJournal::getPendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending;
+}
+
+// 轮转日志
+bool SalesJournal::rotate(const std::string& rotatedName) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file) {
+        return false;
+    }
+    flushToDisk();
+    std::fclose(file);
+    file = nullptr;
+    
+    std::error_code ec;
+    fs::rename(path, rotatedName, ec);
+    file = std::fopen(path.c_str(), "ab");
+    return !ec && file != nullptr;
+}
+
+// 清空日志
+bool SalesJournal::truncate() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!file) {
+        return false;
+    }
+    std::fclose(file);
+    file = std::fopen(path.c_str(), "wb");
+    pending = 0;
+    return file != nullptr && syncFile(file);
+}
+
+// 重放日志
+bool SalesJournal::replay(const std::string& filename, uint64_t afterSeq, const ReplayHandler& handler,
+                          uint64_t* lastSeq, uint64_t* validBytes) {
+    if (lastSeq) *lastSeq = 0;
+    if (validBytes) *validBytes = 0;
+    
+    std::error_code ec;
+    if (!fs::exists(filename, ec)) {
+        return true;
+    }
+    std::ifstream in(filename, std::ios::binary);
+    if (!in.is_open()) {
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    
+    size_t pos = 0;
+    while (data.size() - pos >= FRAME_HEADER_SIZE) {
+        const char* frame = data.data() + pos;
+        uint32_t length = get<uint32_t>(frame);
+        uint32_t crc = get<uint32_t>(frame + 4);
+        uint64_t seq = get<uint64_t>(frame + 8);
+        if (data.size() - pos - FRAME_HEADER_SIZE < length) {
+            break;  // 尾帧被截断
+        }
+        if (crc32c(frame + 8, 8 + length) != crc) {
+            break;  // 尾帧损坏
+        }
+        // 一帧可能含多条记录（批量购买），全部解析成功才重放
+        std::string_view payload(frame + FRAME_HEADER_SIZE, length);
+        std::vector<SaleRecord> records;
+        bool parsed = true;
+        while (parsed) {
+            size_t end = payload.find('\n');
+            records.emplace_back();
+            parsed = records.back().parse(payload.substr(0, end));
+            if (end == std::string_view::npos) {
+                break;
+            }
+            payload.remove_prefix(end + 1);
+        }
+        if (!parsed) {
+            break;
+        }
+        if (seq > afterSeq && handler) {
+            for (const auto& record : records) {
+                handler(seq, record);
+            }
+        }
+        pos += FRAME_HEADER_SIZE + length;
+        if (lastSeq) *lastSeq = seq;
+        if (validBytes) *validBytes = pos;
+    }
+    return true;
+}
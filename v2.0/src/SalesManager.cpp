@@ -1,74 +1,316 @@
 #include "../include/SalesManager.h"
+#include "../include/ParallelLoader.h"
+#include "../include/AtomicFile.h"
 #include <iostream>
+#include <iterator>
+#include <algorithm>
 #include <fstream>
+#include <utility>
+#include <numeric>
 
 // 构造函数
-SalesManager::SalesManager(BookManager* bm) : bookManager(bm) {}
+SalesManager::SalesManager(BookManager* bm) : totalCents(0), bookManager(bm), journal(nullptr), loadedJournalSeq(0) {}
 
 // 析构函数
 SalesManager::~SalesManager() {}
 
 // 购买图书
 bool SalesManager::purchaseBook(const std::string& isbn, int quantity) {
-    if (quantity <= 0) {
-        std::cout << "错误：购买数量必须大于0！" << std::endl;
-        return false;
+    PurchaseReceipt receipt = purchaseBatch({PurchaseLine{isbn, quantity}});
+    switch (receipt.status) {
+        case PurchaseReceipt::Status::Ok:
+            break;
+        case PurchaseReceipt::Status::BookNotFound:
+            std::cout << "错误：该编号 " << isbn << " 不存在！" << std::endl;
+            return false;
+        case PurchaseReceipt::Status::InsufficientStock:
+            std::cout << "错误：库存不足！当前库存：" << bookManager->getStock(isbn)
+                      << "，购买数量：" << quantity << std::endl;
+            return false;
+        default:
+            std::cout << "错误：" << receipt.describe() << "！" << std::endl;
+            return false;
     }
     
-    // 查找图书
-    auto book = bookManager->findBookByIsbn(isbn);
-    if (!book) {
-        std::cout << "错误：该编号 " << isbn << " 不存在！" << std::endl;
-        return false;
-    }
+    const PurchaseReceipt::Line& line = receipt.lines.front();
+    std::cout << "购买成功！" << std::endl;
+    std::cout << "图书: " << line.title << std::endl;
+    std::cout << "数量: " << line.quantity << std::endl;
+    std::cout << "总价: ¥" << receipt.getTotal() << std::endl;
     
-    // 检查库存
-    int currentStock = book->getStock();
-    if (currentStock < quantity) {
-        std::cout << "错误：库存不足！当前库存：" << currentStock 
-                  << "，购买数量：" << quantity << std::endl;
-        return false;
+    return true;
+}
+
+// 批量购买
+PurchaseReceipt SalesManager::purchaseBatch(const std::vector<PurchaseLine>& lines) {
+    PreparedPurchase prepared;
+    if (!preparePurchase(lines, prepared)) {
+        return prepared.receipt;
     }
-    
-    // 更新库存
-    if (!bookManager->updateStock(isbn, -quantity)) {
-        std::cout << "错误：库存更新失败！" << std::endl;
+    return commitPurchase(prepared);
+}
+
+// 批量购买第一步：解析、查找、校验并写日志，不修改书库和销售记录
+bool SalesManager::preparePurchase(const std::vector<PurchaseLine>& lines, PreparedPurchase& prepared) {
+    PurchaseReceipt& receipt = prepared.receipt;
+    auto fail = [&prepared](PurchaseReceipt::Status status, size_t line) {
+        prepared.receipt.status = status;
+        prepared.receipt.failedLine = line;
+        prepared.receipt.lines.clear();
+        prepared.receipt.totalCents = 0;
+        prepared.records.clear();
+        prepared.demand.clear();
         return false;
+    };
+    if (lines.empty()) {
+        return fail(PurchaseReceipt::Status::Empty, 0);
     }
     
-    // 创建销售记录
-    auto saleRecord = std::make_shared<SaleRecord>(
-        isbn, book->getTitle(), quantity, book->getPrice()
-    );
-    
-    saleRecords.push_back(saleRecord);
-    
-    std::cout << "购买成功！" << std::endl;
-    std::cout << "图书: " << book->getTitle() << std::endl;
-    std::cout << "数量: " << quantity << std::endl;
-    std::cout << "总价: ¥" << saleRecord->getTotalPrice() << std::endl;
+    // 同一ISBN出现多次时按累计数量检查库存
+    receipt.saleTime = Timestamp::nowMicros();
+    std::vector<SaleRecord>& records = prepared.records;
+    records.reserve(lines.size());
+    receipt.lines.reserve(lines.size());
+    std::unordered_map<IsbnKey, int>& demand = prepared.demand;
+    demand.reserve(lines.size());
+    for (size_t i = 0; i < lines.size(); ++i) {
+        const PurchaseLine& line = lines[i];
+        if (line.quantity <= 0) {
+            return fail(PurchaseReceipt::Status::InvalidQuantity, i);
+        }
+        IsbnKey key = IsbnKey::parse(line.isbn);
+        const Book* book = bookManager->findBookByIsbn(key);
+        if (!book) {
+            return fail(PurchaseReceipt::Status::BookNotFound, i);
+        }
+        int& wanted = demand[key];
+        if (book->getStock() - wanted < line.quantity) {
+            return fail(PurchaseReceipt::Status::InsufficientStock, i);
+        }
+        wanted += line.quantity;
+        
+        records.emplace_back(key, book->getTitle(), line.quantity, book->getPrice());
+        SaleRecord& record = records.back();
+        record.setTimestamp(receipt.saleTime);
+        receipt.lines.push_back({key, record.getBookTitle(), line.quantity,
+                                 record.getTotalCents() / line.quantity, record.getTotalCents()});
+        receipt.totalCents += record.getTotalCents();
+    }
     
+    // 整批作为一帧写入日志，写入失败则放弃整批
+    if (journal && !journal->appendBatch(records)) {
+        return fail(PurchaseReceipt::Status::JournalFailed, 0);
+    }
     return true;
 }
 
-// 根据ISBN获取销售记录
-std::vector<std::shared_ptr<SaleRecord>> SalesManager::getSaleRecordsByIsbn(const std::string& isbn) const {
-    std::vector<std::shared_ptr<SaleRecord>> result;
+// 批量购买第二步：库存已按累计数量校验过，扣减不会失败
+PurchaseReceipt SalesManager::commitPurchase(PreparedPurchase& prepared) {
+    for (const auto& entry : prepared.demand) {
+        bookManager->updateStock(entry.first, -entry.second);
+    }
+    for (auto& record : prepared.records) {
+        appendRecord(std::move(record));
+    }
+    prepared.records.clear();
+    prepared.demand.clear();
+    return std::move(prepared.receipt);
+}
+
+const char* PurchaseReceipt::describe() const {
+    switch (status) {
+        case Status::Ok:                return "成功";
+        case Status::Empty:             return "没有要购买的图书";
+        case Status::InvalidQuantity:   return "购买数量必须大于0";
+        case Status::BookNotFound:      return "该编号不存在";
+        case Status::InsufficientStock: return "库存不足";
+        case Status::JournalFailed:     return "销售日志写入失败";
+    }
+    return "未知错误";
+}
+
+// 追加一条记录并通知订阅者
+void SalesManager::appendRecord(SaleRecord record, bool deferOrder) {
+    int64_t totalCents = record.getTotalCents();
+    saleRecords.push_back(std::move(record));
+    indexRecord(saleRecords.size() - 1);
+    orderRecord(saleRecords.size() - 1, deferOrder);
+    rollup.add(saleRecords.back(), publisherOf(saleRecords.back().getIsbnKey()));
+    dirty.markRecord(saleRecords.size() - 1);
+    for (auto* listener : listeners) {
+        listener->onSaleAdded(totalCents);
+    }
+}
+
+// 把第index条记录计入汇总
+void SalesManager::indexRecord(size_t index) {
+    const SaleRecord& record = saleRecords[index];
+    auto inserted = salesIndex.emplace(record.getIsbnKey(), isbnSales.size());
+    if (inserted.second) {
+        isbnSales.push_back({record.getIsbnKey(), 0, 0, record.getTimestamp(), record.getTimestamp(), {}});
+    }
+    
+    IsbnSales& sales = isbnSales[inserted.first->second];
+    sales.unitsSold += record.getQuantity();
+    sales.revenueCents += record.getTotalCents();
+    sales.firstSaleTime = std::min(sales.firstSaleTime, record.getTimestamp());
+    sales.lastSaleTime = std::max(sales.lastSaleTime, record.getTimestamp());
+    sales.records.push_back(index);
+    totalCents += record.getTotalCents();
+}
+
+// 按现有记录重建汇总
+void SalesManager::rebuildIndex() {
+    isbnSales.clear();
+    salesIndex.clear();
+    totalCents = 0;
+    for (size_t i = 0; i < saleRecords.size(); ++i) {
+        indexRecord(i);
+    }
+}
+
+// 把第index条记录放入时间顺序：按时间追加时什么都不用做
+void SalesManager::orderRecord(size_t index, bool deferred) {
+    int64_t time = saleRecords[index].getTimestamp();
+    if (timeOrder.empty()) {
+        if (index == 0 || saleRecords[index - 1].getTimestamp() <= time) {
+            return;
+        }
+        // 第一次出现乱序：建立下标表，此前的记录仍是有序的
+        timeOrder.resize(index);
+        std::iota(timeOrder.begin(), timeOrder.end(), size_t(0));
+    }
+    if (deferred) {
+        timeOrder.push_back(index);
+        return;
+    }
+    auto pos = std::upper_bound(timeOrder.begin(), timeOrder.end(), time,
+                                [this](int64_t t, size_t i) { return t < saleRecords[i].getTimestamp(); });
+    timeOrder.insert(pos, index);
+}
+
+// 对表尾的乱序下标排序后与有序的前段归并：时间相同的记录保持追加顺序（表尾的下标都比前段大）
+void SalesManager::sortDeferredOrder() {
+    auto byTime = [this](size_t a, size_t b) { return saleRecords[a].getTimestamp() < saleRecords[b].getTimestamp(); };
+    auto middle = std::is_sorted_until(timeOrder.begin(), timeOrder.end(), byTime);
+    if (middle == timeOrder.end()) {
+        return;
+    }
+    std::stable_sort(middle, timeOrder.end(), byTime);
+    std::inplace_merge(timeOrder.begin(), middle, timeOrder.end(), byTime);
+}
+
+// 按时间区间查询
+SaleRange SalesManager::getSaleRecordsBetween(int64_t from, int64_t to) const {
+    if (from >= to) {
+        return SaleRange();
+    }
+    if (timeOrder.empty()) {
+        auto before = [](const SaleRecord& record, int64_t t) { return record.getTimestamp() < t; };
+        auto first = std::lower_bound(saleRecords.begin(), saleRecords.end(), from, before);
+        auto last = std::lower_bound(first, saleRecords.end(), to, before);
+        return SaleRange(saleRecords.data(), nullptr, static_cast<size_t>(first - saleRecords.begin()),
+                         static_cast<size_t>(last - saleRecords.begin()));
+    }
+    auto before = [this](size_t i, int64_t t) { return saleRecords[i].getTimestamp() < t; };
+    auto first = std::lower_bound(timeOrder.begin(), timeOrder.end(), from, before);
+    auto last = std::lower_bound(first, timeOrder.end(), to, before);
+    return SaleRange(saleRecords.data(), timeOrder.data(), static_cast<size_t>(first - timeOrder.begin()),
+                     static_cast<size_t>(last - timeOrder.begin()));
+}
+
+SaleRange SalesManager::getSaleRecordsBetween(const std::string& from, const std::string& to) const {
+    int64_t fromMicros, toMicros;
+    if (!Timestamp::parse(from, fromMicros) || !Timestamp::parse(to, toMicros)) {
+        return SaleRange();
+    }
+    return getSaleRecordsBetween(fromMicros, toMicros);
+}
+
+// 按现有记录重建时间分桶汇总
+void SalesManager::rebuildRollup() {
+    rollup.clear();
     for (const auto& record : saleRecords) {
-        if (record->getIsbn() == isbn) {
-            result.push_back(record);
+        rollup.add(record, publisherOf(record.getIsbnKey()));
+    }
+}
+
+// 售出时该书的出版社
+StringPool::Id SalesManager::publisherOf(IsbnKey isbn) const {
+    const Book* book = bookManager->findBookByIsbn(isbn);
+    return book ? book->getPublisherId() : StringPool::EMPTY;
+}
+
+void SalesManager::writeRollupTo(std::ostream& out) const {
+    rollup.writeTo(out, saleRecords.size(), totalCents);
+}
+
+// 订阅修改通知
+void SalesManager::addListener(StatsListener* listener) {
+    listeners.push_back(listener);
+}
+
+// 取消订阅
+void SalesManager::removeListener(StatsListener* listener) {
+    listeners.erase(std::remove(listeners.begin(), listeners.end(), listener), listeners.end());
+}
+
+// 恢复时重放一条日志中的销售记录
+void SalesManager::restoreSaleRecord(const SaleRecord& record) {
+    appendRecord(record);
+}
+
+void SalesManager::restoreSaleRecords(std::vector<SaleRecord> records) {
+    for (auto& record : records) {
+        appendRecord(std::move(record), true);
+    }
+    sortDeferredOrder();
+}
+
+// 根据ISBN获取销售记录
+std::vector<const SaleRecord*> SalesManager::getSaleRecordsByIsbn(const std::string& isbn) const {
+    return getSaleRecordsByIsbn(IsbnKey::parse(isbn));
+}
+
+std::vector<const SaleRecord*> SalesManager::getSaleRecordsByIsbn(IsbnKey isbn) const {
+    std::vector<const SaleRecord*> result;
+    const IsbnSales* sales = getSalesByIsbn(isbn);
+    if (sales) {
+        result.reserve(sales->records.size());
+        for (size_t index : sales->records) {
+            result.push_back(&saleRecords[index]);
         }
     }
     return result;
 }
 
-// 计算总销售额
-double SalesManager::getTotalSales() const {
-    double total = 0.0;
-    for (const auto& record : saleRecords) {
-        total += record->getTotalPrice();
+// 某个ISBN的销售汇总
+const IsbnSales* SalesManager::getSalesByIsbn(const std::string& isbn) const {
+    return getSalesByIsbn(IsbnKey::parse(isbn));
+}
+
+const IsbnSales* SalesManager::getSalesByIsbn(IsbnKey isbn) const {
+    auto it = salesIndex.find(isbn);
+    return it == salesIndex.end() ? nullptr : &isbnSales[it->second];
+}
+
+// 畅销图书：只对各ISBN的汇总做部分排序
+std::vector<const IsbnSales*> SalesManager::getBestSellers(size_t limit) const {
+    std::vector<const IsbnSales*> result;
+    result.reserve(isbnSales.size());
+    for (const auto& sales : isbnSales) {
+        result.push_back(&sales);
     }
-    return total;
+    
+    limit = std::min(limit, result.size());
+    std::partial_sort(result.begin(), result.begin() + limit, result.end(),
+                      [](const IsbnSales* a, const IsbnSales* b) {
+                          if (a->unitsSold != b->unitsSold) return a->unitsSold > b->unitsSold;
+                          if (a->revenueCents != b->revenueCents) return a->revenueCents > b->revenueCents;
+                          return a->isbn < b->isbn;
+                      });
+    result.resize(limit);
+    return result;
 }
 
 // 显示所有销售记录
@@ -83,52 +325,147 @@ void SalesManager::displayAllSaleRecords() const {
     std::cout << "====================================" << std::endl;
     
     for (const auto& record : saleRecords) {
-        record->display();
+        record.display();
     }
 }
 
 // 清空所有销售记录
 void SalesManager::clear() {
     saleRecords.clear();
+    timeOrder.clear();
+    rebuildIndex();
+    rollup.clear();
+    dirty.markAll(0);
+    for (auto* listener : listeners) {
+        listener->onSalesCleared();
+    }
 }
 
-// 从文件加载销售记录
+// 从文件加载销售记录（分块并行解析，结果保持文件中的行序）
 bool SalesManager::loadFromFile(const std::string& filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
+    std::vector<SaleRecord> loaded;
+    uint64_t journalSeq = 0;
+    SegmentedFile::Manifest manifest;
+    bool aligned = true;    // 各段记录数是否与段大小一致（否则下次保存全部重写）
+    if (SegmentedFile::readManifest(filename, manifest)) {
+        journalSeq = manifest.journalSeq;
+        for (size_t i = 0; i < manifest.segments.size(); ++i) {
+            std::vector<SaleRecord> part;
+            std::string path = SegmentedFile::segmentPath(filename, manifest.segments[i]);
+            if (!ParallelLoader().loadSaleRecords(path, part)) {
+                std::cout << "无法打开文件: " << path << std::endl;
+                return false;
+            }
+            aligned = aligned && (i + 1 == manifest.segments.size() || part.size() == manifest.segmentSize);
+            std::move(part.begin(), part.end(), std::back_inserter(loaded));
+        }
+    } else if (!ParallelLoader().loadSaleRecords(filename, loaded, &journalSeq)) {
         std::cout << "无法打开文件: " << filename << std::endl;
         return false;
     }
     
-    saleRecords.clear();
-    std::string line;
-    while (std::getline(file, line)) {
-        if (!line.empty()) {
-            SaleRecord record;
-            if (record.fromString(line)) {
-                saleRecords.push_back(std::make_shared<SaleRecord>(record));
-            }
+    saleRecords.swap(loaded);
+    
+    // 按时间顺序存放：文件中的顺序不对时稳定排序，并在下次保存时整体重写
+    auto byTime = [](const SaleRecord& a, const SaleRecord& b) { return a.getTimestamp() < b.getTimestamp(); };
+    bool reordered = !std::is_sorted(saleRecords.begin(), saleRecords.end(), byTime);
+    if (reordered) {
+        std::stable_sort(saleRecords.begin(), saleRecords.end(), byTime);
+    }
+    timeOrder.clear();
+    rebuildIndex();
+    // 附属文件与销售数据一致时直接使用（保留售出时的出版社），否则从记录重建
+    if (!rollup.loadFromFile(rollupFileName(filename), saleRecords.size(), totalCents)) {
+        rebuildRollup();
+    }
+    loadedJournalSeq = journalSeq;
+    if (!aligned || manifest.segmentSize != dirty.getSegmentSize()) {
+        manifest.segmentSize = 0;
+    }
+    segmentLayout = manifest;
+    dirty.reset(saleRecords.size());
+    if (reordered) {
+        dirty.markAll(saleRecords.size());
+    }
+    for (auto* listener : listeners) {
+        listener->onSalesCleared();
+        for (const auto& record : saleRecords) {
+            listener->onSaleAdded(record.getTotalCents());
         }
     }
-    
-    file.close();
     std::cout << "从文件加载了 " << saleRecords.size() << " 条销售记录" << std::endl;
     return true;
 }
 
+// 按文件格式输出全部数据；journalSeq非0时首行写"#journal N"
+void SalesManager::writeTo(std::ostream& out, uint64_t journalSeq) const {
+    if (journalSeq > 0) {
+        out << "#journal " << journalSeq << '\n';
+    }
+    for (const auto& record : saleRecords) {
+        out << record.toString() << '\n';
+    }
+}
+
 // 保存销售记录到文件
-bool SalesManager::saveToFile(const std::string& filename) const {
-    std::ofstream file(filename);
-    if (!file.is_open()) {
+bool SalesManager::saveToFile(const std::string& filename, uint64_t journalSeq) const {
+    // 先写临时文件再改名覆盖，写到一半失败时原文件保持不变
+    AtomicFile file(filename);
+    if (!file.isOpen()) {
         std::cout << "无法创建文件: " << filename << std::endl;
         return false;
     }
     
-    for (const auto& record : saleRecords) {
-        file << record->toString() << std::endl;
+    writeTo(file.stream(), journalSeq);
+    AtomicFile::CommitResult result = file.commit();
+    if (result == AtomicFile::CommitResult::Failed) {
+        std::cout << "写入文件失败: " << filename << std::endl;
+        return false;
     }
     
-    file.close();
+    // 汇总可以从销售记录重建，写入失败只给出警告
+    if (!rollup.saveToFile(rollupFileName(filename), saleRecords.size(), totalCents)) {
+        std::cout << "警告：销售汇总保存失败: " << rollupFileName(filename) << std::endl;
+    }
+    if (result == AtomicFile::CommitResult::DirectorySyncFailed) {
+        // 新文件已生效但掉电后可能变回旧文件：保留旧段文件和修改标记，下次保存时重写
+        std::cout << "警告：已写入 " << filename << "，但目录同步失败，掉电后可能恢复为上次保存的内容" << std::endl;
+        return false;
+    }
+    
+    // 原来是分段存储时，清单已被单文件覆盖，删掉残留的段文件
+    SegmentedFile::removeSegments(filename, segmentLayout);
+    segmentLayout = SegmentedFile::Manifest();
+    dirty.reset(saleRecords.size());
     std::cout << "销售记录已保存到文件: " << filename << std::endl;
     return true;
+}
+
+// 分段保存销售记录
+bool SalesManager::saveSegments(const std::string& filename, uint64_t journalSeq) const {
+    size_t rewritten = 0;
+    AtomicFile::CommitResult result = SegmentedFile::save(
+        filename, saleRecords.size(), dirty.getSegmentSize(), journalSeq, segmentLayout,
+        [this](size_t segment) { return dirty.isSegmentDirty(segment); },
+        [this](size_t first, size_t last, std::ostream& out) {
+            for (size_t i = first; i < last; ++i) {
+                out << saleRecords[i].toString() << '\n';
+            }
+        },
+        &rewritten);
+    if (result == AtomicFile::CommitResult::Failed) {
+        std::cout << "写入文件失败: " << filename << std::endl;
+        return false;
+    }
+    
+    if (!rollup.saveToFile(rollupFileName(filename), saleRecords.size(), totalCents)) {
+        std::cout << "警告：销售汇总保存失败: " << rollupFileName(filename) << std::endl;
+    }
+    if (result == AtomicFile::CommitResult::DirectorySyncFailed) {
+        std::cout << "警告：已写入 " << filename << "，但目录同步失败，掉电后可能恢复为上次保存的内容" << std::endl;
+        return false;
+    }
+    dirty.reset(saleRecords.size());
+    std::cout << "销售记录已分段保存到文件: " << filename << "（重写了 " << rewritten << " 段）" << std::endl;
+    return true;
 }
\ No newline at end of file
@@ -0,0 +1,264 @@
+#include "../include/SalesRollup.h"
+#include "../include/Book.h"
+#include "../include/AtomicFile.h"
+#include "../include/TextParse.h"
+#include <fstream>
+#include <ostream>
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+    // 向下取整的除法（桶号可以为负）
+    int64_t floorDiv(int64_t a, int64_t b) {
+        int64_t q = a / b;
+        return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+    }
+    
+    // 天桶 -> 月桶
+    int64_t monthOfDay(int64_t day) {
+        int64_t year;
+        unsigned month, dayOfMonth;
+        Timestamp::civilFromDays(day, year, month, dayOfMonth);
+        return (year - 1970) * 12 + (month - 1);
+    }
+    
+    // 小时桶 -> 三种粒度的桶号
+    void bucketsOfHour(int64_t hour, int64_t buckets[3]) {
+        buckets[0] = hour;
+        buckets[1] = floorDiv(hour, 24);
+        buckets[2] = monthOfDay(buckets[1]);
+    }
+}
+
+void SalesRollup::Totals::add(const Totals& other) {
+    units += other.units;
+    revenueCents += other.revenueCents;
+    sales += other.sales;
+}
+
+// 时间戳所在的桶号
+int64_t SalesRollup::bucketOf(Granularity g, int64_t micros) {
+    int64_t local = Timestamp::toLocalSeconds(micros);
+    switch (g) {
+        case Granularity::Hour:
+            return floorDiv(local, 3600);
+        case Granularity::Day:
+            return floorDiv(local, 86400);
+        default:
+            return monthOfDay(floorDiv(local, 86400));
+    }
+}
+
+int64_t SalesRollup::monthBucket(int year, unsigned month) {
+    return (static_cast<int64_t>(year) - 1970) * 12 + (static_cast<int64_t>(month) - 1);
+}
+
+// 桶的文字标签
+std::string SalesRollup::bucketLabel(Granularity g, int64_t bucket) {
+    char label[32];
+    if (g == Granularity::Month) {
+        int64_t year = 1970 + floorDiv(bucket, 12);
+        unsigned month = static_cast<unsigned>(bucket - (year - 1970) * 12) + 1;  // 1~12
+        std::snprintf(label, sizeof(label), "%04lld-%02u", static_cast<long long>(year), month);
+        return label;
+    }
+    
+    int64_t year;
+    unsigned month, day;
+    Timestamp::civilFromDays(g == Granularity::Day ? bucket : floorDiv(bucket, 24), year, month, day);
+    int length = std::snprintf(label, sizeof(label), "%04lld-%02u-%02u", static_cast<long long>(year), month, day);
+    std::string text(label, static_cast<size_t>(length));
+    if (g == Granularity::Hour) {
+        std::snprintf(label, sizeof(label), " %02u时", static_cast<unsigned>(bucket - floorDiv(bucket, 24) * 24));
+        text += label;
+    }
+    return text;
+}
+
+// 把某个小时桶里按ISBN的合计计入三种粒度（总计也随之更新）
+void SalesRollup::addIsbn(int64_t hour, IsbnKey isbn, const Totals& totals) {
+    int64_t buckets[GRANULARITIES];
+    bucketsOfHour(hour, buckets);
+    for (int g = 0; g < GRANULARITIES; ++g) {
+        Bucket& bucket = cubes[g][buckets[g]];
+        bucket.total.add(totals);
+        bucket.byIsbn[isbn].add(totals);
+    }
+}
+
+// 把某个小时桶里按出版社的合计计入三种粒度
+void SalesRollup::addPublisher(int64_t hour, StringPool::Id publisher, const Totals& totals) {
+    publisherLease.acquire(Book::publisherPool());
+    int64_t buckets[GRANULARITIES];
+    bucketsOfHour(hour, buckets);
+    for (int g = 0; g < GRANULARITIES; ++g) {
+        cubes[g][buckets[g]].byPublisher[publisher].add(totals);
+    }
+}
+
+// 计入一条销售记录
+void SalesRollup::add(const SaleRecord& record, StringPool::Id publisher) {
+    Totals totals;
+    totals.units = record.getQuantity();
+    totals.revenueCents = record.getTotalCents();
+    totals.sales = 1;
+    publisherLease.acquire(Book::publisherPool());
+    int64_t buckets[GRANULARITIES];
+    bucketsOfHour(bucketOf(Granularity::Hour, record.getTimestamp()), buckets);
+    for (int g = 0; g < GRANULARITIES; ++g) {
+        Bucket& bucket = cubes[g][buckets[g]];
+        bucket.total.add(totals);
+        bucket.byIsbn[record.getIsbnKey()].add(totals);
+        bucket.byPublisher[publisher].add(totals);
+    }
+}
+
+void SalesRollup::clear() {
+    for (auto& c : cubes) {
+        c.clear();
+    }
+    publisherLease.release();
+}
+
+// 区间内每个非空桶的合计
+std::vector<std::pair<int64_t, SalesRollup::Totals>> SalesRollup::getSeries(Granularity g, int64_t first, int64_t last) const {
+    const Buckets& buckets = cube(g);
+    std::vector<std::pair<int64_t, Totals>> series;
+    for (auto it = buckets.lower_bound(first); it != buckets.end() && it->first <= last; ++it) {
+        series.emplace_back(it->first, it->second.total);
+    }
+    return series;
+}
+
+// 区间内的总合计
+SalesRollup::Totals SalesRollup::getTotals(Granularity g, int64_t first, int64_t last) const {
+    const Buckets& buckets = cube(g);
+    Totals sum;
+    for (auto it = buckets.lower_bound(first); it != buckets.end() && it->first <= last; ++it) {
+        sum.add(it->second.total);
+    }
+    return sum;
+}
+
+// 某个ISBN在区间内的合计：每个桶查一次哈希表
+SalesRollup::Totals SalesRollup::getIsbnTotals(Granularity g, IsbnKey isbn, int64_t first, int64_t last) const {
+    const Buckets& buckets = cube(g);
+    Totals sum;
+    for (auto it = buckets.lower_bound(first); it != buckets.end() && it->first <= last; ++it) {
+        auto found = it->second.byIsbn.find(isbn);
+        if (found != it->second.byIsbn.end()) {
+            sum.add(found->second);
+        }
+    }
+    return sum;
+}
+
+// 区间内按出版社的合计
+std::vector<std::pair<std::string_view, SalesRollup::Totals>>
+SalesRollup::getTotalsByPublisher(Granularity g, int64_t first, int64_t last) const {
+    const Buckets& buckets = cube(g);
+    std::unordered_map<StringPool::Id, Totals> byId;
+    for (auto it = buckets.lower_bound(first); it != buckets.end() && it->first <= last; ++it) {
+        for (const auto& entry : it->second.byPublisher) {
+            byId[entry.first].add(entry.second);
+        }
+    }
+    
+    const StringPool& pool = Book::publisherPool();
+    std::vector<std::pair<std::string_view, Totals>> result;
+    result.reserve(byId.size());
+    for (const auto& entry : byId) {
+        result.emplace_back(pool.get(entry.first), entry.second);
+    }
+    std::sort(result.begin(), result.end(),
+              [](const std::pair<std::string_view, Totals>& a, const std::pair<std::string_view, Totals>& b) {
+                  return a.first < b.first;
+              });
+    return result;
+}
+
+// 只写小时粒度：I|小时桶|ISBN|销量|销售额(分)|记录数 和 P|小时桶|出版社|销量|销售额(分)|记录数
+void SalesRollup::writeTo(std::ostream& out, size_t recordCount, int64_t totalCents) const {
+    const StringPool& pool = Book::publisherPool();
+    out << "#rollup " << recordCount << ' ' << totalCents << '\n';
+    for (const auto& bucket : cube(Granularity::Hour)) {
+        for (const auto& entry : bucket.second.byIsbn) {
+            out << "I|" << bucket.first << '|' << entry.first << '|' << entry.second.units << '|'
+                << entry.second.revenueCents << '|' << entry.second.sales << '\n';
+        }
+        for (const auto& entry : bucket.second.byPublisher) {
+            out << "P|" << bucket.first << '|' << pool.get(entry.first) << '|' << entry.second.units << '|'
+                << entry.second.revenueCents << '|' << entry.second.sales << '\n';
+        }
+    }
+}
+
+bool SalesRollup::saveToFile(const std::string& filename, size_t recordCount, int64_t totalCents) const {
+    AtomicFile file(filename);
+    if (!file.isOpen()) {
+        return false;
+    }
+    writeTo(file.stream(), recordCount, totalCents);
+    // 汇总加载时会与销售数据核对，改名后目录没能落盘也不影响正确性
+    return file.commit() != AtomicFile::CommitResult::Failed;
+}
+
+// 加载并核对：两类行各自的记录数和销售额都必须与销售数据一致
+bool SalesRollup::loadFromFile(const std::string& filename, size_t recordCount, int64_t totalCents) {
+    clear();
+    std::ifstream file(filename);
+    std::string line;
+    if (!file.is_open() || !std::getline(file, line)) {
+        return false;
+    }
+    
+    std::string_view header(line);
+    const std::string_view tag = "#rollup ";
+    int64_t savedCount, savedCents;
+    if (header.substr(0, tag.size()) != tag) {
+        return false;
+    }
+    header.remove_prefix(tag.size());
+    size_t space = header.find(' ');
+    if (space == std::string_view::npos || !TextParse::toInt(header.substr(0, space), savedCount)
+        || !TextParse::toInt(header.substr(space + 1), savedCents)
+        || savedCount != static_cast<int64_t>(recordCount) || savedCents != totalCents) {
+        return false;
+    }
+    
+    SalesRollup loaded;
+    loaded.publisherLease.acquire(Book::publisherPool());  // 先登记再驻留出版社名
+    Totals isbnSum, publisherSum;
+    while (std::getline(file, line)) {
+        std::string_view rest(line);
+        std::string_view fields[5];
+        for (auto& field : fields) {
+            if (!TextParse::nextField(rest, field)) return false;
+        }
+        int64_t hour;
+        Totals totals;
+        if (!TextParse::toInt(fields[1], hour) || !TextParse::toInt(fields[3], totals.units)
+            || !TextParse::toInt(fields[4], totals.revenueCents) || !TextParse::toInt(rest, totals.sales)) {
+            return false;
+        }
+        
+        if (fields[0] == "I") {
+            IsbnKey isbn = IsbnKey::parse(fields[2]);
+            if (!isbn.isValid()) return false;
+            loaded.addIsbn(hour, isbn, totals);
+            isbnSum.add(totals);
+        } else if (fields[0] == "P") {
+            loaded.addPublisher(hour, Book::publisherPool().intern(fields[2]), totals);
+            publisherSum.add(totals);
+        } else {
+            return false;
+        }
+    }
+    
+    if (isbnSum.sales != savedCount || publisherSum.sales != savedCount
+        || isbnSum.revenueCents != savedCents || publisherSum.revenueCents != savedCents) {
+        return false;
+    }
+    *this = std::move(loaded);
+    return true;
+}
@@ -0,0 +1,134 @@
+#include "../include/SegmentedFile.h"
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <initializer_list>
+
+namespace {
+    const std::string MANIFEST_TAG = "#segments ";
+    const std::string JOURNAL_TAG = "#journal ";
+}
+
+// 读取清单
+bool SegmentedFile::readManifest(const std::string& filename, Manifest& manifest) {
+    std::ifstream file(filename);
+    std::string line;
+    if (!file.is_open() || !std::getline(file, line) || line.compare(0, MANIFEST_TAG.size(), MANIFEST_TAG) != 0) {
+        return false;
+    }
+    
+    Manifest result;
+    std::istringstream header(line.substr(MANIFEST_TAG.size()));
+    if (!(header >> result.segmentSize >> result.generation) || result.segmentSize == 0) {
+        return false;
+    }
+    while (std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.compare(0, JOURNAL_TAG.size(), JOURNAL_TAG) == 0) {
+            result.journalSeq = std::strtoull(line.c_str() + JOURNAL_TAG.size(), nullptr, 10);
+        } else if (!line.empty()) {
+            result.segments.push_back(line);
+        }
+    }
+    manifest = result;
+    return true;
+}
+
+// 段文件与清单放在同一目录
+std::string SegmentedFile::segmentPath(const std::string& filename, const std::string& segment) {
+    size_t slash = filename.find_last_of("/\\");
+    return slash == std::string::npos ? segment : filename.substr(0, slash + 1) + segment;
+}
+
+// 保存：先写新段，再原子替换清单，最后删除旧段
+AtomicFile::CommitResult SegmentedFile::save(const std::string& filename, size_t count, size_t segmentSize,
+                                             uint64_t journalSeq, Manifest& manifest,
+                                             const std::function<bool(size_t)>& needsWrite,
+                                             const RangeWriter& writer, size_t* rewritten) {
+    // 段大小变化后段边界不再对应，全部重写
+    bool rewriteAll = manifest.segmentSize != segmentSize;
+    
+    Manifest next;
+    next.segmentSize = segmentSize;
+    next.generation = manifest.generation + 1;
+    next.journalSeq = journalSeq;
+    size_t segmentCount = (count + segmentSize - 1) / segmentSize;
+    
+    std::string baseName = filename.substr(filename.find_last_of("/\\") + 1);
+    std::vector<std::string> written;
+    for (size_t i = 0; i < segmentCount; ++i) {
+        if (!rewriteAll && i < manifest.segments.size() && !needsWrite(i)) {
+            next.segments.push_back(manifest.segments[i]);
+            continue;
+        }
+        
+        std::string name = baseName + ".seg" + std::to_string(i) + "." + std::to_string(next.generation);
+        AtomicFile file(segmentPath(filename, name));
+        if (file.isOpen()) {
+            writer(i * segmentSize, std::min(count, (i + 1) * segmentSize), file.stream());
+        }
+        // 段文件与清单在同一目录，目录fsync失败时由下面替换清单时的目录fsync一并落盘
+        if (!file.isOpen() || !file.stream() || file.commit() == AtomicFile::CommitResult::Failed) {
+            // 清单还没替换，撤掉本次已写出的新段即可
+            for (const auto& w : written) {
+                std::remove(segmentPath(filename, w).c_str());
+            }
+            return AtomicFile::CommitResult::Failed;
+        }
+        written.push_back(name);
+        next.segments.push_back(name);
+    }
+    
+    AtomicFile file(filename);
+    if (file.isOpen()) {
+        file.stream() << MANIFEST_TAG << next.segmentSize << ' ' << next.generation << '\n';
+        if (next.journalSeq > 0) {
+            file.stream() << JOURNAL_TAG << next.journalSeq << '\n';
+        }
+        for (const auto& segment : next.segments) {
+            file.stream() << segment << '\n';
+        }
+    }
+    auto result = file.isOpen() && file.stream() ? file.commit() : AtomicFile::CommitResult::Failed;
+    if (result == AtomicFile::CommitResult::Failed) {
+        for (const auto& w : written) {
+            std::remove(segmentPath(filename, w).c_str());
+        }
+        return AtomicFile::CommitResult::Failed;
+    }
+    
+    // 新清单已生效，不再引用的旧段文件（连同之前暂留的）在清单落盘后才能删除
+    std::vector<std::string> unused;
+    for (const auto* list : {&manifest.segments, &manifest.retired}) {
+        for (const auto& old : *list) {
+            if (std::find(next.segments.begin(), next.segments.end(), old) == next.segments.end()) {
+                unused.push_back(old);
+            }
+        }
+    }
+    if (result == AtomicFile::CommitResult::DirectorySyncFailed) {
+        next.retired = unused;
+    } else {
+        for (const auto& old : unused) {
+            std::remove(segmentPath(filename, old).c_str());
+        }
+    }
+    manifest = next;
+    if (rewritten) {
+        *rewritten = written.size();
+    }
+    return result;
+}
+
+// 删除全部段文件
+void SegmentedFile::removeSegments(const std::string& filename, const Manifest& manifest) {
+    for (const auto* list : {&manifest.segments, &manifest.retired}) {
+        for (const auto& segment : *list) {
+            std::remove(segmentPath(filename, segment).c_str());
+        }
+    }
+}
@@ -1,19 +1,62 @@
 #include "../include/StatisticsManager.h"
+#include "../include/StatsKernels.h"
 #include <iostream>
 #include <iomanip>
-#include <map>
+#include <string_view>
 #include <algorithm>
+#include <cmath>
+
+namespace {
+    typedef std::vector<std::pair<std::string_view, std::vector<const Book*>>> Groups;
+    
+    // 按驻留编号分组：以编号为下标放进数组的桶里，最后只对非空的桶按名称排序
+    Groups groupByPoolId(const std::vector<Book>& books, const StringPool& pool,
+                         StringPool::Id (Book::*field)() const) {
+        std::vector<std::vector<const Book*>> buckets(pool.size());
+        std::vector<StringPool::Id> used;
+        for (const auto& book : books) {
+            StringPool::Id id = (book.*field)();
+            if (buckets[id].empty()) {
+                used.push_back(id);
+            }
+            buckets[id].push_back(&book);
+        }
+        std::sort(used.begin(), used.end(), [&pool](StringPool::Id a, StringPool::Id b) {
+            return pool.get(a) < pool.get(b);
+        });
+        
+        Groups groups;
+        groups.reserve(used.size());
+        for (StringPool::Id id : used) {
+            groups.emplace_back(pool.get(id), std::move(buckets[id]));
+        }
+        return groups;
+    }
+}
 
 // 构造函数
 StatisticsManager::StatisticsManager(BookManager* bm, SalesManager* sm) 
-    : bookManager(bm), salesManager(sm) {}
+    : bookManager(bm), salesManager(sm) {
+    // 先用现有数据全量计算一次（融合内核扫描价格/库存列），之后靠修改通知增量维护
+    const auto& prices = bookManager->getPriceColumn();
+    const auto& stocks = bookManager->getStockColumn();
+    running.onBooksLoaded(prices.data(), stocks.data(), prices.size());
+    for (const auto& record : salesManager->getAllSaleRecords()) {
+        running.onSaleAdded(record.getTotalCents());
+    }
+    bookManager->addListener(&running);
+    salesManager->addListener(&running);
+}
 
 // 析构函数
-StatisticsManager::~StatisticsManager() {}
+StatisticsManager::~StatisticsManager() {
+    bookManager->removeListener(&running);
+    salesManager->removeListener(&running);
+}
 
 // 统计所有图书信息
 void StatisticsManager::printAllBooksInfo() const {
-    auto books = bookManager->getAllBooks();
+    const auto& books = bookManager->getAllBooks();
     if (books.empty()) {
         std::cout << "书库为空！" << std::endl;
         return;
@@ -23,37 +66,33 @@ void StatisticsManager::printAllBooksInfo() const {
     std::cout << "图书总数: " << books.size() << " 种" << std::endl;
     
     // 计算总库存和总价值
-    int totalStock = 0;
-    double totalValue = 0.0;
-    for (const auto& book : books) {
-        totalStock += book->getStock();
-        totalValue += book->getStock() * book->getPrice();
-    }
+    PriceStats priceStats;
+    StockStats stockStats;
+    computeStatistics(priceStats, stockStats);
+    long long totalStock = stockStats.totalStock;
+    double totalValue = priceStats.totalValue;
     
     std::cout << "总库存量: " << totalStock << " 册" << std::endl;
     std::cout << "库存总价值: ¥" << std::fixed << std::setprecision(2) << totalValue << std::endl;
     std::cout << "======================================" << std::endl;
     
     for (const auto& book : books) {
-        book->display();
+        book.display();
     }
 }
 
 // 按价格排序统计（从高到低）
-void StatisticsManager::printBooksSortedByPrice() const {
-    auto books = bookManager->getAllBooks();
-    if (books.empty()) {
+void StatisticsManager::printBooksSortedByPrice(size_t limit) const {
+    if (bookManager->getBookCount() == 0) {
         std::cout << "书库为空！" << std::endl;
         return;
     }
     
-    // 按价格降序排序
-    std::sort(books.begin(), books.end(), 
-              [](const std::shared_ptr<Book>& a, const std::shared_ptr<Book>& b) {
-                  return a->getPrice() > b->getPrice();
-              });
+    // 只选出前limit名，不对整个书库排序
+    auto books = bookManager->topKByPrice(limit);
     
     std::cout << "\n========== 按价格排序（从高到低）==========" << std::endl;
+    std::cout << "共 " << bookManager->getBookCount() << " 种，显示前 " << books.size() << " 种" << std::endl;
     for (const auto& book : books) {
         std::cout << "书名: " << book->getTitle() 
                   << " | 价格: ¥" << std::fixed << std::setprecision(2) << book->getPrice()
@@ -62,20 +101,17 @@ void StatisticsManager::printBooksSortedByPrice() const {
 }
 
 // 按库存量排序统计（从多到少）
-void StatisticsManager::printBooksSortedByStock() const {
-    auto books = bookManager->getAllBooks();
-    if (books.empty()) {
+void StatisticsManager::printBooksSortedByStock(size_t limit) const {
+    if (bookManager->getBookCount() == 0) {
         std::cout << "书库为空！" << std::endl;
         return;
     }
     
-    // 按库存量降序排序
-    std::sort(books.begin(), books.end(), 
-              [](const std::shared_ptr<Book>& a, const std::shared_ptr<Book>& b) {
-                  return a->getStock() > b->getStock();
-              });
+    // 只选出前limit名，不对整个书库排序
+    auto books = bookManager->topKByStock(limit);
     
     std::cout << "\n========== 按库存量排序（从多到少）==========" << std::endl;
+    std::cout << "共 " << bookManager->getBookCount() << " 种，显示前 " << books.size() << " 种" << std::endl;
     for (const auto& book : books) {
         std::cout << "书名: " << book->getTitle() 
                   << " | 库存: " << book->getStock() << " 册"
@@ -83,20 +119,77 @@ void StatisticsManager::printBooksSortedByStock() const {
     }
 }
 
+// 按价格区间统计（走有序索引，不扫描整个书库）
+void StatisticsManager::printBooksInPriceRange(double low, double high) const {
+    auto books = bookManager->findBooksByPriceRange(low, high);
+    
+    std::cout << "\n========== 价格区间 ¥" << std::fixed << std::setprecision(2) << low
+              << " - ¥" << high << " ==========" << std::endl;
+    std::cout << "共 " << books.size() << " 种" << std::endl;
+    for (const auto& book : books) {
+        std::cout << "书名: " << book->getTitle() 
+                  << " | 价格: ¥" << std::fixed << std::setprecision(2) << book->getPrice()
+                  << " | ISBN: " << book->getIsbn() << std::endl;
+    }
+}
+
+// 库存预警（走有序索引，不扫描整个书库）
+void StatisticsManager::printLowStockBooks(int threshold) const {
+    auto books = bookManager->findBooksByStockRange(0, threshold - 1);
+    
+    std::cout << "\n========== 库存低于 " << threshold << " 册的图书 ==========" << std::endl;
+    std::cout << "共 " << books.size() << " 种" << std::endl;
+    for (const auto& book : books) {
+        std::cout << "书名: " << book->getTitle() 
+                  << " | 库存: " << book->getStock() << " 册"
+                  << " | ISBN: " << book->getIsbn() << std::endl;
+    }
+}
+
+// 待补货图书（走补货索引，不扫描整个书库）
+void StatisticsManager::printReorderList() const {
+    auto books = bookManager->getReorderList();
+    
+    std::cout << "\n========== 待补货图书 ==========" << std::endl;
+    std::cout << "共 " << books.size() << " 种" << std::endl;
+    for (const auto& book : books) {
+        std::cout << "书名: " << book->getTitle() 
+                  << " | 库存: " << book->getStock() << " 册"
+                  << " | 补货线: " << book->getReorderThreshold() << " 册"
+                  << " | ISBN: " << book->getIsbn() << std::endl;
+    }
+}
+
+// 畅销图书（读取按ISBN增量维护的汇总，不扫描销售记录）
+void StatisticsManager::printBestSellers(size_t limit) const {
+    auto bestSellers = salesManager->getBestSellers(limit);
+    if (bestSellers.empty()) {
+        std::cout << "没有销售记录！" << std::endl;
+        return;
+    }
+    
+    std::cout << "\n========== 畅销图书（前" << bestSellers.size() << "名） ==========" << std::endl;
+    int rank = 1;
+    for (const auto* sales : bestSellers) {
+        const SaleRecord& latest = salesManager->getAllSaleRecords()[sales->records.back()];
+        std::cout << rank++ << ". " << latest.getBookTitle()
+                  << " | 销量: " << sales->unitsSold << " 册"
+                  << " | 销售额: ¥" << std::fixed << std::setprecision(2) << sales->getRevenue()
+                  << " | 最近销售: " << Timestamp::format(sales->lastSaleTime)
+                  << " | ISBN: " << sales->isbn << std::endl;
+    }
+}
+
 // 按作者统计
 void StatisticsManager::printBooksByAuthor() const {
-    auto books = bookManager->getAllBooks();
+    const auto& books = bookManager->getAllBooks();
     if (books.empty()) {
         std::cout << "书库为空！" << std::endl;
         return;
     }
     
-    std::map<std::string, std::vector<std::shared_ptr<Book>>> authorBooks;
-    
-    // 按作者分组
-    for (const auto& book : books) {
-        authorBooks[book->getAuthor()].push_back(book);
-    }
+    // 按作者分组（比较的是编号，不比较字符串）
+    Groups authorBooks = groupByPoolId(books, Book::authorPool(), &Book::getAuthorId);
     
     std::cout << "\n========== 按作者统计 ==========" << std::endl;
     for (const auto& pair : authorBooks) {
@@ -112,18 +205,14 @@ void StatisticsManager::printBooksByAuthor() const {
 
 // 按出版社统计
 void StatisticsManager::printBooksByPublisher() const {
-    auto books = bookManager->getAllBooks();
+    const auto& books = bookManager->getAllBooks();
     if (books.empty()) {
         std::cout << "书库为空！" << std::endl;
         return;
     }
     
-    std::map<std::string, std::vector<std::shared_ptr<Book>>> publisherBooks;
-    
     // 按出版社分组
-    for (const auto& book : books) {
-        publisherBooks[book->getPublisher()].push_back(book);
-    }
+    Groups publisherBooks = groupByPoolId(books, Book::publisherPool(), &Book::getPublisherId);
     
     std::cout << "\n========== 按出版社统计 ==========" << std::endl;
     for (const auto& pair : publisherBooks) {
@@ -137,56 +226,74 @@ void StatisticsManager::printBooksByPublisher() const {
     }
 }
 
-// 获取价格统计信息
-StatisticsManager::PriceStats StatisticsManager::getPriceStatistics() const {
-    auto books = bookManager->getAllBooks();
-    PriceStats stats = {0.0, 0.0, 0.0, 0.0};
-    
-    if (books.empty()) {
-        return stats;
+// 从增量维护的统计值读出价格统计和库存统计
+void StatisticsManager::computeStatistics(PriceStats& price, StockStats& stock) const {
+    price = {0.0, 0.0, 0.0, 0.0};
+    stock = {0, 0, 0, 0, 0.0};
+    size_t count = running.getBookCount();
+    if (count == 0) {
+        return;
     }
     
-    double sum = 0.0;
-    int count = books.size();
-    stats.maxPrice = books[0]->getPrice();
-    stats.minPrice = books[0]->getPrice();
-    
-    for (const auto& book : books) {
-        double price = book->getPrice();
-        sum += price;
-        stats.totalValue += price * book->getStock();
-        
-        if (price > stats.maxPrice) stats.maxPrice = price;
-        if (price < stats.minPrice) stats.minPrice = price;
-    }
+    price.maxPrice = running.getMaxPrice();
+    price.minPrice = running.getMinPrice();
+    price.avgPrice = running.getPriceSum() / count;
+    price.totalValue = running.getTotalValue();
     
-    stats.avgPrice = sum / count;
-    return stats;
+    stock.totalBooks = static_cast<int>(count);
+    stock.totalStock = running.getStockSum();
+    stock.maxStock = running.getMaxStock();
+    stock.minStock = running.getMinStock();
+    stock.avgStock = static_cast<double>(running.getStockSum()) / count;
 }
 
-// 获取库存统计信息
-StatisticsManager::StockStats StatisticsManager::getStockStatistics() const {
-    auto books = bookManager->getAllBooks();
-    StockStats stats = {0, 0, 0, 0, 0.0};
-    
-    if (books.empty()) {
-        return stats;
-    }
+// 一致性检查
+bool StatisticsManager::verifyRunningStats() const {
+    const std::vector<double>& prices = bookManager->getPriceColumn();
+    const std::vector<int>& stocks = bookManager->getStockColumn();
+    StatsKernels::Aggregates total = StatsKernels::aggregate(prices.data(), stocks.data(), prices.size());
     
-    stats.totalBooks = books.size();
-    stats.maxStock = books[0]->getStock();
-    stats.minStock = books[0]->getStock();
+    // 增量累加与全量重算的求和顺序不同，浮点和允许极小的相对误差
+    auto close = [](double a, double b) { return std::fabs(a - b) <= 1e-9 * std::max(1.0, std::fabs(b)); };
+    bool ok = true;
+    auto expect = [&ok](bool condition, const char* what) {
+        if (!condition) {
+            std::cout << "统计不一致: " << what << std::endl;
+            ok = false;
+        }
+    };
     
-    for (const auto& book : books) {
-        int stock = book->getStock();
-        stats.totalStock += stock;
-        
-        if (stock > stats.maxStock) stats.maxStock = stock;
-        if (stock < stats.minStock) stats.minStock = stock;
+    expect(running.getBookCount() == total.count, "图书种类数");
+    expect(close(running.getPriceSum(), total.priceSum), "价格总和");
+    expect(close(running.getTotalValue(), total.totalValue), "库存总价值");
+    expect(running.getStockSum() == static_cast<long long>(total.stockSum), "库存总量");
+    expect(running.getMinPrice() == total.priceMin && running.getMaxPrice() == total.priceMax, "价格最值");
+    expect(running.getMinStock() == total.stockMin && running.getMaxStock() == total.stockMax, "库存最值");
+    expect(running.getSaleCount() == static_cast<size_t>(salesManager->getSaleRecordCount()), "销售记录数");
+    // 销售额都以分为单位累加，逐条求和后必须完全相等
+    int64_t salesCents = 0;
+    for (const auto& record : salesManager->getAllSaleRecords()) {
+        salesCents += record.getTotalCents();
     }
-    
-    stats.avgStock = static_cast<double>(stats.totalStock) / stats.totalBooks;
-    return stats;
+    expect(running.getSalesCents() == salesCents, "总销售额");
+    expect(salesManager->getTotalCents() == salesCents, "按ISBN汇总的总销售额");
+    return ok;
+}
+
+// 获取价格统计信息
+StatisticsManager::PriceStats StatisticsManager::getPriceStatistics() const {
+    PriceStats price;
+    StockStats stock;
+    computeStatistics(price, stock);
+    return price;
+}
+
+// 获取库存统计信息
+StatisticsManager::StockStats StatisticsManager::getStockStatistics() const {
+    PriceStats price;
+    StockStats stock;
+    computeStatistics(price, stock);
+    return stock;
 }
 
 // 生成综合统计报告
@@ -195,8 +302,12 @@ void StatisticsManager::generateReport() const {
     std::cout << "          图书管理系统统计报告          " << std::endl;
     std::cout << "========================================" << std::endl;
     
+    // 库存和价格统计一次遍历得到
+    PriceStats priceStats;
+    StockStats stockStats;
+    computeStatistics(priceStats, stockStats);
+    
     // 库存统计
-    auto stockStats = getStockStatistics();
     std::cout << "\n【库存统计】" << std::endl;
     std::cout << "图书种类总数: " << stockStats.totalBooks << " 种" << std::endl;
     std::cout << "库存总量: " << stockStats.totalStock << " 册" << std::endl;
@@ -205,7 +316,6 @@ void StatisticsManager::generateReport() const {
     std::cout << "平均库存量: " << std::fixed << std::setprecision(1) << stockStats.avgStock << " 册" << std::endl;
     
     // 价格统计
-    auto priceStats = getPriceStatistics();
     std::cout << "\n【价格统计】" << std::endl;
     std::cout << "最高价格: ¥" << std::fixed << std::setprecision(2) << priceStats.maxPrice << std::endl;
     std::cout << "最低价格: ¥" << priceStats.minPrice << std::endl;
@@ -214,8 +324,14 @@ void StatisticsManager::generateReport() const {
     
     // 销售统计
     std::cout << "\n【销售统计】" << std::endl;
-    std::cout << "销售记录总数: " << salesManager->getSaleRecordCount() << " 条" << std::endl;
-    std::cout << "总销售额: ¥" << std::fixed << std::setprecision(2) << salesManager->getTotalSales() << std::endl;
+    std::cout << "销售记录总数: " << running.getSaleCount() << " 条" << std::endl;
+    std::cout << "总销售额: ¥" << std::fixed << std::setprecision(2) << running.getSalesTotal() << std::endl;
+    std::cout << "售出图书种类: " << salesManager->getAllIsbnSales().size() << " 种" << std::endl;
+    auto bestSellers = salesManager->getBestSellers(1);
+    if (!bestSellers.empty()) {
+        std::cout << "最畅销图书: " << salesManager->getAllSaleRecords()[bestSellers[0]->records.back()].getBookTitle()
+                  << "（" << bestSellers[0]->unitsSold << " 册）" << std::endl;
+    }
     
     std::cout << "\n========================================" << std::endl;
 }
\ No newline at end of file
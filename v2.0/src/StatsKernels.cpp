@@ -0,0 +1,240 @@
+#include "../include/StatsKernels.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define STATS_KERNELS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/Clang需要给使用高级指令集的函数单独打开目标特性，MSVC可直接使用内建函数
+#if defined(STATS_KERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+namespace StatsKernels {
+    namespace {
+        // 汇总值的初始状态：最小/最大值取第一个元素
+        Aggregates initial(const double* price, const int* stock, size_t count) {
+            Aggregates result = {count, 0.0, price[0], price[0], 0.0, 0.0, stock[0], stock[0]};
+            return result;
+        }
+        
+        // 标量实现，也用来处理向量实现剩下的尾部元素
+        void scalarRange(Aggregates& r, const double* price, const int* stock, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                double p = price[i];
+                int s = stock[i];
+                r.priceSum += p;
+                r.totalValue += p * s;
+                r.stockSum += s;
+                r.priceMin = p < r.priceMin ? p : r.priceMin;
+                r.priceMax = p > r.priceMax ? p : r.priceMax;
+                r.stockMin = s < r.stockMin ? s : r.stockMin;
+                r.stockMax = s > r.stockMax ? s : r.stockMax;
+            }
+        }
+        
+        Aggregates aggregateScalar(const double* price, const int* stock, size_t count) {
+            Aggregates r = initial(price, stock, count);
+            scalarRange(r, price, stock, 0, count);
+            return r;
+        }
+        
+#ifdef STATS_KERNELS_X86
+        // SSE2：每次处理2本书，库存转为double后与价格同宽计算
+        TARGET_SSE2 Aggregates aggregateSSE2(const double* price, const int* stock, size_t count) {
+            Aggregates r = initial(price, stock, count);
+            __m128d priceSum = _mm_setzero_pd();
+            __m128d valueSum = _mm_setzero_pd();
+            __m128d stockSum = _mm_setzero_pd();
+            __m128d priceMin = _mm_set1_pd(r.priceMin);
+            __m128d priceMax = priceMin;
+            __m128d stockMin = _mm_set1_pd(r.stockMin);
+            __m128d stockMax = stockMin;
+            
+            size_t i = 0;
+            for (; i + 2 <= count; i += 2) {
+                __m128d p = _mm_loadu_pd(price + i);
+                __m128d s = _mm_cvtepi32_pd(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(stock + i)));
+                priceSum = _mm_add_pd(priceSum, p);
+                valueSum = _mm_add_pd(valueSum, _mm_mul_pd(p, s));
+                stockSum = _mm_add_pd(stockSum, s);
+                priceMin = _mm_min_pd(priceMin, p);
+                priceMax = _mm_max_pd(priceMax, p);
+                stockMin = _mm_min_pd(stockMin, s);
+                stockMax = _mm_max_pd(stockMax, s);
+            }
+            
+            alignas(16) double lanes[7][2];
+            _mm_store_pd(lanes[0], priceSum);
+            _mm_store_pd(lanes[1], valueSum);
+            _mm_store_pd(lanes[2], stockSum);
+            _mm_store_pd(lanes[3], priceMin);
+            _mm_store_pd(lanes[4], priceMax);
+            _mm_store_pd(lanes[5], stockMin);
+            _mm_store_pd(lanes[6], stockMax);
+            for (int k = 0; k < 2; ++k) {
+                r.priceSum += lanes[0][k];
+                r.totalValue += lanes[1][k];
+                r.stockSum += lanes[2][k];
+                r.priceMin = lanes[3][k] < r.priceMin ? lanes[3][k] : r.priceMin;
+                r.priceMax = lanes[4][k] > r.priceMax ? lanes[4][k] : r.priceMax;
+                r.stockMin = lanes[5][k] < r.stockMin ? static_cast<int>(lanes[5][k]) : r.stockMin;
+                r.stockMax = lanes[6][k] > r.stockMax ? static_cast<int>(lanes[6][k]) : r.stockMax;
+            }
+            scalarRange(r, price, stock, i, count);
+            return r;
+        }
+        
+        // AVX2（含FMA）：每次处理4本书，两组累加器交替使用以隐藏加法延迟
+        TARGET_AVX2 Aggregates aggregateAVX2(const double* price, const int* stock, size_t count) {
+            Aggregates r = initial(price, stock, count);
+            __m256d priceSum[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+            __m256d valueSum[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+            __m256d stockSum[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+            __m256d priceMin = _mm256_set1_pd(r.priceMin);
+            __m256d priceMax = priceMin;
+            __m256d stockMin = _mm256_set1_pd(r.stockMin);
+            __m256d stockMax = stockMin;
+            
+            size_t i = 0;
+            for (; i + 8 <= count; i += 8) {
+                for (int k = 0; k < 2; ++k) {
+                    __m256d p = _mm256_loadu_pd(price + i + 4 * k);
+                    __m256d s = _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(stock + i + 4 * k)));
+                    priceSum[k] = _mm256_add_pd(priceSum[k], p);
+                    valueSum[k] = _mm256_fmadd_pd(p, s, valueSum[k]);
+                    stockSum[k] = _mm256_add_pd(stockSum[k], s);
+                    priceMin = _mm256_min_pd(priceMin, p);
+                    priceMax = _mm256_max_pd(priceMax, p);
+                    stockMin = _mm256_min_pd(stockMin, s);
+                    stockMax = _mm256_max_pd(stockMax, s);
+                }
+            }
+            
+            alignas(32) double lanes[7][4];
+            _mm256_store_pd(lanes[0], _mm256_add_pd(priceSum[0], priceSum[1]));
+            _mm256_store_pd(lanes[1], _mm256_add_pd(valueSum[0], valueSum[1]));
+            _mm256_store_pd(lanes[2], _mm256_add_pd(stockSum[0], stockSum[1]));
+            _mm256_store_pd(lanes[3], priceMin);
+            _mm256_store_pd(lanes[4], priceMax);
+            _mm256_store_pd(lanes[5], stockMin);
+            _mm256_store_pd(lanes[6], stockMax);
+            for (int k = 0; k < 4; ++k) {
+                r.priceSum += lanes[0][k];
+                r.totalValue += lanes[1][k];
+                r.stockSum += lanes[2][k];
+                r.priceMin = lanes[3][k] < r.priceMin ? lanes[3][k] : r.priceMin;
+                r.priceMax = lanes[4][k] > r.priceMax ? lanes[4][k] : r.priceMax;
+                r.stockMin = lanes[5][k] < r.stockMin ? static_cast<int>(lanes[5][k]) : r.stockMin;
+                r.stockMax = lanes[6][k] > r.stockMax ? static_cast<int>(lanes[6][k]) : r.stockMax;
+            }
+            scalarRange(r, price, stock, i, count);
+            return r;
+        }
+        
+        bool cpuHasAVX2() {
+#if defined(__GNUC__) || defined(__clang__)
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#elif defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 1);
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            bool fma = (info[2] & (1 << 12)) != 0;
+            if (!osxsave || !fma || (_xgetbv(0) & 0x6) != 0x6) {
+                return false;   // 操作系统没有保存YMM寄存器
+            }
+            __cpuid(info, 0);
+            if (info[0] < 7) {
+                return false;
+            }
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            return false;
+#endif
+        }
+        
+        bool cpuHasSSE2() {
+#if defined(__x86_64__) || defined(_M_X64)
+            return true;    // x86-64的基本指令集
+#elif defined(__GNUC__) || defined(__clang__)
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("sse2");
+#elif defined(_MSC_VER)
+            int info[4];
+            __cpuid(info, 1);
+            return (info[3] & (1 << 26)) != 0;
+#else
+            return false;
+#endif
+        }
+#endif // STATS_KERNELS_X86
+    }
+    
+    bool isSupported(Kernel kernel) {
+        switch (kernel) {
+            case Kernel::Scalar:
+                return true;
+#ifdef STATS_KERNELS_X86
+            case Kernel::SSE2: {
+                static const bool sse2 = cpuHasSSE2();
+                return sse2;
+            }
+            case Kernel::AVX2: {
+                static const bool avx2 = cpuHasAVX2();
+                return avx2;
+            }
+#endif
+            default:
+                return false;
+        }
+    }
+    
+    Kernel bestKernel() {
+        static const Kernel best = isSupported(Kernel::AVX2) ? Kernel::AVX2
+                                 : isSupported(Kernel::SSE2) ? Kernel::SSE2
+                                 : Kernel::Scalar;
+        return best;
+    }
+    
+    const char* kernelName(Kernel kernel) {
+        switch (kernel) {
+            case Kernel::AVX2:
+                return "AVX2";
+            case Kernel::SSE2:
+                return "SSE2";
+            default:
+                return "标量";
+        }
+    }
+    
+    Aggregates aggregate(const double* price, const int* stock, size_t count) {
+        return aggregateWith(bestKernel(), price, stock, count);
+    }
+    
+    Aggregates aggregateWith(Kernel kernel, const double* price, const int* stock, size_t count) {
+        if (count == 0) {
+            Aggregates empty = {0, 0.0, 0.0, 0.0, 0.0, 0.0, 0, 0};
+            return empty;
+        }
+#ifdef STATS_KERNELS_X86
+        if (kernel == Kernel::AVX2 && isSupported(Kernel::AVX2)) {
+            return aggregateAVX2(price, stock, count);
+        }
+        if (kernel == Kernel::SSE2 && isSupported(Kernel::SSE2)) {
+            return aggregateSSE2(price, stock, count);
+        }
+#else
+        (void)kernel;
+#endif
+        return aggregateScalar(price, stock, count);
+    }
+}
@@ -0,0 +1,137 @@
+#include "../include/StringPool.h"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+// 构造函数：预先驻留空字符串
+StringPool::StringPool() : count(0), cursor(nullptr), remaining(0), bytes(0), users(0) {
+    insert(std::string_view());
+}
+
+// 把字符复制到内存块中；超过块大小的长字符串单独占一块
+std::string_view StringPool::store(std::string_view s) {
+    if (s.empty()) {
+        return std::string_view();
+    }
+    if (s.size() > remaining) {
+        size_t size = std::max(BLOCK_SIZE, s.size());
+        blocks.emplace_back(new char[size]);
+        bytes += size;
+        if (size == BLOCK_SIZE) {
+            cursor = blocks.back().get();
+            remaining = size;
+        } else {
+            // 长字符串独占的块不作为当前块，避免浪费当前块的剩余空间
+            std::memcpy(blocks.back().get(), s.data(), s.size());
+            return std::string_view(blocks.back().get(), s.size());
+        }
+    }
+    std::memcpy(cursor, s.data(), s.size());
+    std::string_view stored(cursor, s.size());
+    cursor += s.size();
+    remaining -= s.size();
+    return stored;
+}
+
+// 驻留字符串：绝大多数调用命中已有字符串，只需共享锁
+StringPool::Id StringPool::intern(std::string_view s) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = ids.find(s);
+        if (it != ids.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    auto it = ids.find(s);
+    if (it != ids.end()) {
+        return it->second;
+    }
+    return insert(s);
+}
+
+StringPool::Id StringPool::insert(std::string_view s) {
+    if (count == MAX_PAGES * PAGE_SIZE) {
+        throw std::length_error("StringPool: too many distinct strings");
+    }
+
+    Id id = static_cast<Id>(count);
+    std::unique_ptr<std::string_view[]>& page = pages[id >> PAGE_BITS];
+    if (!page) {
+        page.reset(new std::string_view[PAGE_SIZE]);
+    }
+    std::string_view stored = store(s);
+    page[id & (PAGE_SIZE - 1)] = stored;
+    ids.emplace(stored, id);
+    ++count;
+    return id;
+}
+
+// 查找已驻留的字符串
+StringPool::Id StringPool::find(std::string_view s) const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    auto it = ids.find(s);
+    return it == ids.end() ? NOT_FOUND : it->second;
+}
+
+size_t StringPool::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    return count;
+}
+
+// 内存占用（哈希表按每个节点一个键值对加一个指针估算）
+size_t StringPool::memoryUsage() const {
+    std::shared_lock<std::shared_mutex> lock(mutex);
+    size_t pageCount = (count + PAGE_SIZE - 1) / PAGE_SIZE;
+    return bytes + pageCount * PAGE_SIZE * sizeof(std::string_view)
+         + ids.size() * (sizeof(std::string_view) + sizeof(Id) + 2 * sizeof(void*))
+         + ids.bucket_count() * sizeof(void*);
+}
+
+// 重置：检查持有者和清空都在写锁内进行；持有者在驻留之前登记，
+// 因此任何已经取得编号的持有者都一定能在这里被看到
+bool StringPool::resetIfUnused() {
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    if (users.load(std::memory_order_acquire) != 0) {
+        return false;
+    }
+    std::unordered_map<std::string_view, Id>().swap(ids);
+    for (auto& page : pages) {
+        page.reset();
+    }
+    std::vector<std::unique_ptr<char[]>>().swap(blocks);
+    count = 0;
+    cursor = nullptr;
+    remaining = 0;
+    bytes = 0;
+    insert(std::string_view());
+    return true;
+}
+
+StringPool::Lease& StringPool::Lease::operator=(const Lease& other) {
+    if (this != &other && pool != other.pool) {
+        release();
+        if (other.pool) {
+            acquire(*other.pool);
+        }
+    }
+    return *this;
+}
+
+void StringPool::Lease::acquire(StringPool& p) {
+    if (pool == &p) {
+        return;
+    }
+    release();
+    p.acquire();
+    pool = &p;
+}
+
+void StringPool::Lease::release() {
+    if (pool) {
+        pool->release();
+        pool = nullptr;
+    }
+}
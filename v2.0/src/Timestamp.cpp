@@ -0,0 +1,181 @@
+#include "../include/Timestamp.h"
+#include <chrono>
+#include <ctime>
+#include <climits>
+
+namespace {
+    const int64_t SECONDS_PER_DAY = 86400;
+    const int64_t OFFSET_BUCKET = 900;      // 各时区的切换时刻都落在整15分钟上
+
+    // 向下取整的除法（时间戳可以早于1970年）
+    int64_t floorDiv(int64_t a, int64_t b) {
+        int64_t q = a / b;
+        return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+    }
+
+    // 某一UTC时刻（秒）的本地时区偏移（秒）；每个线程缓存最近一次查询所在的15分钟
+    int64_t localOffset(int64_t utcSeconds) {
+        thread_local int64_t cachedBucket = LLONG_MIN;
+        thread_local int64_t cachedOffset = 0;
+
+        int64_t bucket = floorDiv(utcSeconds, OFFSET_BUCKET);
+        if (bucket != cachedBucket) {
+            std::time_t t = static_cast<std::time_t>(bucket * OFFSET_BUCKET);
+            std::tm local{};
+#ifdef _WIN32
+            localtime_s(&local, &t);
+#else
+            localtime_r(&t, &local);
+#endif
+            int64_t localSeconds = Timestamp::daysFromCivil(local.tm_year + 1900, static_cast<unsigned>(local.tm_mon + 1),
+                                                            static_cast<unsigned>(local.tm_mday)) * SECONDS_PER_DAY
+                                 + local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec;
+            cachedOffset = localSeconds - static_cast<int64_t>(t);
+            cachedBucket = bucket;
+        }
+        return cachedOffset;
+    }
+
+    void putDigits(char* out, unsigned value, int width) {
+        for (int i = width - 1; i >= 0; --i) {
+            out[i] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+    }
+
+    // 读取固定位数的数字
+    bool readDigits(std::string_view text, size_t pos, int width, unsigned& value) {
+        value = 0;
+        for (int i = 0; i < width; ++i) {
+            char c = text[pos + i];
+            if (c < '0' || c > '9') {
+                return false;
+            }
+            value = value * 10 + static_cast<unsigned>(c - '0');
+        }
+        return true;
+    }
+}
+
+namespace Timestamp {
+
+    // 公历日期 -> 距1970-01-01的天数
+    int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+        y -= m <= 2;
+        const int64_t era = (y >= 0 ? y : y - 399) / 400;
+        const unsigned yoe = static_cast<unsigned>(y - era * 400);
+        const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + static_cast<int64_t>(doe) - 719468;
+    }
+
+    // 距1970-01-01的天数 -> 公历日期
+    void civilFromDays(int64_t z, int64_t& y, unsigned& m, unsigned& d) {
+        z += 719468;
+        const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+        const unsigned doe = static_cast<unsigned>(z - era * 146097);
+        const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const unsigned mp = (5 * doy + 2) / 153;
+        d = doy - (153 * mp + 2) / 5 + 1;
+        m = mp < 10 ? mp + 3 : mp - 9;
+        y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+    }
+
+    int64_t nowMicros() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    int64_t toLocalSeconds(int64_t micros) {
+        int64_t utcSeconds = floorDiv(micros, MICROS_PER_SECOND);
+        return utcSeconds + localOffset(utcSeconds);
+    }
+
+    void formatTo(int64_t micros, char* out) {
+        int64_t localSeconds = toLocalSeconds(micros);
+        int64_t days = floorDiv(localSeconds, SECONDS_PER_DAY);
+        unsigned secondOfDay = static_cast<unsigned>(localSeconds - days * SECONDS_PER_DAY);
+
+        int64_t year;
+        unsigned month, day;
+        civilFromDays(days, year, month, day);
+
+        putDigits(out, static_cast<unsigned>(year), 4);
+        out[4] = '-';
+        putDigits(out + 5, month, 2);
+        out[7] = '-';
+        putDigits(out + 8, day, 2);
+        out[10] = ' ';
+        putDigits(out + 11, secondOfDay / 3600, 2);
+        out[13] = ':';
+        putDigits(out + 14, secondOfDay / 60 % 60, 2);
+        out[16] = ':';
+        putDigits(out + 17, secondOfDay % 60, 2);
+    }
+
+    std::string format(int64_t micros) {
+        std::string text(19, ' ');
+        formatTo(micros, &text[0]);
+        return text;
+    }
+
+    size_t formatPreciseTo(int64_t micros, char* out) {
+        formatTo(micros, out);
+        unsigned fraction = static_cast<unsigned>(micros - floorDiv(micros, MICROS_PER_SECOND) * MICROS_PER_SECOND);
+        if (fraction == 0) {
+            return 19;
+        }
+        out[19] = '.';
+        putDigits(out + 20, fraction, 6);
+        return PRECISE_LENGTH;
+    }
+
+    bool parse(std::string_view text, int64_t& micros) {
+        size_t begin = text.find_first_not_of(" \t\r\n");
+        size_t end = text.find_last_not_of(" \t\r\n");
+        if (begin == std::string_view::npos) {
+            return false;
+        }
+        text = text.substr(begin, end - begin + 1);
+        
+        // 秒后的小数部分：1~6位，不足6位时按十进制小数补齐
+        unsigned fraction = 0;
+        if (text.size() > 19) {
+            int digits = static_cast<int>(text.size() - 20);
+            if (text[19] != '.' || digits < 1 || digits > 6 || !readDigits(text, 20, digits, fraction)) {
+                return false;
+            }
+            for (int i = digits; i < 6; ++i) {
+                fraction *= 10;
+            }
+        } else if (text.size() != 19) {
+            return false;
+        }
+        if (text[4] != '-' || text[7] != '-' || text[10] != ' ' || text[13] != ':' || text[16] != ':') {
+            return false;
+        }
+
+        unsigned year, month, day, hour, minute, second;
+        if (!readDigits(text, 0, 4, year) || !readDigits(text, 5, 2, month) || !readDigits(text, 8, 2, day) ||
+            !readDigits(text, 11, 2, hour) || !readDigits(text, 14, 2, minute) || !readDigits(text, 17, 2, second)) {
+            return false;
+        }
+        if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 59) {
+            return false;
+        }
+        int64_t days = daysFromCivil(year, month, day);
+        int64_t checkYear;
+        unsigned checkMonth, checkDay;
+        civilFromDays(days, checkYear, checkMonth, checkDay);
+        if (checkMonth != month || checkDay != day) {
+            return false;   // 例如2月30日
+        }
+
+        // 本地时间 -> UTC：先用本地时间本身估计偏移，再用估计出的UTC时刻修正一次
+        int64_t localSeconds = days * SECONDS_PER_DAY + hour * 3600 + minute * 60 + second;
+        int64_t guess = localSeconds - localOffset(localSeconds);
+        micros = (localSeconds - localOffset(guess)) * MICROS_PER_SECOND + fraction;
+        return true;
+    }
+}
@@ -0,0 +1,900 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <unordered_map>
+#include <map>
+#include "../include/Book.h"
+#include "../include/BookManager.h"
+#include "../include/SalesManager.h"
+#include "../include/ParallelLoader.h"
+#include "../include/StatisticsManager.h"
+#include "../include/StatsKernels.h"
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+#include <new>
+#include <ctime>
+
+// 计时辅助：返回两个时间点之间的纳秒数
+using Clock = std::chrono::steady_clock;
+
+static double elapsedNs(Clock::time_point start, Clock::time_point end) {
+    return static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+// 堆分配计数：替换全局operator new，统计查询路径上的分配次数和当前占用的字节数
+// 每块前面多分配16字节记下大小，释放时扣除
+static std::atomic<size_t> allocationCount(0);
+static std::atomic<size_t> liveHeapBytes(0);
+static const size_t ALLOCATION_HEADER = 16;
+
+void* operator new(size_t size) {
+    ++allocationCount;
+    if (char* p = static_cast<char*>(std::malloc(size + ALLOCATION_HEADER))) {
+        *reinterpret_cast<size_t*>(p) = size;
+        liveHeapBytes += size;
+        return p + ALLOCATION_HEADER;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    if (p) {
+        char* block = static_cast<char*>(p) - ALLOCATION_HEADER;
+        liveHeapBytes -= *reinterpret_cast<size_t*>(block);
+        std::free(block);
+    }
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+// 批量构造数据时屏蔽管理器的逐条提示输出
+class SilenceCout {
+private:
+    std::streambuf* saved;
+
+public:
+    SilenceCout() : saved(std::cout.rdbuf(nullptr)) {}
+    ~SilenceCout() { std::cout.rdbuf(saved); }
+};
+
+// 生成第i本图书的ISBN（978 + 9位序号 + 校验位）
+static std::string makeIsbn(size_t i) {
+    std::string digits = std::to_string(i);
+    std::string isbn = "978" + std::string(9 - digits.size(), '0') + digits;
+    int sum = 0;
+    for (size_t k = 0; k < 12; ++k) {
+        sum += (isbn[k] - '0') * (k % 2 == 0 ? 1 : 3);
+    }
+    return isbn + static_cast<char>('0' + (10 - sum % 10) % 10);
+}
+
+// 构造含有n本图书的书库
+static void populate(BookManager& manager, size_t n) {
+    SilenceCout silence;
+    for (size_t i = 0; i < n; ++i) {
+        manager.addBook(Book("书名" + std::to_string(i), "出版社" + std::to_string(i % 100),
+                             makeIsbn(i), "作者" + std::to_string(i % 5000),
+                             static_cast<int>(i % 50), 10.0 + static_cast<double>(i % 200)));
+    }
+}
+
+// ISBN点查询：哈希索引 vs 线性扫描
+void benchIsbnLookup(size_t n) {
+    BookManager manager;
+    populate(manager, n);
+    
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> dist(0, n - 1);
+    
+    const size_t indexedQueries = 1000000;
+    std::vector<std::string> keys;
+    keys.reserve(indexedQueries);
+    for (size_t i = 0; i < indexedQueries; ++i) {
+        keys.push_back(makeIsbn(dist(rng)));
+    }
+    
+    long long checksum = 0;
+    auto start = Clock::now();
+    for (const auto& key : keys) {
+        checksum += manager.getStock(key);
+    }
+    double indexedNs = elapsedNs(start, Clock::now()) / indexedQueries;
+    
+    // 线性扫描作为对照组，查询次数随规模缩小以控制总耗时
+    const auto& books = manager.getAllBooks();
+    const size_t scanQueries = std::max<size_t>(10, 2000000 / n);
+    start = Clock::now();
+    for (size_t q = 0; q < scanQueries; ++q) {
+        IsbnKey key = IsbnKey::parse(keys[q]);
+        for (const auto& book : books) {
+            if (book.getIsbnKey() == key) {
+                checksum += book.getStock();
+                break;
+            }
+        }
+    }
+    double scanNs = elapsedNs(start, Clock::now()) / scanQueries;
+    
+    std::cout << std::setw(9) << n << " 本"
+              << " | 哈希索引: " << std::fixed << std::setprecision(1) << std::setw(10) << indexedNs << " ns/次"
+              << " | 线性扫描: " << std::setw(12) << scanNs << " ns/次"
+              << " | (校验和 " << checksum << ")" << std::endl;
+}
+
+// 出版社精确查询：二级索引 vs 线性扫描
+void benchPublisherQuery(size_t n) {
+    BookManager manager;
+    populate(manager, n);
+    
+    const size_t queries = 100000;
+    size_t matches = 0;
+    auto start = Clock::now();
+    for (size_t q = 0; q < queries; ++q) {
+        matches += manager.findBooksByPublisher("出版社" + std::to_string(q % 100)).size();
+    }
+    double indexedNs = elapsedNs(start, Clock::now()) / queries;
+    
+    const auto& books = manager.getAllBooks();
+    const size_t scanQueries = 20;
+    start = Clock::now();
+    for (size_t q = 0; q < scanQueries; ++q) {
+        std::string key = "出版社" + std::to_string(q % 100);
+        std::vector<const Book*> result;
+        for (const auto& book : books) {
+            if (book.getPublisher() == key) {
+                result.push_back(&book);
+            }
+        }
+        matches += result.size();
+    }
+    double scanNs = elapsedNs(start, Clock::now()) / scanQueries;
+    
+    std::cout << std::setw(9) << n << " 本"
+              << " | 二级索引: " << std::fixed << std::setprecision(1) << std::setw(10) << indexedNs << " ns/次"
+              << " | 线性扫描: " << std::setw(12) << scanNs << " ns/次"
+              << " | (命中 " << matches << ")" << std::endl;
+}
+
+// 旧实现：std::getline + stringstream 逐行解析
+static size_t legacyLoadSales(const std::string& filename) {
+    std::ifstream file(filename);
+    std::vector<std::shared_ptr<SaleRecord>> records;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::stringstream ss(line);
+        std::string isbn, title, temp, time;
+        std::getline(ss, isbn, '|');
+        std::getline(ss, title, '|');
+        std::getline(ss, temp, '|');
+        int quantity = std::stoi(temp);
+        std::getline(ss, temp, '|');
+        double total = std::stod(temp);
+        std::getline(ss, time);
+        SaleRecord record(IsbnKey::parse(isbn), title, quantity, total / quantity);
+        record.setSaleTime(time);
+        records.push_back(std::make_shared<SaleRecord>(record));
+    }
+    return records.size();
+}
+
+// 销售记录文件加载：旧的逐行解析 vs 分块并行解析
+void benchSalesLoad(size_t lines) {
+    const std::string filename = "benchmark_sales.txt";
+    {
+        std::ofstream file(filename);
+        for (size_t i = 0; i < lines; ++i) {
+            file << makeIsbn(i % 100000) << "|书名" << (i % 100000) << "|" << (i % 5 + 1) << "|"
+                 << (i % 5 + 1) * 59.9 << "|2024-01-06 10:30:25\n";
+        }
+    }
+    
+    auto start = Clock::now();
+    size_t legacy = legacyLoadSales(filename);
+    double legacyMs = elapsedNs(start, Clock::now()) / 1e6;
+    std::cout << std::setw(9) << lines << " 行 | getline+stringstream: "
+              << std::fixed << std::setprecision(1) << legacyMs << " ms" << std::endl;
+    
+    for (unsigned threads : {1u, 2u, 4u, 8u}) {
+        std::vector<SaleRecord> records;
+        start = Clock::now();
+        ParallelLoader(threads).loadSaleRecords(filename, records);
+        double ms = elapsedNs(start, Clock::now()) / 1e6;
+        std::cout << "          并行分块 " << threads << " 线程: " << ms << " ms"
+                  << (records.size() == legacy ? "" : " (结果不一致!)") << std::endl;
+    }
+    std::remove(filename.c_str());
+}
+
+// 价格/库存汇总统计：StatisticsManager（增量维护，O(1)读取） vs 逐本扫描图书对象
+void benchStatistics(size_t n) {
+    BookManager manager;
+    populate(manager, n);
+    SalesManager sales(&manager);
+    StatisticsManager statistics(&manager, &sales);
+    
+    const size_t rounds = std::max<size_t>(5, 20000000 / n);
+    double checksum = 0.0;
+    auto start = Clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        auto price = statistics.getPriceStatistics();
+        auto stock = statistics.getStockStatistics();
+        checksum += price.totalValue + price.maxPrice - price.minPrice + price.avgPrice
+                    + stock.totalStock + stock.maxStock - stock.minStock;
+    }
+    double columnNs = elapsedNs(start, Clock::now()) / rounds;
+    
+    // 对照组：原实现的做法
+    start = Clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        const auto& books = manager.getAllBooks();
+        double totalValue = 0.0, maxPrice = books[0].getPrice(), minPrice = books[0].getPrice(), sum = 0.0;
+        int totalStock = 0, maxStock = books[0].getStock(), minStock = books[0].getStock();
+        for (const auto& book : books) {
+            double price = book.getPrice();
+            sum += price;
+            totalValue += price * book.getStock();
+            if (price > maxPrice) maxPrice = price;
+            if (price < minPrice) minPrice = price;
+        }
+        for (const auto& book : books) {
+            int stock = book.getStock();
+            totalStock += stock;
+            if (stock > maxStock) maxStock = stock;
+            if (stock < minStock) minStock = stock;
+        }
+        checksum += totalValue + maxPrice - minPrice + sum / books.size()
+                    + totalStock + maxStock - minStock;
+    }
+    double pointerNs = elapsedNs(start, Clock::now()) / rounds;
+    
+    std::cout << std::setw(9) << n << " 本"
+              << " | 统计读取: " << std::fixed << std::setprecision(1) << std::setw(12) << columnNs / 1000 << " us/次"
+              << " | 逐本扫描: " << std::setw(12) << pointerNs / 1000 << " us/次"
+              << " | (校验和 " << std::setprecision(0) << checksum << ")" << std::endl;
+}
+
+// 融合聚合内核：标量 / SSE2 / AVX2 各实现对比，另附原来的两遍标量扫描作对照
+void benchStatsKernels(size_t n) {
+    std::vector<double> price(n);
+    std::vector<int> stock(n);
+    for (size_t i = 0; i < n; ++i) {
+        price[i] = 10.0 + static_cast<double>(i % 200);
+        stock[i] = static_cast<int>(i % 50);
+    }
+    const size_t rounds = std::max<size_t>(5, 50000000 / n);
+    double checksum = 0.0;
+    
+    auto start = Clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        double sum = 0.0, value = 0.0, maxPrice = price[0], minPrice = price[0];
+        for (size_t i = 0; i < n; ++i) {
+            sum += price[i];
+            value += price[i] * stock[i];
+            maxPrice = price[i] > maxPrice ? price[i] : maxPrice;
+            minPrice = price[i] < minPrice ? price[i] : minPrice;
+        }
+        int totalStock = 0, maxStock = stock[0], minStock = stock[0];
+        for (size_t i = 0; i < n; ++i) {
+            totalStock += stock[i];
+            maxStock = stock[i] > maxStock ? stock[i] : maxStock;
+            minStock = stock[i] < minStock ? stock[i] : minStock;
+        }
+        checksum += sum + value + maxPrice - minPrice + totalStock + maxStock - minStock;
+    }
+    double twoPassUs = elapsedNs(start, Clock::now()) / rounds / 1000;
+    
+    std::cout << std::setw(9) << n << " 本 | 两遍标量: " << std::fixed << std::setprecision(1)
+              << std::setw(9) << twoPassUs << " us";
+    for (auto kernel : {StatsKernels::Kernel::Scalar, StatsKernels::Kernel::SSE2, StatsKernels::Kernel::AVX2}) {
+        if (!StatsKernels::isSupported(kernel)) {
+            continue;
+        }
+        start = Clock::now();
+        for (size_t r = 0; r < rounds; ++r) {
+            auto total = StatsKernels::aggregateWith(kernel, price.data(), stock.data(), n);
+            checksum += total.priceSum + total.totalValue + total.priceMax - total.priceMin
+                        + total.stockSum + total.stockMax - total.stockMin;
+        }
+        double us = elapsedNs(start, Clock::now()) / rounds / 1000;
+        std::cout << " | " << StatsKernels::kernelName(kernel) << ": " << std::setw(9) << us << " us";
+    }
+    std::cout << " | (校验和 " << std::setprecision(0) << checksum << ")" << std::endl;
+}
+
+// 价格前20名：部分选择 vs 复制指针数组后完整排序
+void benchTopK(size_t n) {
+    BookManager manager;
+    populate(manager, n);
+    const size_t rounds = std::max<size_t>(3, 2000000 / n);
+    size_t checksum = 0;
+    
+    auto start = Clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        checksum += manager.topKByPrice(20).size();
+    }
+    double topKUs = elapsedNs(start, Clock::now()) / rounds / 1000;
+    
+    start = Clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        std::vector<const Book*> books;
+        books.reserve(manager.getAllBooks().size());
+        for (const auto& book : manager.getAllBooks()) {
+            books.push_back(&book);
+        }
+        std::sort(books.begin(), books.end(), [](const Book* a, const Book* b) {
+            return a->getPrice() > b->getPrice();
+        });
+        checksum += books.size() > 20 ? 20 : books.size();
+    }
+    double sortUs = elapsedNs(start, Clock::now()) / rounds / 1000;
+    
+    std::cout << std::setw(9) << n << " 本"
+              << " | topKByPrice(20): " << std::fixed << std::setprecision(1) << std::setw(10) << topKUs << " us"
+              << " | 完整排序: " << std::setw(10) << sortUs << " us"
+              << " | (校验和 " << checksum << ")" << std::endl;
+}
+
+// 价格区间查询：有序索引 vs 全表扫描
+void benchPriceRange(size_t n) {
+    BookManager manager;
+    populate(manager, n);
+    const size_t rounds = std::max<size_t>(3, 2000000 / n);
+    size_t indexed = 0, scanned = 0;
+    
+    // 价格区间[30, 31]只覆盖约1%的图书
+    auto start = Clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        indexed += manager.findBooksByPriceRange(30.0, 31.0).size();
+    }
+    double indexUs = elapsedNs(start, Clock::now()) / rounds / 1000;
+    
+    start = Clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        for (const auto& book : manager.getAllBooks()) {
+            if (book.getPrice() >= 30.0 && book.getPrice() <= 31.0) {
+                ++scanned;
+            }
+        }
+    }
+    double scanUs = elapsedNs(start, Clock::now()) / rounds / 1000;
+    
+    std::cout << std::setw(9) << n << " 本"
+              << " | 有序索引: " << std::fixed << std::setprecision(1) << std::setw(10) << indexUs << " us"
+              << " | 全表扫描: " << std::setw(10) << scanUs << " us"
+              << (indexed == scanned ? "" : " (结果不一致!)") << std::endl;
+}
+
+// 只读遍历全部图书：旧接口（按值返回shared_ptr数组，逐个增减引用计数） vs 只读引用
+void benchReadAccess(size_t n) {
+    BookManager manager;
+    populate(manager, n);
+    std::vector<std::shared_ptr<Book>> legacy;
+    for (const auto& book : manager.getAllBooks()) {
+        legacy.push_back(std::make_shared<Book>(book));
+    }
+    const size_t rounds = std::max<size_t>(5, 10000000 / n);
+    long long checksum = 0;
+    
+    auto start = Clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        auto books = legacy;    // 原来的getAllBooks()
+        for (const auto& book : books) {
+            checksum += book->getStock();
+        }
+    }
+    double legacyUs = elapsedNs(start, Clock::now()) / rounds / 1000;
+    
+    start = Clock::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        for (const auto& book : manager.getAllBooks()) {
+            checksum += book.getStock();
+        }
+    }
+    double valueUs = elapsedNs(start, Clock::now()) / rounds / 1000;
+    
+    std::cout << std::setw(9) << n << " 本"
+              << " | 复制shared_ptr数组: " << std::fixed << std::setprecision(1) << std::setw(10) << legacyUs << " us"
+              << " | 只读引用: " << std::setw(10) << valueUs << " us"
+              << " | (校验和 " << checksum << ")" << std::endl;
+}
+
+// 按书名逐本查找时的堆分配次数：旧getter按值返回（每次比较复制一份书名） vs 常量引用
+void benchSearchAllocations(size_t n) {
+    BookManager manager;
+    {
+        SilenceCout silence;
+        for (size_t i = 0; i < n; ++i) {
+            // 书名长度超过短字符串优化的容量，按值返回时必然分配
+            manager.addBook(Book("数据结构与算法分析（第" + std::to_string(i) + "版）", "出版社", makeIsbn(i),
+                                 "作者", 1, 10.0));
+        }
+    }
+    const std::string key = "数据结构与算法分析（第" + std::to_string(n / 2) + "版）";
+    const auto& books = manager.getAllBooks();
+    size_t hits = 0;
+    
+    size_t before = allocationCount.load();
+    auto start = Clock::now();
+    for (const auto& book : books) {
+        std::string title = book.getTitle();    // 原来getTitle()的返回方式
+        hits += title == key;
+    }
+    double copyUs = elapsedNs(start, Clock::now()) / 1000;
+    size_t copyAllocations = allocationCount.load() - before;
+    
+    before = allocationCount.load();
+    start = Clock::now();
+    for (const auto& book : books) {
+        hits += book.getTitle() == key;
+    }
+    double refUs = elapsedNs(start, Clock::now()) / 1000;
+    size_t refAllocations = allocationCount.load() - before;
+    
+    // 索引查询路径（ISBN点查与出版社精确查询）同样不应分配
+    const std::string isbn = makeIsbn(n / 3);
+    const std::string publisher = "出版社";
+    before = allocationCount.load();
+    hits += manager.getStock(isbn) > 0;
+    hits += manager.findBooksByPublisher(publisher).size();
+    size_t indexAllocations = allocationCount.load() - before;
+    
+    std::cout << std::setw(9) << n << " 本"
+              << " | 按值返回: " << std::fixed << std::setprecision(1) << std::setw(9) << copyUs << " us, "
+              << copyAllocations << " 次分配"
+              << " | 常量引用: " << std::setw(9) << refUs << " us, " << refAllocations << " 次分配"
+              << " | 索引查询: " << indexAllocations << " 次分配"
+              << " | (命中 " << hits << ")" << std::endl;
+}
+
+// 作者/出版社驻留前后的内存占用（堆上的字节数）
+// 对照组是驻留之前的图书布局：四个字段都是各自独立的std::string
+struct LegacyBook {
+    std::string title;
+    std::string publisher;
+    std::string isbn;
+    std::string author;
+    int stock;
+    double price;
+    int reorderThreshold;
+};
+
+void benchCatalogMemory(size_t n) {
+    // 作者约为图书的1/20，出版社只有几百家（名称超过短字符串优化的容量）
+    auto publisherOf = [](size_t i) { return "第" + std::to_string(i % 300) + "大学出版社"; };
+    auto authorOf = [n](size_t i) { return "作者" + std::to_string((i * 7919) % (n / 20 + 1)); };
+    
+    size_t base = liveHeapBytes.load();
+    double legacyMb;
+    {
+        std::vector<LegacyBook> legacy;
+        legacy.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            legacy.push_back({"书名" + std::to_string(i), publisherOf(i), makeIsbn(i), authorOf(i),
+                              static_cast<int>(i % 50), 10.0 + static_cast<double>(i % 200), 0});
+        }
+        legacyMb = (liveHeapBytes.load() - base) / 1048576.0;
+    }
+    
+    base = liveHeapBytes.load();
+    size_t poolBase = Book::authorPool().memoryUsage() + Book::publisherPool().memoryUsage();
+    std::vector<Book> books;
+    books.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        books.emplace_back("书名" + std::to_string(i), publisherOf(i), makeIsbn(i), authorOf(i),
+                           static_cast<int>(i % 50), 10.0 + static_cast<double>(i % 200));
+    }
+    double internedMb = (liveHeapBytes.load() - base) / 1048576.0;
+    double poolMb = (Book::authorPool().memoryUsage() + Book::publisherPool().memoryUsage() - poolBase) / 1048576.0;
+    
+    // 按作者查询：比较编号 vs 比较字符串
+    const std::string key = authorOf(n / 2);
+    StringPool::Id keyId = Book::authorPool().find(key);
+    size_t hits = 0;
+    auto start = Clock::now();
+    for (const auto& book : books) {
+        hits += book.getAuthorId() == keyId;
+    }
+    double idUs = elapsedNs(start, Clock::now()) / 1000;
+    start = Clock::now();
+    for (const auto& book : books) {
+        hits += book.getAuthor() == key;
+    }
+    double stringUs = elapsedNs(start, Clock::now()) / 1000;
+    
+    std::cout << std::setw(9) << n << " 本"
+              << " | 独立字符串: " << std::fixed << std::setprecision(1) << std::setw(7) << legacyMb << " MB"
+              << " | 驻留编号: " << std::setw(7) << internedMb << " MB（其中驻留池 " << poolMb << " MB）"
+              << " | 按作者扫描 编号/字符串: " << idUs << " / " << stringUs << " us"
+              << " | (命中 " << hits << ")" << std::endl;
+}
+
+// 销售记录的构造开销与内存占用
+// 对照组是改成定长结构之前的布局：ISBN、书名和销售时间都是std::string，构造时用localtime+put_time生成时间文本
+struct LegacySaleRecord {
+    std::string isbn;
+    std::string bookTitle;
+    int quantity;
+    double totalPrice;
+    std::string saleTime;
+    
+    LegacySaleRecord(const std::string& isbn, const std::string& bookTitle, int quantity, double price)
+        : isbn(isbn), bookTitle(bookTitle), quantity(quantity), totalPrice(quantity * price) {
+        auto now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        auto tm = *std::localtime(&now);
+        std::stringstream ss;
+        ss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
+        saleTime = ss.str();
+    }
+};
+
+void benchSaleRecordCost(size_t n) {
+    // 书名只有几千种（与热销书的数量级相当），与实际销售流水一致
+    std::vector<std::string> isbns, titles;
+    for (size_t i = 0; i < 5000; ++i) {
+        isbns.push_back(makeIsbn(i));
+        titles.push_back("数据结构与算法分析第" + std::to_string(i) + "版");
+    }
+    
+    size_t base = liveHeapBytes.load();
+    double legacyNs, legacyBytes;
+    {
+        std::vector<LegacySaleRecord> legacy;
+        legacy.reserve(n);
+        auto start = Clock::now();
+        for (size_t i = 0; i < n; ++i) {
+            legacy.emplace_back(isbns[i % 5000], titles[i % 5000], static_cast<int>(i % 5 + 1), 59.9);
+        }
+        legacyNs = elapsedNs(start, Clock::now()) / n;
+        legacyBytes = static_cast<double>(liveHeapBytes.load() - base) / n;
+    }
+    
+    base = liveHeapBytes.load();
+    std::vector<IsbnKey> keys;
+    for (const auto& isbn : isbns) {
+        keys.push_back(IsbnKey::parse(isbn));
+    }
+    std::vector<SaleRecord> records;
+    records.reserve(n);
+    auto start = Clock::now();
+    for (size_t i = 0; i < n; ++i) {
+        records.emplace_back(keys[i % 5000], titles[i % 5000], static_cast<int>(i % 5 + 1), 59.9);
+    }
+    double compactNs = elapsedNs(start, Clock::now()) / n;
+    double compactBytes = static_cast<double>(liveHeapBytes.load() - base) / n;
+    
+    // 只在导出时格式化
+    start = Clock::now();
+    size_t exported = 0;
+    for (const auto& record : records) {
+        exported += record.toString().size();
+    }
+    double exportNs = elapsedNs(start, Clock::now()) / n;
+    
+    std::cout << std::setw(9) << n << " 条"
+              << " | 旧布局: " << std::fixed << std::setprecision(1) << std::setw(7) << legacyNs << " ns/条, "
+              << std::setw(6) << legacyBytes << " 字节/条"
+              << " | 定长记录: " << std::setw(6) << compactNs << " ns/条, " << std::setw(5) << compactBytes << " 字节/条"
+              << " | 导出格式化: " << exportNs << " ns/条"
+              << " | (" << exported << " 字符)" << std::endl;
+}
+
+// 单本书的销售历史与畅销排行：按ISBN的汇总/倒排表 vs 扫描全部销售记录
+void benchSalesByIsbn(size_t n) {
+    const size_t titles = 10000;
+    BookManager bookManager;
+    SalesManager salesManager(&bookManager);
+    std::vector<IsbnKey> keys;
+    for (size_t i = 0; i < titles; ++i) {
+        keys.push_back(IsbnKey::parse(makeIsbn(i)));
+    }
+    std::mt19937 rng(7);
+    for (size_t i = 0; i < n; ++i) {
+        // 销量偏向前面的图书
+        size_t t = std::min(rng() % titles, rng() % titles);
+        salesManager.restoreSaleRecord(SaleRecord(keys[t], "书名", static_cast<int>(i % 3 + 1), 30.0));
+    }
+    
+    const int queries = 200;
+    size_t hits = 0;
+    auto start = Clock::now();
+    for (int q = 0; q < queries; ++q) {
+        hits += salesManager.getSaleRecordsByIsbn(keys[(q * 37) % titles]).size();
+    }
+    double postingUs = elapsedNs(start, Clock::now()) / queries / 1000;
+    start = Clock::now();
+    for (int q = 0; q < queries; ++q) {
+        IsbnKey key = keys[(q * 37) % titles];
+        for (const auto& record : salesManager.getAllSaleRecords()) {
+            hits += record.getIsbnKey() == key;
+        }
+    }
+    double scanUs = elapsedNs(start, Clock::now()) / queries / 1000;
+    
+    // 畅销前10：部分排序各ISBN的汇总 vs 逐条累加销量再排序
+    start = Clock::now();
+    auto best = salesManager.getBestSellers(10);
+    double bestUs = elapsedNs(start, Clock::now()) / 1000;
+    start = Clock::now();
+    std::unordered_map<IsbnKey, int> units;
+    for (const auto& record : salesManager.getAllSaleRecords()) {
+        units[record.getIsbnKey()] += record.getQuantity();
+    }
+    std::vector<std::pair<int, IsbnKey>> ranked;
+    for (const auto& entry : units) {
+        ranked.emplace_back(entry.second, entry.first);
+    }
+    std::partial_sort(ranked.begin(), ranked.begin() + std::min<size_t>(10, ranked.size()), ranked.end(),
+                      [](const std::pair<int, IsbnKey>& a, const std::pair<int, IsbnKey>& b) { return a.first > b.first; });
+    double regroupUs = elapsedNs(start, Clock::now()) / 1000;
+    hits += best[0]->unitsSold == ranked[0].first;
+    
+    std::cout << std::setw(9) << n << " 条"
+              << " | 销售历史 倒排表/扫描: " << std::fixed << std::setprecision(1) << postingUs << " / "
+              << std::setw(8) << scanUs << " us"
+              << " | 畅销前10 汇总/重新累加: " << bestUs << " / " << regroupUs << " us"
+              << " | (命中 " << hits << ")" << std::endl;
+}
+
+// 按月按出版社的销售额：时间分桶预汇总 vs 逐条换算月份、查出版社再分组
+void benchSalesRollup(size_t n) {
+    const size_t titles = 2000;
+    BookManager bookManager;
+    {
+        SilenceCout silence;
+        for (size_t i = 0; i < titles; ++i) {
+            bookManager.addBook(Book("书名" + std::to_string(i), "第" + std::to_string(i % 50) + "出版社",
+                                     makeIsbn(i), "作者", 1000000, 30.0));
+        }
+    }
+    std::vector<IsbnKey> keys;
+    for (size_t i = 0; i < titles; ++i) {
+        keys.push_back(IsbnKey::parse(makeIsbn(i)));
+    }
+    
+    // 一年的销售，时间均匀分布
+    SalesManager salesManager(&bookManager);
+    int64_t yearStart;
+    Timestamp::parse("2024-01-01 00:00:00", yearStart);
+    const int64_t yearMicros = int64_t(366) * 86400 * Timestamp::MICROS_PER_SECOND;
+    std::vector<SaleRecord> records;
+    records.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        SaleRecord record(keys[(i * 7919) % titles], "书名", static_cast<int>(i % 3 + 1), 30.0);
+        record.setTimestamp(yearStart + static_cast<int64_t>(i) * (yearMicros / static_cast<int64_t>(n)));
+        records.push_back(record);
+    }
+    SalesRollup standalone;
+    auto start = Clock::now();
+    for (const auto& record : records) {
+        standalone.add(record, StringPool::EMPTY);
+    }
+    double addNs = elapsedNs(start, Clock::now()) / n;
+    for (const auto& record : records) {
+        salesManager.restoreSaleRecord(record);
+    }
+    
+    const int64_t march = SalesRollup::monthBucket(2024, 3);
+    start = Clock::now();
+    auto byPublisher = salesManager.getRollup().getTotalsByPublisher(SalesRollup::Granularity::Month, march, march);
+    double rollupUs = elapsedNs(start, Clock::now()) / 1000;
+    
+    start = Clock::now();
+    std::map<std::string_view, int64_t> scanned;
+    for (const auto& record : salesManager.getAllSaleRecords()) {
+        if (SalesRollup::bucketOf(SalesRollup::Granularity::Month, record.getTimestamp()) == march) {
+            scanned[bookManager.findBookByIsbn(record.getIsbnKey())->getPublisher()] += record.getTotalCents();
+        }
+    }
+    double scanUs = elapsedNs(start, Clock::now()) / 1000;
+    bool same = byPublisher.size() == scanned.size()
+                && byPublisher.front().second.revenueCents == scanned.begin()->second;
+    
+    std::cout << std::setw(9) << n << " 条"
+              << " | 三月按出版社 预汇总/逐条扫描: " << std::fixed << std::setprecision(1) << rollupUs << " / "
+              << std::setw(9) << scanUs << " us"
+              << " | 每条记录的汇总开销: " << addNs << " ns"
+              << " | (" << byPublisher.size() << " 家出版社，" << (same ? "结果一致" : "结果不一致") << ")" << std::endl;
+}
+
+// 按时间区间取销售记录：二分查找到区间两端 vs 逐条格式化时间再比较字符串（旧做法）/逐条比较时间戳
+void benchSaleTimeRange(size_t n) {
+    BookManager bookManager;
+    SalesManager salesManager(&bookManager);
+    IsbnKey key = IsbnKey::parse(makeIsbn(1));
+    int64_t yearStart;
+    Timestamp::parse("2024-01-01 00:00:00", yearStart);
+    const int64_t step = int64_t(366) * 86400 * Timestamp::MICROS_PER_SECOND / static_cast<int64_t>(n);
+    for (size_t i = 0; i < n; ++i) {
+        SaleRecord record(key, "书名", 1, 30.0);
+        record.setTimestamp(yearStart + static_cast<int64_t>(i) * step);
+        salesManager.restoreSaleRecord(record);
+    }
+    
+    // 一周的窗口
+    const std::string from = "2024-06-01 00:00:00", to = "2024-06-08 00:00:00";
+    int64_t fromMicros, toMicros;
+    Timestamp::parse(from, fromMicros);
+    Timestamp::parse(to, toMicros);
+    
+    const int queries = 1000;
+    int64_t cents = 0;
+    auto start = Clock::now();
+    for (int q = 0; q < queries; ++q) {
+        cents += static_cast<int64_t>(salesManager.getSaleRecordsBetween(fromMicros, toMicros).size());
+    }
+    double searchNs = elapsedNs(start, Clock::now()) / queries;
+    
+    // 逐条迭代整个窗口（不生成结果数组）
+    start = Clock::now();
+    for (const SaleRecord& record : salesManager.getSaleRecordsBetween(fromMicros, toMicros)) {
+        cents += record.getTotalCents();
+    }
+    double streamUs = elapsedNs(start, Clock::now()) / 1000;
+    
+    start = Clock::now();
+    size_t matches = 0;
+    for (const auto& record : salesManager.getAllSaleRecords()) {
+        matches += record.getTimestamp() >= fromMicros && record.getTimestamp() < toMicros;
+    }
+    double scanUs = elapsedNs(start, Clock::now()) / 1000;
+    
+    start = Clock::now();
+    for (const auto& record : salesManager.getAllSaleRecords()) {
+        std::string time = record.getSaleTime();
+        matches += time >= from && time < to;
+    }
+    double stringUs = elapsedNs(start, Clock::now()) / 1000;
+    
+    std::cout << std::setw(9) << n << " 条"
+              << " | 定位区间: " << std::fixed << std::setprecision(1) << std::setw(6) << searchNs << " ns"
+              << " | 遍历窗口: " << std::setw(7) << streamUs << " us"
+              << " | 全表扫描 时间戳/字符串: " << scanUs << " / " << stringUs << " us"
+              << " | (命中 " << matches << "，" << cents << ")" << std::endl;
+}
+
+// 一篮多本的购买：逐行purchaseBook（每行一帧日志、一次输出）vs purchaseBatch（一整篮一帧）
+void benchPurchaseBatch(size_t basketSize) {
+    const size_t books = 10000, baskets = 2000;
+    BookManager bookManager;
+    {
+        SilenceCout silence;
+        for (size_t i = 0; i < books; ++i) {
+            bookManager.addBook(Book("书名" + std::to_string(i), "出版社" + std::to_string(i % 100), makeIsbn(i),
+                                     "作者" + std::to_string(i % 5000), 1000000, 10.0 + static_cast<double>(i % 200)));
+        }
+    }
+    std::vector<std::vector<PurchaseLine>> orders(baskets);
+    for (size_t b = 0; b < baskets; ++b) {
+        for (size_t l = 0; l < basketSize; ++l) {
+            orders[b].push_back(PurchaseLine{makeIsbn((b * basketSize + l) * 7919 % books), 1 + static_cast<int>(l % 3)});
+        }
+    }
+    
+    // 日志不fsync，只比较每帧的写入开销
+    auto run = [&](bool batched) {
+        const std::string journalFile = "bench_batch.journal";
+        std::remove(journalFile.c_str());
+        SalesJournal journal;
+        journal.setSyncPolicy(SalesJournal::SyncPolicy::None);
+        journal.open(journalFile);
+        SalesManager salesManager(&bookManager);
+        salesManager.attachJournal(&journal);
+        auto start = Clock::now();
+        if (batched) {
+            for (const auto& order : orders) {
+                salesManager.purchaseBatch(order);
+            }
+        } else {
+            SilenceCout silence;
+            for (const auto& order : orders) {
+                for (const auto& line : order) {
+                    salesManager.purchaseBook(line.isbn, line.quantity);
+                }
+            }
+        }
+        double us = elapsedNs(start, Clock::now()) / 1000 / baskets;
+        journal.close();
+        std::remove(journalFile.c_str());
+        return std::make_pair(us, salesManager.getTotalSales());
+    };
+    auto looped = run(false);
+    auto batched = run(true);
+    
+    std::cout << "每篮 " << std::setw(3) << basketSize << " 本"
+              << " | 逐行购买: " << std::fixed << std::setprecision(2) << std::setw(8) << looped.first << " us/篮"
+              << " | 批量购买: " << std::setw(8) << batched.first << " us/篮"
+              << " | 加速: " << std::setprecision(1) << looped.first / batched.first << "x"
+              << " | (" << std::setprecision(2) << looped.second << " / " << batched.second << ")" << std::endl;
+}
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "     图书管理系统性能基准测试" << std::endl;
+    std::cout << "========================================" << std::endl;
+    
+    std::cout << "\n=== ISBN 点查询 ===" << std::endl;
+    for (size_t n : {10000, 100000, 1000000}) {
+        benchIsbnLookup(n);
+    }
+    
+    std::cout << "\n=== 出版社精确查询 ===" << std::endl;
+    for (size_t n : {10000, 100000, 1000000}) {
+        benchPublisherQuery(n);
+    }
+    
+    std::cout << "\n=== 价格/库存汇总统计 ===" << std::endl;
+    for (size_t n : {10000, 100000, 1000000}) {
+        benchStatistics(n);
+    }
+    
+    std::cout << "\n=== 融合聚合内核（当前选用 " << StatsKernels::kernelName(StatsKernels::bestKernel()) << "） ===" << std::endl;
+    for (size_t n : {10000, 100000, 1000000}) {
+        benchStatsKernels(n);
+    }
+    
+    std::cout << "\n=== 价格排行前20名 ===" << std::endl;
+    for (size_t n : {10000, 100000, 1000000}) {
+        benchTopK(n);
+    }
+    
+    std::cout << "\n=== 价格区间查询 ===" << std::endl;
+    for (size_t n : {10000, 100000, 1000000}) {
+        benchPriceRange(n);
+    }
+    
+    std::cout << "\n=== 只读遍历全部图书 ===" << std::endl;
+    for (size_t n : {10000, 100000, 1000000}) {
+        benchReadAccess(n);
+    }
+    
+    std::cout << "\n=== 按书名逐本查找的堆分配 ===" << std::endl;
+    for (size_t n : {10000, 100000, 1000000}) {
+        benchSearchAllocations(n);
+    }
+    
+    std::cout << "\n=== 作者/出版社驻留前后的内存占用 ===" << std::endl;
+    for (size_t n : {100000, 1000000}) {
+        benchCatalogMemory(n);
+    }
+    
+    std::cout << "\n=== 销售记录的构造开销与内存占用 ===" << std::endl;
+    for (size_t n : {100000, 1000000}) {
+        benchSaleRecordCost(n);
+    }
+    
+    std::cout << "\n=== 单本书的销售历史与畅销排行 ===" << std::endl;
+    for (size_t n : {100000, 1000000}) {
+        benchSalesByIsbn(n);
+    }
+    
+    std::cout << "\n=== 按月按出版社的销售额 ===" << std::endl;
+    for (size_t n : {100000, 1000000}) {
+        benchSalesRollup(n);
+    }
+    
+    std::cout << "\n=== 按时间区间取销售记录（一周的窗口） ===" << std::endl;
+    for (size_t n : {100000, 1000000}) {
+        benchSaleTimeRange(n);
+    }
+    
+    std::cout << "\n=== 批量购买 ===" << std::endl;
+    for (size_t basketSize : {1, 10, 50}) {
+        benchPurchaseBatch(basketSize);
+    }
+    
+    std::cout << "\n=== 销售记录文件加载 ===" << std::endl;
+    benchSalesLoad(2000000);
+    
+    return 0;
+}
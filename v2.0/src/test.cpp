@@ -4,6 +4,31 @@
 #include "../include/SalesManager.h"
 #include "../include/StatisticsManager.h"
 #include "../include/FileManager.h"
+#include "../include/ParallelLoader.h"
+#include "../include/AtomicFile.h"
+#include "../include/StatsKernels.h"
+#include "../include/ConcurrentCatalog.h"
+#include <stdexcept>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <limits>
+#include <cmath>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <ctime>
+#include <type_traits>
+#include <filesystem>
+
+// 断言辅助函数：通过时打印✓，失败时抛出异常并由main统一报告
+void check(bool condition, const std::string& message) {
+    if (!condition) {
+        throw std::runtime_error("✗ " + message);
+    }
+    std::cout << "✓ " << message << std::endl;
+}
 
 void testBookClass() {
     std::cout << "=== 测试 Book 类 ===" << std::endl;
@@ -166,6 +191,1522 @@ void testFileManager() {
     std::cout << std::endl;
 }
 
+void testIsbnIndex() {
+    std::cout << "=== 测试 ISBN 哈希索引 ===" << std::endl;
+    
+    BookManager manager;
+    manager.addBook(Book("C++程序设计", "清华大学出版社", "9787302168979", "谭浩强", 10, 59.90));
+    manager.addBook(Book("数据结构与算法", "人民邮电出版社", "9787115458563", "严蔚敏", 5, 45.00));
+    manager.addBook(Book("Java核心技术", "机械工业出版社", "9787111604732", "Cay S. Horstmann", 12, 119.00));
+    
+    // 删除中间的图书后，后面图书的下标前移，索引必须随之更新
+    manager.deleteBook("9787115458563");
+    check(manager.findBookByIsbn("9787115458563") == nullptr, "删除后无法再查到该ISBN");
+    check(manager.getStock("9787111604732") == 12, "删除后后续图书仍可通过索引查到");
+    check(manager.updateStock("9787111604732", -2) && manager.getStock("9787111604732") == 10,
+          "删除后按ISBN更新库存命中正确的图书");
+    
+    // 修改ISBN后旧键失效、新键生效
+    manager.updateBook("9787302168979",
+                       Book("C++程序设计(第2版)", "清华大学出版社", "9787302000000", "谭浩强", 8, 69.90));
+    check(manager.findBookByIsbn("9787302168979") == nullptr, "修改ISBN后旧ISBN失效");
+    auto renamed = manager.findBookByIsbn("9787302000000");
+    check(renamed && renamed->getTitle() == "C++程序设计(第2版)", "修改ISBN后新ISBN可查到");
+    check(!manager.addBook(Book("重复", "出版社", "9787302000000", "作者", 1, 1.0)), "新ISBN参与重复检查");
+    
+    // 清空后索引同步清空
+    manager.clear();
+    check(manager.findBookByIsbn("9787111604732") == nullptr, "清空后索引为空");
+    
+    // 从文件加载时重建索引并剔除重复ISBN
+    {
+        std::ofstream file("test_isbn_index.txt");
+        file << "书A|出版社|111|作者|1|10.00" << std::endl;
+        file << "书B|出版社|222|作者|2|20.00" << std::endl;
+        file << "书A-重复|出版社|111|作者|3|30.00" << std::endl;
+    }
+    manager.loadFromFile("test_isbn_index.txt");
+    std::remove("test_isbn_index.txt");
+    check(manager.getBookCount() == 2, "加载时跳过重复ISBN");
+    check(manager.findBookByIsbn("111")->getTitle() == "书A", "重复ISBN保留首次出现的记录");
+    check(manager.getStock("222") == 2, "加载后索引可用");
+    
+    std::cout << std::endl;
+}
+
+void testSecondaryIndex() {
+    std::cout << "=== 测试 书名/作者/出版社 二级索引 ===" << std::endl;
+    
+    BookManager manager;
+    manager.addBook(Book("C++程序设计", "清华大学出版社", "9787302168979", "谭浩强", 10, 59.90));
+    manager.addBook(Book("C语言程序设计", "清华大学出版社", "9787302224464", "谭浩强", 7, 33.00));
+    manager.addBook(Book("数据结构与算法", "人民邮电出版社", "9787115458563", "严蔚敏", 5, 45.00));
+    
+    check(manager.findBooksByAuthor("谭浩强").size() == 2, "按作者精确查询");
+    check(manager.findBooksByPublisher("清华大学出版社").size() == 2, "按出版社精确查询");
+    check(manager.findBooksByTitle("数据结构与算法").size() == 1, "按书名精确查询");
+    check(manager.findBooksByAuthor("不存在的作者").empty(), "查询不存在的键返回空视图");
+    
+    // 修改作者后旧键移除、新键加入
+    manager.updateBook("9787302224464",
+                       Book("C语言程序设计", "清华大学出版社", "9787302224464", "谭浩强等", 7, 33.00));
+    check(manager.findBooksByAuthor("谭浩强").size() == 1, "修改后旧作者键只剩一本");
+    check(manager.findBooksByAuthor("谭浩强等").size() == 1, "修改后新作者键可查到");
+    
+    // 删除后从所有二级索引中移除
+    manager.deleteBook("9787302168979");
+    check(manager.findBooksByAuthor("谭浩强").empty(), "删除后作者索引同步移除");
+    auto byPublisher = manager.findBooksByPublisher("清华大学出版社");
+    check(byPublisher.size() == 1 && byPublisher[0]->getIsbn() == "9787302224464", "删除后出版社索引同步移除");
+    
+    manager.clear();
+    check(manager.findBooksByPublisher("人民邮电出版社").empty(), "清空后二级索引为空");
+    
+    std::cout << std::endl;
+}
+
+void testParallelLoader() {
+    std::cout << "=== 测试 并行分块加载 ===" << std::endl;
+    
+    // 写入足够多的行，配合很小的分块让每个线程都分到数据
+    const int lineCount = 5000;
+    {
+        std::ofstream file("test_parallel_sales.txt", std::ios::binary);
+        for (int i = 0; i < lineCount; ++i) {
+            file << "isbn" << i << "|书名" << i << "|" << (i % 7 + 1) << "|" << i << ".50|2024-01-06 10:30:25";
+            file << (i % 3 == 0 ? "\r\n" : "\n");   // 混合CRLF换行
+            if (i % 1000 == 0) {
+                file << "\n" << "损坏的一行" << "\n";   // 空行与无法解析的行应被跳过
+            }
+        }
+    }
+    
+    std::vector<SaleRecord> records;
+    ParallelLoader loader(4, 64);
+    check(loader.loadSaleRecords("test_parallel_sales.txt", records), "并行加载销售记录");
+    check(records.size() == static_cast<size_t>(lineCount), "跳过空行和无法解析的行");
+    bool ordered = true;
+    for (int i = 0; i < lineCount && ordered; ++i) {
+        ordered = records[i].getIsbn() == "isbn" + std::to_string(i)
+               && records[i].getQuantity() == i % 7 + 1
+               && records[i].getSaleTime() == "2024-01-06 10:30:25";
+    }
+    check(ordered, "合并结果保持文件中的行序，CRLF被正确去除");
+    std::remove("test_parallel_sales.txt");
+    
+    // 图书文件：通过BookManager加载，格式错误的数值字段被拒绝
+    {
+        std::ofstream file("test_parallel_books.txt");
+        file << "书A|出版社|111|作者|1|10.00" << std::endl;
+        file << "书B|出版社|222|作者|abc|20.00" << std::endl;
+        file << "书C|出版社|333|作者| 3 | 30.50 " << std::endl;
+    }
+    BookManager manager;
+    manager.loadFromFile("test_parallel_books.txt");
+    std::remove("test_parallel_books.txt");
+    check(manager.getBookCount() == 2 && manager.findBookByIsbn("222") == nullptr, "库存非数字的行被跳过");
+    check(manager.getStock("333") == 3 && manager.findBookByIsbn("333")->getPrice() == 30.5, "数值字段两侧空格被容忍");
+    std::vector<Book> missing;
+    check(!loader.loadBooks("不存在的文件.txt", missing), "文件不存在时返回false");
+    
+    // 只有首行的"#journal N"是标记，书名以'#'开头的行照常加载
+    {
+        std::ofstream file("test_parallel_books.txt");
+        file << "#journal 7\n";
+        file << "#井号开头的书|出版社|444|作者|1|10.00\n";
+        file << "#journal 12|出版社|555|作者|2|20.00\n";
+    }
+    std::vector<Book> hashBooks;
+    uint64_t markedSeq = 0;
+    bool hashLoaded = loader.loadBooks("test_parallel_books.txt", hashBooks, &markedSeq);
+    std::remove("test_parallel_books.txt");
+    check(hashLoaded && markedSeq == 7 && hashBooks.size() == 2 && hashBooks[0].getTitle() == "#井号开头的书"
+          && hashBooks[1].getTitle() == "#journal 12", "以'#'开头的书名不被当作注释");
+    
+    std::cout << std::endl;
+}
+
+void testSalesJournal() {
+    std::cout << "=== 测试销售预写日志 ===" << std::endl;
+    
+    const std::string booksFile = "test_journal_books.txt";
+    const std::string salesFile = "test_journal_sales.txt";
+    auto cleanup = [&]() {
+        for (const std::string& f : {booksFile, salesFile, salesFile + ".journal", salesFile + ".journal.old",
+                                     SalesManager::rollupFileName(salesFile)}) {
+            std::remove(f.c_str());
+        }
+    };
+    cleanup();
+    std::vector<int64_t> journaledTimes;
+    
+    // 保存一份快照后开启日志，之后的销售只写日志
+    {
+        BookManager bookManager;
+        SalesManager salesManager(&bookManager);
+        FileManager fileManager(booksFile, salesFile);
+        bookManager.addBook(Book("C++程序设计", "清华大学出版社", "9787302168979", "谭浩强", 10, 59.90));
+        check(fileManager.saveAllData(&bookManager, &salesManager), "保存初始快照");
+        check(fileManager.enableJournal(&salesManager, SalesJournal::SyncPolicy::EveryRecord), "开启销售日志");
+        check(salesManager.purchaseBook("9787302168979", 2), "写日志的购买成功");
+        check(salesManager.purchaseBook("9787302168979", 3), "第二笔购买成功");
+        for (const auto& record : salesManager.getAllSaleRecords()) {
+            journaledTimes.push_back(record.getTimestamp());
+        }
+    }
+    
+    // 模拟崩溃：快照未重写，重启后从日志恢复
+    {
+        BookManager bookManager;
+        SalesManager salesManager(&bookManager);
+        FileManager fileManager(booksFile, salesFile);
+        fileManager.loadAllData(&bookManager, &salesManager);
+        check(salesManager.getAllSaleRecords().size() == 2, "从日志恢复两条销售记录");
+        check(bookManager.getStock("9787302168979") == 5, "从日志恢复库存扣减");
+        bool sameTimes = salesManager.getAllSaleRecords().size() == journaledTimes.size();
+        for (size_t i = 0; sameTimes && i < journaledTimes.size(); ++i) {
+            sameTimes = salesManager.getAllSaleRecords()[i].getTimestamp() == journaledTimes[i];
+        }
+        check(sameTimes, "从日志恢复的时间戳精确到微秒");
+    }
+    
+    // 末尾写了一半的帧被忽略，打开日志时截掉
+    {
+        std::ofstream journal(salesFile + ".journal", std::ios::binary | std::ios::app);
+        journal.write("\x30\x00\x00\x00\x12\x34", 6);
+    }
+    {
+        BookManager bookManager;
+        SalesManager salesManager(&bookManager);
+        FileManager fileManager(booksFile, salesFile);
+        fileManager.loadAllData(&bookManager, &salesManager);
+        check(salesManager.getAllSaleRecords().size() == 2, "残缺的尾帧不影响已有记录");
+        check(fileManager.enableJournal(&salesManager), "截掉残缺尾帧后继续追加");
+        check(salesManager.purchaseBook("9787302168979", 1), "继续追加购买");
+        
+        // 图书快照已含全部日志而销售快照没有：只补销售记录，不重复扣库存
+        bookManager.saveToFile(booksFile, salesManager.getJournal()->getLastSeq());
+    }
+    {
+        BookManager bookManager;
+        SalesManager salesManager(&bookManager);
+        FileManager fileManager(booksFile, salesFile);
+        fileManager.loadAllData(&bookManager, &salesManager);
+        check(salesManager.getAllSaleRecords().size() == 3, "截断后追加的记录可以恢复");
+        check(bookManager.getStock("9787302168979") == 4, "快照已包含的日志记录不重复扣库存");
+        
+        // 后台压缩：轮换日志后写快照，完成后只剩空的新日志
+        fileManager.enableJournal(&salesManager);
+        check(fileManager.compactInBackground(&bookManager, &salesManager), "启动后台压缩");
+        check(salesManager.purchaseBook("9787302168979", 1), "压缩期间继续购买");
+        fileManager.waitForCompaction();
+        check(!std::ifstream(salesFile + ".journal.old").is_open(), "压缩完成后删除旧日志");
+    }
+    {
+        BookManager bookManager;
+        SalesManager salesManager(&bookManager);
+        FileManager fileManager(booksFile, salesFile);
+        fileManager.loadAllData(&bookManager, &salesManager);
+        check(salesManager.getAllSaleRecords().size() == 4, "压缩后快照加新日志得到全部记录");
+        check(bookManager.getStock("9787302168979") == 3, "压缩后库存正确");
+
+        // 导出CSV按内存数据：没有"#journal"行，包含只在日志中的销售，补货线单独一列，含逗号的字段加引号
+        fileManager.enableJournal(&salesManager, SalesJournal::SyncPolicy::EveryRecord);
+        std::streambuf* coutBuf = std::cout.rdbuf(nullptr);
+        bookManager.addBook(Book("算法,第4版", "人民邮电出版社", "9787115293800", "Sedgewick", 5, 99.00, 2));
+        salesManager.purchaseBook("9787115293800", 1);
+        bool exported = fileManager.exportBooksToCSV(&bookManager, "test_export_books.csv")
+                        && fileManager.exportSalesToCSV(&salesManager, "test_export_sales.csv");
+        std::cout.rdbuf(coutBuf);
+        std::vector<std::string> bookLines, saleLines;
+        std::ifstream booksCsv("test_export_books.csv"), salesCsv("test_export_sales.csv");
+        for (std::string line; std::getline(booksCsv, line);) {
+            bookLines.push_back(line);
+        }
+        for (std::string line; std::getline(salesCsv, line);) {
+            saleLines.push_back(line);
+        }
+        booksCsv.close();
+        salesCsv.close();
+        std::remove("test_export_books.csv");
+        std::remove("test_export_sales.csv");
+        check(exported && bookLines.size() == 3 && bookLines[0] == "书名,出版社,ISBN,作者,库存量,价格,补货线"
+              && bookLines[1] == "C++程序设计,清华大学出版社,9787302168979,谭浩强,3,59.90,0"
+              && bookLines[2] == "\"算法,第4版\",人民邮电出版社,9787115293800,Sedgewick,4,99.00,2",
+              "按内存中的书库导出CSV");
+        check(saleLines.size() == 6 && saleLines[0] == "ISBN,书名,销售数量,总价格,销售时间"
+              && saleLines[5].rfind("9787115293800,\"算法,第4版\",1,99.00,", 0) == 0,
+              "导出的销售记录包含日志中的记录");
+    }
+
+    // 组提交：之后没有新的购买时，后台线程在间隔到期后fsync
+    {
+        const std::string groupFile = "test_group_commit.journal";
+        std::remove(groupFile.c_str());
+        SalesJournal journal;
+        journal.open(groupFile);
+        journal.setSyncPolicy(SalesJournal::SyncPolicy::GroupCommit, 1000, std::chrono::milliseconds(300));
+        SaleRecord record;
+        record.parse("9787302168979|C++程序设计|1|59.90|2024-01-01 10:00:00");
+        bool appended = journal.append(record);
+        size_t pendingAfterAppend = journal.getPendingCount();
+        for (int i = 0; i < 300 && journal.getPendingCount() > 0; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        check(appended && pendingAfterAppend == 1 && journal.getPendingCount() == 0, "组提交的间隔到期后由后台线程落盘");
+        journal.close();
+        std::remove(groupFile.c_str());
+    }
+
+    cleanup();
+    std::cout << std::endl;
+}
+
+void testAtomicSave() {
+    std::cout << "=== 测试原子保存（故障注入） ===" << std::endl;
+    
+    const std::string filename = "test_atomic_books.txt";
+    auto fileSize = [](const std::string& name) {
+        std::ifstream in(name, std::ios::binary | std::ios::ate);
+        return in.is_open() ? static_cast<int64_t>(in.tellg()) : static_cast<int64_t>(-1);
+    };
+    
+    // 旧快照：3本书
+    BookManager oldManager;
+    for (int i = 0; i < 3; ++i) {
+        oldManager.addBook(Book("旧书" + std::to_string(i), "出版社", "OLD" + std::to_string(i), "作者", i, 10.0 + i));
+    }
+    check(oldManager.saveToFile(filename), "保存旧快照");
+    
+    // 新快照：足够大，保证跨越多次缓冲区刷新（逐条提示信息太多，暂时关闭输出）
+    std::streambuf* coutBuf = std::cout.rdbuf(nullptr);
+    BookManager newManager;
+    for (int i = 0; i < 20000; ++i) {
+        newManager.addBook(Book("新书" + std::to_string(i), "出版社", "NEW" + std::to_string(i), "作者", i, 20.0));
+    }
+    std::ostringstream expected;
+    newManager.writeTo(expected);
+    const int64_t newSize = static_cast<int64_t>(expected.str().size());
+    
+    // 在随机位置"杀死"写入过程，原文件必须始终是完整的旧快照
+    std::mt19937 rng(20240601);
+    std::uniform_int_distribution<int64_t> offset(0, newSize - 1);
+    bool allRecovered = true;
+    for (int round = 0; round < 50; ++round) {
+        int64_t crashAt = round == 0 ? 0 : (round == 1 ? newSize - 1 : offset(rng));
+        AtomicFile::setCrashAfterBytes(crashAt);
+        bool saved = newManager.saveToFile(filename);
+        AtomicFile::setCrashAfterBytes(-1);
+        
+        BookManager recovered;
+        recovered.loadFromFile(filename);
+        allRecovered = allRecovered && !saved && fileSize(filename + ".tmp") == crashAt
+                       && recovered.getBookCount() == 3 && recovered.findBookByIsbn("OLD2") != nullptr;
+    }
+    std::cout.rdbuf(coutBuf);
+    check(allRecovered, "50个随机崩溃点后旧快照都完整可读，残留临时文件长度等于崩溃位置");
+    
+    // 残留的临时文件不影响下一次正常保存
+    check(newManager.saveToFile(filename), "残留临时文件时正常保存成功");
+    check(fileSize(filename) == newSize && fileSize(filename + ".tmp") == -1, "保存后文件完整且临时文件已改名");
+    
+    // 未提交就放弃时目标文件不变
+    {
+        AtomicFile file(filename);
+        file.stream() << "半截数据";
+    }
+    check(fileSize(filename) == newSize && fileSize(filename + ".tmp") == -1, "未提交的写入被丢弃");
+    
+    // 改名成功但目录同步失败：目标文件已是新内容，结果与真正落盘区分开
+    AtomicFile::setFailDirectorySync(true);
+    AtomicFile::CommitResult result;
+    {
+        AtomicFile file(filename);
+        file.stream() << "新数据\n";
+        result = file.commit();
+    }
+    std::cout.rdbuf(nullptr);
+    bool saved = newManager.saveToFile(filename);
+    std::cout.rdbuf(coutBuf);
+    AtomicFile::setFailDirectorySync(false);
+    check(result == AtomicFile::CommitResult::DirectorySyncFailed && fileSize(filename + ".tmp") == -1,
+          "目录同步失败单独报告，临时文件已改名");
+    check(!saved && fileSize(filename) == newSize, "目录同步失败时文件已覆盖，但保存报告为未完成");
+    
+    std::remove(filename.c_str());
+    std::cout << std::endl;
+}
+
+void testIncrementalSave() {
+    std::cout << "=== 测试增量/分段保存 ===" << std::endl;
+    
+    const std::string booksFile = "test_segment_books.txt";
+    const std::string salesFile = "test_segment_sales.txt";
+    auto exists = [](const std::string& name) { return std::ifstream(name).is_open(); };
+    
+    // 2.5段的书库（逐条提示信息太多，暂时关闭输出）
+    const size_t segmentSize = DirtyTracker::DEFAULT_SEGMENT_SIZE;
+    std::streambuf* coutBuf = std::cout.rdbuf(nullptr);
+    BookManager bookManager;
+    SalesManager salesManager(&bookManager);
+    for (size_t i = 0; i < segmentSize * 5 / 2; ++i) {
+        bookManager.addBook(Book("书" + std::to_string(i), "出版社", "SEG" + std::to_string(i), "作者", 100, 10.0));
+    }
+    std::cout.rdbuf(coutBuf);
+    check(bookManager.isDirty() && bookManager.getDirtyRecordCount() == segmentSize * 5 / 2, "新增的记录都被标记为脏");
+    
+    FileManager fileManager(booksFile, salesFile);
+    fileManager.setSegmentedMode(true);
+    check(fileManager.saveAllData(&bookManager, &salesManager), "首次分段保存");
+    check(!bookManager.isDirty() && bookManager.isSegmented(), "保存后不再为脏");
+    SegmentedFile::Manifest before;
+    check(SegmentedFile::readManifest(booksFile, before) && before.segments.size() == 3, "书库分为3段");
+    
+    // 没有修改时两个文件都跳过
+    check(fileManager.saveAllData(&bookManager, &salesManager), "无修改时保存成功");
+    SegmentedFile::Manifest unchanged;
+    SegmentedFile::readManifest(booksFile, unchanged);
+    check(unchanged.generation == before.generation, "无修改时清单没有重写");
+    
+    // 中间段的一本书卖出后只重写该段
+    std::string isbn = "SEG" + std::to_string(segmentSize + 7);
+    check(salesManager.purchaseBook(isbn, 3), "购买中间段的图书");
+    check(bookManager.getDirtyRecordCount() == 1, "只有一条图书记录为脏");
+    fileManager.saveAllData(&bookManager, &salesManager);
+    SegmentedFile::Manifest after;
+    SegmentedFile::readManifest(booksFile, after);
+    check(after.segments[0] == before.segments[0] && after.segments[2] == before.segments[2]
+          && after.segments[1] != before.segments[1], "只重写了被修改的段");
+    check(!exists(SegmentedFile::segmentPath(booksFile, before.segments[1])), "旧段文件已删除");
+    
+    // 重新加载分段文件
+    {
+        BookManager loadedBooks;
+        SalesManager loadedSales(&loadedBooks);
+        FileManager loader(booksFile, salesFile);
+        loader.loadAllData(&loadedBooks, &loadedSales);
+        check(loadedBooks.getBookCount() == static_cast<int>(segmentSize * 5 / 2) && loadedBooks.getStock(isbn) == 97,
+              "分段文件加载后数据完整");
+        check(loadedSales.getSaleRecordCount() == 1 && !loadedBooks.isDirty() && loadedBooks.isSegmented(),
+              "加载后为干净的分段布局");
+    }
+    
+    // 删除图书使其后所有记录前移，之后的段都要重写
+    std::cout.rdbuf(nullptr);
+    bookManager.deleteBook("SEG10");
+    std::cout.rdbuf(coutBuf);
+    fileManager.saveAllData(&bookManager, &salesManager);
+    SegmentedFile::Manifest shifted;
+    SegmentedFile::readManifest(booksFile, shifted);
+    check(shifted.segments.size() == 3 && shifted.segments[0] != after.segments[0]
+          && shifted.segments[2] != after.segments[2], "删除后其后的段全部重写");
+    
+    // 分段存储时数据文件只是清单，备份按内存数据写完整快照，可以直接加载
+    const std::string backupDir = "test_segment_backup";
+    std::cout.rdbuf(nullptr);
+    bool backedUp = fileManager.backupData(&bookManager, &salesManager, backupDir);
+    std::cout.rdbuf(coutBuf);
+    std::string backupBooks, backupSales;
+    for (const auto& entry : std::filesystem::directory_iterator(backupDir)) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind("books_", 0) == 0) {
+            backupBooks = entry.path().string();
+        } else if (name.rfind("sales_", 0) == 0 && name.size() > 4 && name.substr(name.size() - 4) == ".txt") {
+            backupSales = entry.path().string();
+        }
+    }
+    {
+        BookManager restoredBooks;
+        SalesManager restoredSales(&restoredBooks);
+        std::cout.rdbuf(nullptr);
+        bool restored = restoredBooks.loadFromFile(backupBooks) && restoredSales.loadFromFile(backupSales);
+        std::cout.rdbuf(coutBuf);
+        check(backedUp && restored && restoredBooks.getBookCount() == bookManager.getBookCount()
+              && restoredBooks.getStock(isbn) == 97 && restoredSales.getSaleRecordCount() == 1,
+              "分段存储的备份包含全部数据");
+    }
+    std::filesystem::remove_all(backupDir);
+    
+    // 清单改名后目录同步失败：新清单已生效，旧段文件暂留（掉电后旧清单可能重新生效），下次保存落盘后再删除
+    check(salesManager.purchaseBook(isbn, 1), "再次购买中间段的图书");
+    AtomicFile::setFailDirectorySync(true);
+    std::cout.rdbuf(nullptr);
+    bool unsynced = fileManager.saveAllData(&bookManager, &salesManager);
+    std::cout.rdbuf(coutBuf);
+    AtomicFile::setFailDirectorySync(false);
+    SegmentedFile::Manifest pending;
+    SegmentedFile::readManifest(booksFile, pending);
+    check(!unsynced && pending.segments[1] != shifted.segments[1] && bookManager.isDirty()
+          && exists(SegmentedFile::segmentPath(booksFile, shifted.segments[1])),
+          "目录同步失败时新清单已生效，旧段文件和修改标记都保留");
+    {
+        BookManager loadedBooks;
+        std::cout.rdbuf(nullptr);
+        loadedBooks.loadFromFile(booksFile);
+        std::cout.rdbuf(coutBuf);
+        check(loadedBooks.getStock(isbn) == 96, "目录同步失败后按新清单加载");
+    }
+    check(fileManager.saveAllData(&bookManager, &salesManager) && !bookManager.isDirty()
+          && !exists(SegmentedFile::segmentPath(booksFile, shifted.segments[1])), "下次保存落盘后删除暂留的旧段文件");
+    
+    // 切回单文件存储后段文件被清理
+    fileManager.setSegmentedMode(false);
+    fileManager.saveAllData(&bookManager, &salesManager);
+    check(!bookManager.isSegmented() && !exists(SegmentedFile::segmentPath(booksFile, shifted.segments[0])),
+          "切回单文件后删除段文件");
+    BookManager plain;
+    plain.loadFromFile(booksFile);
+    check(plain.getBookCount() == bookManager.getBookCount(), "单文件内容完整");
+    
+    std::remove(booksFile.c_str());
+    std::remove(salesFile.c_str());
+    std::remove(SalesManager::rollupFileName(salesFile).c_str());
+    std::cout << std::endl;
+}
+
+void testColumnStore() {
+    std::cout << "=== 测试价格/库存列 ===" << std::endl;
+    
+    BookManager manager;
+    SalesManager sales(&manager);
+    StatisticsManager statistics(&manager, &sales);
+    manager.addBook(Book("A", "P", "C1", "X", 10, 20.0));
+    manager.addBook(Book("B", "P", "C2", "X", 5, 80.0));
+    manager.addBook(Book("C", "P", "C3", "X", 1, 5.0));
+    
+    // 增删改之后列必须与图书对象一致
+    manager.updateStock("C1", -4);
+    manager.updateBook("C3", Book("C", "P", "C3", "X", 7, 15.0));
+    manager.deleteBook("C2");
+    const auto& books = manager.getAllBooks();
+    bool consistent = books.size() == manager.getPriceColumn().size() && books.size() == manager.getStockColumn().size();
+    for (size_t i = 0; consistent && i < books.size(); ++i) {
+        consistent = books[i].getPrice() == manager.getPriceColumn()[i]
+                     && books[i].getStock() == manager.getStockColumn()[i];
+    }
+    check(consistent, "增删改后列与图书对象一致");
+    
+    auto price = statistics.getPriceStatistics();
+    check(price.maxPrice == 20.0 && price.minPrice == 15.0 && price.avgPrice == 17.5
+          && price.totalValue == 20.0 * 6 + 15.0 * 7, "价格统计基于列计算正确");
+    auto stock = statistics.getStockStatistics();
+    check(stock.totalBooks == 2 && stock.totalStock == 13 && stock.maxStock == 7 && stock.minStock == 6,
+          "库存统计基于列计算正确");
+    
+    manager.clear();
+    check(manager.getPriceColumn().empty() && statistics.getStockStatistics().totalBooks == 0, "清空后列为空");
+    
+    std::cout << std::endl;
+}
+
+void testStatsKernels() {
+    std::cout << "=== 测试统计聚合内核 ===" << std::endl;
+    std::cout << "当前CPU使用: " << StatsKernels::kernelName(StatsKernels::bestKernel()) << std::endl;
+    
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> priceDist(0.5, 500.0);
+    std::uniform_int_distribution<int> stockDist(-5, 1000);
+    
+    // 覆盖空数组、不足一个向量宽度、带尾部元素和较大规模的情况
+    bool allMatch = true;
+    for (size_t count : {size_t(0), size_t(1), size_t(3), size_t(7), size_t(8), size_t(13), size_t(10007)}) {
+        std::vector<double> price(count);
+        std::vector<int> stock(count);
+        for (size_t i = 0; i < count; ++i) {
+            price[i] = priceDist(rng);
+            stock[i] = stockDist(rng);
+        }
+        auto expected = StatsKernels::aggregateWith(StatsKernels::Kernel::Scalar, price.data(), stock.data(), count);
+        for (auto kernel : {StatsKernels::Kernel::SSE2, StatsKernels::Kernel::AVX2}) {
+            auto actual = StatsKernels::aggregateWith(kernel, price.data(), stock.data(), count);
+            // 向量实现的求和顺序不同，浮点和允许极小的相对误差；最值和库存和必须完全一致
+            auto close = [](double a, double b) { return std::fabs(a - b) <= 1e-9 * std::max(1.0, std::fabs(b)); };
+            allMatch = allMatch && actual.count == expected.count
+                       && close(actual.priceSum, expected.priceSum) && close(actual.totalValue, expected.totalValue)
+                       && actual.stockSum == expected.stockSum
+                       && actual.priceMin == expected.priceMin && actual.priceMax == expected.priceMax
+                       && actual.stockMin == expected.stockMin && actual.stockMax == expected.stockMax;
+        }
+    }
+    check(allMatch, "SSE2/AVX2实现与标量实现结果一致");
+    
+    std::cout << std::endl;
+}
+
+void testRunningStats() {
+    std::cout << "=== 测试增量维护的统计 ===" << std::endl;
+    
+    BookManager bookManager;
+    SalesManager salesManager(&bookManager);
+    bookManager.addBook(Book("A", "P", "R1", "X", 10, 20.0));
+    
+    // 统计引擎创建后用已有数据初始化，此后跟随每次修改
+    StatisticsManager statistics(&bookManager, &salesManager);
+    bookManager.addBook(Book("B", "P", "R2", "X", 5, 80.0));
+    bookManager.addBook(Book("C", "P", "R3", "X", 1, 5.0));
+    check(statistics.getPriceStatistics().maxPrice == 80.0 && statistics.getStockStatistics().minStock == 1,
+          "新增图书后最值更新");
+    
+    // 删除当前最值后立即得到次大/次小值
+    bookManager.deleteBook("R2");
+    check(statistics.getPriceStatistics().maxPrice == 20.0, "删除最高价图书后最高价回落");
+    salesManager.purchaseBook("R3", 1);
+    check(statistics.getStockStatistics().minStock == 0 && statistics.getStockStatistics().totalStock == 10,
+          "购买后库存最值和总量更新");
+    bookManager.updateBook("R1", Book("A", "P", "R1", "X", 3, 12.5));
+    auto price = statistics.getPriceStatistics();
+    check(price.maxPrice == 12.5 && price.totalValue == 12.5 * 3, "修改图书后价格统计更新");
+    check(statistics.verifyRunningStats(), "增删改购买后与全量重算一致");
+    
+    // 随机操作序列后仍与全量重算一致
+    std::mt19937 rng(99);
+    std::streambuf* coutBuf = std::cout.rdbuf(nullptr);
+    for (int i = 0; i < 3000; ++i) {
+        std::string isbn = "RND" + std::to_string(rng() % 200);
+        switch (rng() % 4) {
+            case 0:
+                bookManager.addBook(Book("T", "P", isbn, "X", static_cast<int>(rng() % 100), 1.0 + rng() % 1000 / 10.0));
+                break;
+            case 1:
+                bookManager.deleteBook(isbn);
+                break;
+            case 2:
+                salesManager.purchaseBook(isbn, 1 + static_cast<int>(rng() % 3));
+                break;
+            default:
+                bookManager.updateStock(isbn, static_cast<int>(rng() % 20));
+                break;
+        }
+    }
+    std::cout.rdbuf(coutBuf);
+    check(statistics.verifyRunningStats(), "3000次随机操作后与全量重算一致");
+    
+    // 加载和清空都会重新同步
+    bookManager.saveToFile("test_running_stats.txt");
+    bookManager.loadFromFile("test_running_stats.txt");
+    std::remove("test_running_stats.txt");
+    salesManager.clear();
+    check(statistics.verifyRunningStats() && statistics.getStockStatistics().totalBooks == bookManager.getBookCount(),
+          "重新加载和清空后仍一致");
+    auto highest = bookManager.topKByPrice(1);
+    if (!highest.empty()) {
+        bookManager.deleteBook(highest[0]->getIsbn());
+    }
+    check(statistics.verifyRunningStats(), "整体加载后删除最高价图书仍一致");
+    
+    // 各书库存之和超出int时总库存量不截断
+    BookManager largeBooks;
+    SalesManager largeSales(&largeBooks);
+    StatisticsManager largeStatistics(&largeBooks, &largeSales);
+    const int maxInt = std::numeric_limits<int>::max();
+    largeBooks.addBook(Book("L1", "P", "BIG1", "X", maxInt, 1.0));
+    largeBooks.addBook(Book("L2", "P", "BIG2", "X", maxInt, 1.0));
+    check(largeStatistics.getStockStatistics().totalStock == 2LL * maxInt && largeStatistics.verifyRunningStats(),
+          "总库存量超出int范围时不截断");
+    
+    std::cout << std::endl;
+}
+
+void testRanking() {
+    std::cout << "=== 测试排行榜 ===" << std::endl;
+    
+    BookManager manager;
+    std::mt19937 rng(13);
+    std::streambuf* coutBuf = std::cout.rdbuf(nullptr);
+    for (int i = 0; i < 500; ++i) {
+        // 价格取值较少，制造大量并列
+        manager.addBook(Book("T" + std::to_string(i), "P", "RK" + std::to_string(i), "X",
+                             static_cast<int>(rng() % 50), 10.0 + rng() % 30));
+    }
+    std::cout.rdbuf(coutBuf);
+    
+    // 对照：完整稳定排序
+    std::vector<const Book*> sorted;
+    for (const auto& book : manager.getAllBooks()) {
+        sorted.push_back(&book);
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Book* a, const Book* b) {
+        return a->getPrice() > b->getPrice();
+    });
+    
+    auto top = manager.topKByPrice(20);
+    check(top.size() == 20 && std::equal(top.begin(), top.end(), sorted.begin()), "前20名与完整排序一致（并列按加入顺序）");
+    
+    // 逐页拼起来等于完整排序
+    std::vector<const Book*> paged;
+    for (size_t offset = 0; offset < 500; offset += 37) {
+        auto page = manager.rankRange(RankKey::Price, offset, 37);
+        paged.insert(paged.end(), page.begin(), page.end());
+    }
+    check(paged == sorted, "分页结果拼接后与完整排序一致");
+    
+    check(manager.rankRange(RankKey::Stock, 499, 10).size() == 1 && manager.rankRange(RankKey::Stock, 500, 10).empty(),
+          "越过末尾的分页被截断");
+    auto byStock = manager.topKByStock(1000);
+    bool descending = byStock.size() == 500;
+    for (size_t i = 1; descending && i < byStock.size(); ++i) {
+        descending = byStock[i - 1]->getStock() >= byStock[i]->getStock();
+    }
+    check(descending, "k超过图书总数时返回全部并按库存降序");
+    
+    std::cout << std::endl;
+}
+
+void testOrderIndex() {
+    std::cout << "=== 测试价格/库存有序索引 ===" << std::endl;
+    
+    BookManager manager;
+    SalesManager salesManager(&manager);
+    std::mt19937 rng(14);
+    
+    // 暴力对照：扫描全部图书
+    auto bruteForce = [&manager](double low, double high, bool byPrice) {
+        std::vector<std::string> isbns;
+        for (const auto& book : manager.getAllBooks()) {
+            double value = byPrice ? book.getPrice() : book.getStock();
+            if (value >= low && value <= high) {
+                isbns.push_back(book.getIsbn());
+            }
+        }
+        std::sort(isbns.begin(), isbns.end());
+        return isbns;
+    };
+    auto isbnsOf = [](const std::vector<const Book*>& books) {
+        std::vector<std::string> isbns;
+        for (const auto& book : books) {
+            isbns.push_back(book->getIsbn());
+        }
+        std::sort(isbns.begin(), isbns.end());
+        return isbns;
+    };
+    
+    // 增删改、购买、改ISBN交替进行后，区间查询仍与暴力扫描一致
+    std::streambuf* coutBuf = std::cout.rdbuf(nullptr);
+    for (int i = 0; i < 4000; ++i) {
+        std::string isbn = "OI" + std::to_string(rng() % 300);
+        switch (rng() % 5) {
+            case 0:
+            case 1:
+                manager.addBook(Book("T", "P", isbn, "X", static_cast<int>(rng() % 30), 5.0 + rng() % 100));
+                break;
+            case 2:
+                manager.deleteBook(isbn);
+                break;
+            case 3:
+                salesManager.purchaseBook(isbn, 1);
+                break;
+            default:
+                manager.updateBook(isbn, Book("T", "P", "OI" + std::to_string(rng() % 300), "X",
+                                              static_cast<int>(rng() % 30), 5.0 + rng() % 100));
+                break;
+        }
+    }
+    std::cout.rdbuf(coutBuf);
+    
+    bool consistent = true;
+    for (int i = 0; i < 50 && consistent; ++i) {
+        double low = rng() % 110, high = low + rng() % 40;
+        int stockLow = static_cast<int>(rng() % 30), stockHigh = stockLow + static_cast<int>(rng() % 10);
+        consistent = isbnsOf(manager.findBooksByPriceRange(low, high)) == bruteForce(low, high, true) &&
+                     isbnsOf(manager.findBooksByStockRange(stockLow, stockHigh)) == bruteForce(stockLow, stockHigh, false);
+    }
+    check(consistent, "随机修改后区间查询与全表扫描一致");
+    check(manager.findBooksByPriceRange(60.0, 30.0).empty(), "上界小于下界时结果为空");
+    
+    auto ordered = manager.getBooksOrderedBy(RankKey::Stock, true);
+    bool sorted = ordered.size() == static_cast<size_t>(manager.getBookCount());
+    for (size_t i = 1; sorted && i < ordered.size(); ++i) {
+        sorted = ordered[i - 1]->getStock() >= ordered[i]->getStock();
+    }
+    check(sorted, "有序遍历覆盖全部图书且按库存降序");
+    
+    // 重新加载后按排好序的数据整体重建
+    manager.saveToFile("test_order_index.txt");
+    manager.loadFromFile("test_order_index.txt");
+    std::remove("test_order_index.txt");
+    check(isbnsOf(manager.findBooksByPriceRange(20.0, 70.0)) == bruteForce(20.0, 70.0, true) &&
+          manager.getBooksOrderedBy(RankKey::Price).size() == static_cast<size_t>(manager.getBookCount()),
+          "重新加载后有序索引仍正确");
+    
+    std::cout << std::endl;
+}
+
+void testReorderAlerts() {
+    std::cout << "=== 测试补货线与补货提醒 ===" << std::endl;
+    
+    // 记录收到的提醒
+    struct Recorder : StockAlertListener {
+        std::vector<std::string> needed, replenished;
+        void onReorderNeeded(const Book& book) override { needed.push_back(book.getIsbn()); }
+        void onStockReplenished(const Book& book) override { replenished.push_back(book.getIsbn()); }
+    } recorder;
+    
+    // 补货线作为可选的第7个字段读写，未设置时格式不变
+    Book parsed;
+    check(parsed.fromString("T|P|R0|A|3|9.90|5") && parsed.getReorderThreshold() == 5 &&
+          parsed.toString() == "T|P|R0|A|3|9.90|5", "补货线字段解析与输出");
+    check(Book("T", "P", "R0", "A", 3, 9.9).toString() == "T|P|R0|A|3|9.90", "未设置补货线时保持旧格式");
+    
+    BookManager bookManager;
+    SalesManager salesManager(&bookManager);
+    bookManager.addAlertListener(&recorder);
+    std::streambuf* coutBuf = std::cout.rdbuf(nullptr);
+    bookManager.addBook(Book("A", "P", "R1", "X", 10, 20.0, 3));
+    bookManager.addBook(Book("B", "P", "R2", "X", 2, 20.0, 5));     // 加入时就需要补货
+    bookManager.addBook(Book("C", "P", "R3", "X", 8, 20.0, 4));
+    salesManager.purchaseBook("R1", 5);                             // 10 -> 5，仍高于补货线
+    salesManager.purchaseBook("R1", 2);                             // 5 -> 3，跨过补货线
+    salesManager.purchaseBook("R1", 1);                             // 已经需要补货，不重复提醒
+    std::cout.rdbuf(coutBuf);
+    check(recorder.needed == std::vector<std::string>({"R2", "R1"}), "跨过补货线时各提醒一次");
+    
+    auto reorder = bookManager.getReorderList();
+    check(reorder.size() == 2 && reorder[0]->getIsbn() == "R2" && reorder[1]->getIsbn() == "R1",
+          "待补货列表按紧缺程度排序");
+    check(bookManager.getReorderList(4).size() == 3, "提前量内的图书也能查出");
+    
+    // 补货和调整补货线都会触发回升提醒并更新索引
+    bookManager.updateStock("R2", 10);
+    bookManager.setReorderThreshold("R3", 8);
+    check(recorder.replenished == std::vector<std::string>({"R2"}) && recorder.needed.back() == "R3",
+          "补货回升与调高补货线的提醒");
+    
+    // 保存后重新加载，补货线随文件保留
+    coutBuf = std::cout.rdbuf(nullptr);
+    bookManager.saveToFile("test_reorder.txt");
+    bookManager.loadFromFile("test_reorder.txt");
+    std::cout.rdbuf(coutBuf);
+    std::remove("test_reorder.txt");
+    reorder = bookManager.getReorderList();
+    check(reorder.size() == 2 && bookManager.findBookByIsbn("R3")->getReorderThreshold() == 8,
+          "重新加载后补货线和索引仍正确");
+    bookManager.removeAlertListener(&recorder);
+    
+    std::cout << std::endl;
+}
+
+void testValueStorage() {
+    std::cout << "=== 测试按值存储与只读视图 ===" << std::endl;
+    
+    BookManager manager;
+    SalesManager salesManager(&manager);
+    std::mt19937 rng(16);
+    
+    // 随机增删改后，二级索引中的下标仍指向正确的图书
+    std::streambuf* coutBuf = std::cout.rdbuf(nullptr);
+    for (int i = 0; i < 3000; ++i) {
+        std::string isbn = "VS" + std::to_string(rng() % 200);
+        std::string author = "作者" + std::to_string(rng() % 10);
+        switch (rng() % 3) {
+            case 0:
+                manager.addBook(Book("T", "P", isbn, author, 5, 10.0));
+                break;
+            case 1:
+                manager.deleteBook(isbn);
+                break;
+            default:
+                manager.updateBook(isbn, Book("T", "P", isbn, author, 5, 10.0));
+                break;
+        }
+    }
+    salesManager.purchaseBook(manager.getAllBooks().front().getIsbn(), 1);
+    std::cout.rdbuf(coutBuf);
+    
+    const auto& books = manager.getAllBooks();
+    bool consistent = true;
+    size_t total = 0;
+    for (int a = 0; a < 10 && consistent; ++a) {
+        std::string author = "作者" + std::to_string(a);
+        BookView view = manager.findBooksByAuthor(author);
+        total += view.size();
+        for (const Book* book : view) {
+            // 视图元素直接指向书库的连续存储
+            consistent = consistent && book >= books.data() && book < books.data() + books.size()
+                         && book->getAuthor() == author;
+        }
+    }
+    check(consistent && total == books.size(), "随机增删改后二级索引下标与图书一致");
+    check(&manager.getAllBooks() == &books, "getAllBooks返回内部存储的引用而不是副本");
+    
+    auto records = salesManager.getSaleRecordsByIsbn(books.front().getIsbn());
+    check(records.size() == 1 && records[0] == &salesManager.getAllSaleRecords()[0], "销售记录查询返回指向内部存储的指针");
+    
+    std::cout << std::endl;
+}
+
+void testGetterReferences() {
+    std::cout << "=== 测试字符串getter返回引用 ===" << std::endl;
+    
+    BookManager manager;
+    std::streambuf* coutBuf = std::cout.rdbuf(nullptr);
+    manager.addBook(Book("原书名", "P", "GR1", "X", 3, 10.0));
+    const Book* book = manager.findBookByIsbn("GR1");
+    check(&book->getTitle() == &manager.getAllBooks()[0].getTitle(), "getter直接返回内部字符串");
+    
+    // 传入的ISBN引用的正是被修改图书自身的字段，修改ISBN后索引仍要正确
+    bool updated = manager.updateBook(book->getIsbn(), Book("新书名", "P", "GR2", "X", 3, 10.0));
+    std::cout.rdbuf(coutBuf);
+    check(updated && manager.findBookByIsbn("GR1") == nullptr && manager.findBookByIsbn("GR2") != nullptr,
+          "以自身ISBN的引用修改ISBN");
+    
+    std::cout << std::endl;
+}
+
+void testStringPool() {
+    std::cout << "=== 测试作者/出版社字符串驻留 ===" << std::endl;
+    
+    StringPool pool;
+    StringPool::Id a = pool.intern("同一个作者");
+    check(pool.intern(std::string("同一个作者")) == a && pool.get(a) == "同一个作者", "相同内容驻留为同一编号");
+    check(pool.intern("") == StringPool::EMPTY && pool.find("没驻留过") == StringPool::NOT_FOUND,
+          "空串为0号，find不新增");
+    
+    // 超过一个内存块的长字符串和大量短字符串：先前返回的视图不能失效
+    std::string longText(100000, 'x');
+    StringPool::Id big = pool.intern(longText);
+    std::string_view first = pool.get(a);
+    for (int i = 0; i < 20000; ++i) {
+        pool.intern("作者" + std::to_string(i));
+    }
+    check(pool.get(big) == longText && first.data() == pool.get(a).data() && pool.size() == 20003,
+          "扩容后已有视图保持有效");
+    
+    // 并发驻留：各线程对同一批字符串得到相同的编号
+    std::vector<std::vector<StringPool::Id>> seen(4);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < seen.size(); ++t) {
+        workers.emplace_back([&pool, &seen, t] {
+            for (int i = 0; i < 5000; ++i) {
+                seen[t].push_back(pool.intern("并发" + std::to_string(i)));
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    check(std::all_of(seen.begin(), seen.end(), [&seen](const std::vector<StringPool::Id>& ids) { return ids == seen[0]; }),
+          "多线程驻留结果一致");
+    
+    BookManager manager;
+    std::streambuf* coutBuf = std::cout.rdbuf(nullptr);
+    manager.addBook(Book("书1", "驻留出版社", "SP1", "驻留作者甲", 1, 10.0));
+    manager.addBook(Book("书2", "驻留出版社", "SP2", "驻留作者乙", 1, 10.0));
+    manager.addBook(Book("书3", "另一出版社", "SP3", "驻留作者甲", 1, 10.0));
+    std::cout.rdbuf(coutBuf);
+    const Book* b1 = manager.findBookByIsbn("SP1");
+    const Book* b3 = manager.findBookByIsbn("SP3");
+    check(b1->getAuthorId() == b3->getAuthorId() && b1->getAuthor() == "驻留作者甲", "图书只存编号");
+    check(manager.findBooksByAuthor("驻留作者甲").size() == 2 && manager.findBooksByPublisher("驻留出版社").size() == 2
+          && manager.findBooksByAuthor("不存在的作者").empty(), "按编号查询作者/出版社");
+    
+    {
+        Book changed = *b1;
+        changed.setAuthor("驻留作者乙");
+        coutBuf = std::cout.rdbuf(nullptr);
+        manager.updateBook("SP1", changed);
+        manager.deleteBook("SP2");
+        std::cout.rdbuf(coutBuf);
+        check(manager.findBooksByAuthor("驻留作者乙").size() == 1 && manager.findBooksByAuthor("驻留作者甲").size() == 1
+              && manager.findBooksByAuthor("驻留作者乙")[0]->getIsbn() == "SP1", "修改和删除后编号索引正确");
+        
+        Book parsed;
+        check(parsed.fromString("书4|另一出版社|SP4|驻留作者乙|2|5.00")
+              && parsed.getPublisherId() == manager.findBookByIsbn("SP3")->getPublisherId()
+              && parsed.toString() == "书4|另一出版社|SP4|驻留作者乙|2|5.00", "解析时驻留，序列化时还原");
+        
+        // 还有图书持有编号时不能重置驻留池
+        manager.clear();
+        check(Book::authorPool().find("驻留作者乙") != StringPool::NOT_FOUND, "仍有图书持有编号时不重置驻留池");
+    }
+    
+    // 最后一批图书清空后池被释放，只剩空串
+    manager.clear();
+    check(Book::authorPool().size() == 1 && Book::authorPool().find("驻留作者甲") == StringPool::NOT_FOUND
+          && Book::publisherPool().size() == 1, "没有持有者后清空即释放驻留池");
+    
+    std::cout << std::endl;
+}
+
+void testIsbnKey() {
+    std::cout << "=== 测试 64位ISBN键 ===" << std::endl;
+    
+    IsbnKey isbn13 = IsbnKey::parse("978-7-302-16897-3");
+    check(isbn13.isIsbn13() && isbn13.hasValidChecksum() && isbn13.toString() == "9787302168973",
+          "ISBN-13去掉分隔符并校验");
+    check(IsbnKey::parse("7-302-16897-0") == isbn13 && IsbnKey::parse("730216897X") != isbn13,
+          "校验位正确的ISBN-10换算成同一个ISBN-13");
+    check(IsbnKey::parse("9787302168979").isIsbn13() && !IsbnKey::parse("9787302168979").hasValidChecksum(),
+          "校验位错误的ISBN-13可以识别出来");
+    check(IsbnKey::parse("0000000000000").isValid() && IsbnKey::parse("0000000000000").toString() == "0000000000000",
+          "全零ISBN与无效键不冲突");
+    
+    IsbnKey code = IsbnKey::parse("SEG-4103a");
+    check(code.isValid() && !code.isIsbn13() && code.toString() == "SEG-4103a", "内部编号打包后可还原");
+    IsbnKey legacy = IsbnKey::parse("中文编号");
+    check(!IsbnKey().isValid() && legacy.isLegacy() && !legacy.isIsbn13() && legacy.toString() == "中文编号"
+          && legacy == IsbnKey::parse("中文编号") && IsbnKey::parse("ABCDEFGHIJK").toString() == "ABCDEFGHIJK"
+          && IsbnKey::parse("A B").isLegacy() && IsbnKey::parse("").isLegacy() && !code.isLegacy()
+          && !isbn13.isLegacy(), "其他编号按原文保留为旧编号");
+    
+    // 同类键的顺序与字符串字典序一致（ISBN-13整体排在内部编号之前）
+    std::vector<std::string> texts = {"R1", "R10", "R2", "A", "a", "Z9", "-X", "0", "z"};
+    std::vector<std::string> byKey = texts;
+    std::sort(texts.begin(), texts.end());
+    std::sort(byKey.begin(), byKey.end(), [](const std::string& a, const std::string& b) {
+        return IsbnKey::parse(a) < IsbnKey::parse(b);
+    });
+    check(byKey == texts && IsbnKey::parse("9787040408900") < IsbnKey::parse("9787111407010")
+          && IsbnKey::parse("9787111407010") < IsbnKey::parse("-X"), "键的大小顺序与字典序一致");
+    
+    BookManager bookManager;
+    SalesManager salesManager(&bookManager);
+    std::streambuf* coutBuf = std::cout.rdbuf(nullptr);
+    bool added = bookManager.addBook(Book("C++程序设计", "清华大学出版社", "7-302-16897-0", "谭浩强", 10, 59.90));
+    bool badAdded = bookManager.addBook(Book("坏编号", "出版社", "ISBN:123", "作者", 1, 1.0));
+    bool duplicate = bookManager.addBook(Book("重复", "出版社", "9787302168973", "作者", 1, 1.0));
+    salesManager.purchaseBook("978-7302168973", 2);
+    salesManager.purchaseBook("7302168970", 1);
+    std::cout.rdbuf(coutBuf);
+    check(added && !badAdded && !duplicate, "加入时规范化，无效和重复的ISBN被拒绝");
+    check(bookManager.findBookByIsbn("978-7-302-16897-3")->getIsbn() == "9787302168973"
+          && bookManager.getStock("7302168970") == 7, "任意写法都能查到同一本书");
+    check(salesManager.getSaleRecordsByIsbn("9787302168973").size() == 2
+          && salesManager.getAllSaleRecords()[0].getIsbn() == "9787302168973", "销售记录按整数键关联");
+    
+    // 旧文件中不规范的ISBN原样保留：加载、保存、再加载都不丢记录，销售记录仍能关联
+    {
+        std::ofstream books("test_isbn_key.txt");
+        books << "书1|出版社|978-7-111-40701-0|作者|1|1.00\n";
+        books << "书2|出版社|这不是ISBN|作者|1|1.00\n";
+        books << "书3|出版社|LOCAL01|作者|1|1.00\n";
+        std::ofstream sales("test_isbn_key_sales.txt");
+        sales << "这不是ISBN|书2|2|2.00|2024-01-01 10:00:00\n";
+    }
+    coutBuf = std::cout.rdbuf(nullptr);
+    BookManager loaded;
+    loaded.loadFromFile("test_isbn_key.txt");
+    loaded.saveToFile("test_isbn_key.txt");
+    BookManager reloaded;
+    reloaded.loadFromFile("test_isbn_key.txt");
+    SalesManager legacySales(&reloaded);
+    legacySales.loadFromFile("test_isbn_key_sales.txt");
+    legacySales.saveToFile("test_isbn_key_sales.txt");
+    SalesManager reloadedSales(&reloaded);
+    reloadedSales.loadFromFile("test_isbn_key_sales.txt");
+    std::cout.rdbuf(coutBuf);
+    std::ifstream saved("test_isbn_key.txt");
+    std::string first, second;
+    std::getline(saved, first);
+    std::getline(saved, second);
+    saved.close();
+    std::remove("test_isbn_key.txt");
+    std::remove("test_isbn_key_sales.txt");
+    std::remove("test_isbn_key_sales.txt.rollup");
+    check(loaded.getBookCount() == 3 && first == "书1|出版社|9787111407010|作者|1|1.00"
+          && second == "书2|出版社|这不是ISBN|作者|1|1.00", "不规范的ISBN原样保存，其他ISBN保存为规范形式");
+    check(reloaded.getBookCount() == 3 && reloaded.findBookByIsbn("这不是ISBN")
+          && reloaded.findBookByIsbn("这不是ISBN")->getTitle() == "书2"
+          && reloadedSales.getSaleRecordsByIsbn("这不是ISBN").size() == 1, "旧编号的图书和销售记录重新加载后仍在");
+    
+    std::cout << std::endl;
+}
+
+void testCompactSaleRecord() {
+    std::cout << "=== 测试 定长销售记录 ===" << std::endl;
+    
+    check(std::is_trivially_copyable<SaleRecord>::value && sizeof(SaleRecord) <= 40,
+          "销售记录是不含堆内存的定长结构");
+    
+    // 时间戳与本地时间文本互相转换，结果与mktime一致
+    const char* times[] = {"2024-01-06 10:30:25", "2024-02-29 23:59:59", "1969-12-31 08:00:00",
+                           "2000-03-01 00:00:00", "2038-01-19 03:14:08"};
+    bool roundTrip = true;
+    for (const char* text : times) {
+        int64_t micros = 0;
+        std::tm local{};
+        std::sscanf(text, "%d-%d-%d %d:%d:%d", &local.tm_year, &local.tm_mon, &local.tm_mday,
+                    &local.tm_hour, &local.tm_min, &local.tm_sec);
+        local.tm_year -= 1900;
+        local.tm_mon -= 1;
+        local.tm_isdst = -1;
+        roundTrip = roundTrip && Timestamp::parse(text, micros) && Timestamp::format(micros) == text
+                    && micros == static_cast<int64_t>(std::mktime(&local)) * Timestamp::MICROS_PER_SECOND;
+    }
+    int64_t ignored;
+    check(roundTrip, "时间戳与本地时间文本互相转换");
+    check(!Timestamp::parse("2024-02-30 10:00:00", ignored) && !Timestamp::parse("2024-01-06 24:00:00", ignored)
+          && !Timestamp::parse("2024/01/06 10:30:25", ignored) && !Timestamp::parse("昨天", ignored),
+          "不存在的日期和格式错误的时间被拒绝");
+    
+    // 文本格式不变：解析后再输出得到原来的行
+    SaleRecord record;
+    std::string line = "9787111407010|数据结构|3|29.97|2024-01-06 10:30:25";
+    check(record.parse(line) && record.getTotalCents() == 2997 && record.getBookTitle() == "数据结构"
+          && record.getSaleTime() == "2024-01-06 10:30:25" && record.toString() == line,
+          "解析和输出的文本格式不变");
+    check(!record.parse("9787111407010|数据结构|3|29.97|昨天") && record.getQuantity() == 3,
+          "销售时间无法解析的行被拒绝且不修改记录");
+    
+    // 不是整秒的时间保存时带微秒，解析后时间戳不变
+    std::string preciseLine = "9787111407010|数据结构|3|29.97|2024-01-06 10:30:25.000120";
+    int64_t half = 0, whole = 0;
+    check(record.parse(preciseLine) && record.toString() == preciseLine
+          && Timestamp::parse("2024-01-06 10:30:25.5", half) && Timestamp::parse("2024-01-06 10:30:25", whole)
+          && half - whole == 500000 && record.getTimestamp() - whole == 120
+          && !Timestamp::parse("2024-01-06 10:30:25.", ignored) && !Timestamp::parse("2024-01-06 10:30:25.1234567", ignored),
+          "保存格式保留微秒");
+    
+    // 构造时只记录时间戳；金额按分计算，没有浮点累积误差
+    int64_t before = Timestamp::nowMicros();
+    SaleRecord first(IsbnKey::parse("9787111407010"), "数据结构", 3, 19.99);
+    SaleRecord second(IsbnKey::parse("9787111407010"), "数据结构", 1, 0.1);
+    int64_t after = Timestamp::nowMicros();
+    check(first.getTimestamp() >= before && first.getTimestamp() <= after
+          && first.getTotalCents() == 5997 && second.getTotalCents() == 10, "构造时记录当前时间戳，金额按分计算");
+    check(first.getBookTitle().data() == record.getBookTitle().data(), "相同书名只保存一份");
+    
+    std::cout << std::endl;
+}
+
+void testSalesAggregates() {
+    std::cout << "=== 测试 按ISBN的销售汇总 ===" << std::endl;
+    
+    BookManager bookManager;
+    SalesManager salesManager(&bookManager);
+    std::streambuf* coutBuf = std::cout.rdbuf(nullptr);
+    bookManager.addBook(Book("数据结构", "清华大学出版社", "9787302000001", "严蔚敏", 20, 35.50));
+    bookManager.addBook(Book("操作系统", "机械工业出版社", "9787111000002", "汤子瀛", 20, 42.00));
+    bookManager.addBook(Book("编译原理", "机械工业出版社", "9787111000003", "陈火旺", 20, 39.90));
+    salesManager.purchaseBook("9787302000001", 2);
+    salesManager.purchaseBook("9787111000002", 4);
+    salesManager.purchaseBook("9787302000001", 3);
+    salesManager.purchaseBook("9787302000001", 100);    // 库存不足，不计入汇总
+    std::cout.rdbuf(coutBuf);
+    
+    const IsbnSales* ds = salesManager.getSalesByIsbn("978-7-302-00000-1");
+    check(ds && ds->unitsSold == 5 && ds->revenueCents == 17750 && ds->records == std::vector<size_t>({0, 2})
+          && ds->firstSaleTime <= ds->lastSaleTime, "购买时增量维护销量、销售额和倒排表");
+    auto history = salesManager.getSaleRecordsByIsbn("9787302000001");
+    check(history.size() == 2 && history[0]->getQuantity() == 2 && history[1]->getQuantity() == 3
+          && salesManager.getSaleRecordsByIsbn("9787111000003").empty()
+          && !salesManager.getSalesByIsbn("9787111000003"), "单本书的销售历史按倒排表取出");
+    
+    auto best = salesManager.getBestSellers(10);
+    check(best.size() == 2 && best[0]->unitsSold == 5 && best[1]->unitsSold == 4
+          && salesManager.getBestSellers(1).size() == 1, "畅销排行只看有销售的图书");
+    check(salesManager.getTotalSales() == 345.50, "总销售额按分累加");
+    
+    // 日志重放的记录可能更早，首次销售时间取最小值
+    SaleRecord replayed;
+    replayed.parse("9787111000002|操作系统|1|42.00|2000-01-01 00:00:00");
+    salesManager.restoreSaleRecord(replayed);
+    const IsbnSales* os = salesManager.getSalesByIsbn("9787111000002");
+    check(os->unitsSold == 5 && os->firstSaleTime == replayed.getTimestamp() && os->lastSaleTime > os->firstSaleTime,
+          "重放的记录同样计入汇总");
+    
+    // 加载时重建；清空后汇总一并清空
+    coutBuf = std::cout.rdbuf(nullptr);
+    salesManager.saveToFile("test_sales_aggregates.txt");
+    SalesManager loaded(&bookManager);
+    loaded.loadFromFile("test_sales_aggregates.txt");
+    std::cout.rdbuf(coutBuf);
+    std::remove("test_sales_aggregates.txt");
+    std::remove("test_sales_aggregates.txt.rollup");
+    const IsbnSales* loadedOs = loaded.getSalesByIsbn("9787111000002");
+    // 加载时按时间排序，重放的那条最早的记录排到最前面
+    check(loaded.getAllIsbnSales().size() == 2 && loadedOs && loadedOs->unitsSold == 5
+          && loadedOs->records == std::vector<size_t>({0, 2}) && loaded.getTotalSales() == salesManager.getTotalSales(),
+          "加载后重建汇总");
+    salesManager.clear();
+    check(salesManager.getAllIsbnSales().empty() && !salesManager.getSalesByIsbn("9787302000001")
+          && salesManager.getTotalSales() == 0.0, "清空后汇总一并清空");
+    
+    std::cout << std::endl;
+}
+
+void testSalesRollup() {
+    std::cout << "=== 测试 按时间分桶的销售汇总 ===" << std::endl;
+    typedef SalesRollup::Granularity G;
+    
+    BookManager bookManager;
+    SalesManager salesManager(&bookManager);
+    std::streambuf* coutBuf = std::cout.rdbuf(nullptr);
+    bookManager.addBook(Book("数据结构", "清华大学出版社", "9787302000001", "严蔚敏", 20, 10.00));
+    bookManager.addBook(Book("操作系统", "机械工业出版社", "9787111000002", "汤子瀛", 20, 15.00));
+    std::cout.rdbuf(coutBuf);
+    for (const char* line : {"9787302000001|数据结构|2|20.00|2024-03-05 10:15:00",
+                             "9787302000001|数据结构|1|10.00|2024-03-05 10:45:00",
+                             "9787111000002|操作系统|3|45.00|2024-03-20 09:00:00",
+                             "9787111000002|操作系统|1|15.00|2024-04-01 00:30:00"}) {
+        SaleRecord record;
+        record.parse(line);
+        salesManager.restoreSaleRecord(record);
+    }
+    
+    const SalesRollup& rollup = salesManager.getRollup();
+    int64_t march = SalesRollup::monthBucket(2024, 3);
+    SalesRollup::Totals marchTotals = rollup.getTotals(G::Month, march, march);
+    check(marchTotals.units == 6 && marchTotals.revenueCents == 7500 && marchTotals.sales == 3
+          && rollup.getTotals(G::Month, march + 1, march + 1).revenueCents == 1500, "按月合计");
+    
+    auto byPublisher = rollup.getTotalsByPublisher(G::Month, march, march);
+    check(byPublisher.size() == 2 && byPublisher[0].first == "机械工业出版社" && byPublisher[0].second.units == 3
+          && byPublisher[1].first == "清华大学出版社" && byPublisher[1].second.revenueCents == 3000,
+          "三月按出版社的销售额");
+    
+    int64_t firstSale;
+    Timestamp::parse("2024-03-05 10:15:00", firstSale);
+    int64_t day = SalesRollup::bucketOf(G::Day, firstSale);
+    int64_t hour = SalesRollup::bucketOf(G::Hour, firstSale);
+    auto days = rollup.getSeries(G::Day, day, day + 40);
+    check(days.size() == 3 && days[0].first == day && days[0].second.sales == 2
+          && rollup.getSeries(G::Hour, hour, hour)[0].second.units == 3, "按天/按小时的序列只含有销售的桶");
+    check(rollup.getIsbnTotals(G::Day, IsbnKey::parse("9787111000002"), day, day + 40).units == 4
+          && rollup.getIsbnTotals(G::Day, IsbnKey::parse("9787111000002"), day, day).units == 0, "单本书的区间合计");
+    check(SalesRollup::bucketLabel(G::Month, march) == "2024-03" && SalesRollup::bucketLabel(G::Day, day) == "2024-03-05"
+          && SalesRollup::bucketLabel(G::Hour, hour) == "2024-03-05 10时", "桶的文字标签");
+    
+    // 购买时同步更新
+    coutBuf = std::cout.rdbuf(nullptr);
+    salesManager.purchaseBook("9787302000001", 1);
+    std::cout.rdbuf(coutBuf);
+    int64_t today = SalesRollup::bucketOf(G::Day, Timestamp::nowMicros());
+    check(rollup.getTotals(G::Day, today, today).units >= 1, "购买时更新当天的桶");
+    
+    // 随销售数据保存；书库中已没有这些书时，出版社仍来自保存的汇总
+    const std::string salesFile = "test_sales_rollup.txt";
+    coutBuf = std::cout.rdbuf(nullptr);
+    salesManager.saveToFile(salesFile);
+    BookManager emptyCatalog;
+    SalesManager restored(&emptyCatalog);
+    restored.loadFromFile(salesFile);
+    std::cout.rdbuf(coutBuf);
+    auto restoredByPublisher = restored.getRollup().getTotalsByPublisher(G::Month, march, march);
+    check(restoredByPublisher.size() == 2 && restoredByPublisher[1].first == "清华大学出版社"
+          && restored.getRollup().getTotals(G::Hour, hour, hour).units == 3, "加载保存的汇总");
+    
+    // 汇总文件与销售数据不一致时从记录重建
+    {
+        std::ofstream append(salesFile, std::ios::app);
+        append << "9787302000001|数据结构|5|50.00|2024-03-06 08:00:00\n";
+    }
+    coutBuf = std::cout.rdbuf(nullptr);
+    SalesManager rebuilt(&bookManager);
+    rebuilt.loadFromFile(salesFile);
+    std::cout.rdbuf(coutBuf);
+    check(rebuilt.getRollup().getTotals(G::Month, march, march).units == 11, "汇总文件过期时从记录重建");
+    std::remove(salesFile.c_str());
+    std::remove(SalesManager::rollupFileName(salesFile).c_str());
+    
+    salesManager.clear();
+    check(rollup.getTotals(G::Month, march, march).sales == 0, "清空后汇总一并清空");
+    
+    std::cout << std::endl;
+}
+
+void testSaleTimeRange() {
+    std::cout << "=== 测试 按时间区间查询销售记录 ===" << std::endl;
+    
+    BookManager bookManager;
+    SalesManager salesManager(&bookManager);
+    const char* lines[] = {"9787302000001|数据结构|1|10.00|2024-03-01 09:00:00",
+                           "9787302000001|数据结构|2|20.00|2024-03-02 09:00:00",
+                           "9787111000002|操作系统|3|45.00|2024-03-03 09:00:00",
+                           "9787111000002|操作系统|4|60.00|2024-03-04 09:00:00",
+                           "9787302000001|数据结构|5|50.00|2024-03-05 09:00:00"};
+    for (const char* line : lines) {
+        SaleRecord record;
+        record.parse(line);
+        salesManager.restoreSaleRecord(record);
+    }
+    
+    SaleRange range = salesManager.getSaleRecordsBetween("2024-03-02 00:00:00", "2024-03-04 09:00:00");
+    std::vector<int> quantities;
+    for (const SaleRecord& record : range) {
+        quantities.push_back(record.getQuantity());
+    }
+    check(range.size() == 2 && quantities == std::vector<int>({2, 3}) && range[1].getQuantity() == 3,
+          "区间为左闭右开，结果按时间顺序");
+    check(salesManager.getSaleRecordsBetween("2024-03-06 00:00:00", "2024-04-01 00:00:00").empty()
+          && salesManager.getSaleRecordsBetween("2024-03-05 00:00:00", "2024-03-01 00:00:00").empty()
+          && salesManager.getSaleRecordsBetween("三月", "2024-04-01 00:00:00").empty(), "空区间和无效时间");
+    
+    // 时间早于已有记录的追加（如日志重放）仍按时间顺序出现在结果中
+    SaleRecord late;
+    late.parse("9787111000002|操作系统|9|135.00|2024-03-02 12:00:00");
+    salesManager.restoreSaleRecord(late);
+    quantities.clear();
+    int64_t cents = 0;
+    for (const SaleRecord& record : salesManager.getSaleRecordsBetween("2024-03-01 00:00:00", "2024-04-01 00:00:00")) {
+        quantities.push_back(record.getQuantity());
+        cents += record.getTotalCents();
+    }
+    check(quantities == std::vector<int>({1, 2, 9, 3, 4, 5}) && cents == 32000
+          && salesManager.getAllSaleRecords().back().getQuantity() == 9, "乱序追加的记录按时间插入区间结果");
+
+    // 批量重放：时间倒序且有同一时刻的记录，结果与逐条重放相同（同一时刻保持追加顺序）
+    SalesManager oneByOne(&bookManager);
+    SalesManager batched(&bookManager);
+    std::vector<SaleRecord> journalRecords;
+    for (int i = 1; i <= 200; ++i) {
+        char line[96];
+        std::snprintf(line, sizeof(line), "9787302000001|数据结构|%d|%d.00|2024-04-%02d 09:00:00", i, i * 10, 20 - i % 20);
+        SaleRecord record;
+        record.parse(line);
+        oneByOne.restoreSaleRecord(record);
+        journalRecords.push_back(record);
+    }
+    batched.restoreSaleRecord(journalRecords[0]);
+    batched.restoreSaleRecords(std::vector<SaleRecord>(journalRecords.begin() + 1, journalRecords.end()));
+    std::vector<int> expected, actual;
+    for (const SaleRecord& record : oneByOne.getSaleRecordsBetween("2024-04-01 00:00:00", "2024-05-01 00:00:00")) {
+        expected.push_back(record.getQuantity());
+    }
+    for (const SaleRecord& record : batched.getSaleRecordsBetween("2024-04-01 00:00:00", "2024-05-01 00:00:00")) {
+        actual.push_back(record.getQuantity());
+    }
+    check(expected.size() == 200 && actual == expected && expected.front() == 19 && expected[1] == 39
+          && batched.getTotalSales() == oneByOne.getTotalSales(), "批量重放的乱序记录一次排好时间顺序");
+    
+    // 加载乱序的文件时按时间排好序，并标记为需要重写
+    {
+        std::ofstream file("test_time_range.txt");
+        file << lines[3] << "\n" << lines[0] << "\n" << lines[4] << "\n" << lines[1] << "\n";
+    }
+    std::streambuf* coutBuf = std::cout.rdbuf(nullptr);
+    SalesManager loaded(&bookManager);
+    loaded.loadFromFile("test_time_range.txt");
+    std::cout.rdbuf(coutBuf);
+    std::remove("test_time_range.txt");
+    std::remove("test_time_range.txt.rollup");
+    const auto& records = loaded.getAllSaleRecords();
+    check(records.size() == 4 && records[0].getQuantity() == 1 && records[3].getQuantity() == 5 && loaded.isDirty()
+          && loaded.getSaleRecordsBetween("2024-03-02 00:00:00", "2024-03-05 00:00:00").size() == 2,
+          "加载时按时间排序");
+    
+    // 同一秒内的两笔销售：保存并重新加载后仍能按微秒区分，区间查询结果不变
+    SalesManager precise(&bookManager);
+    SaleRecord early, later;
+    early.parse("9787302000001|数据结构|1|10.00|2024-03-06 10:00:00.250000");
+    later.parse("9787302000001|数据结构|2|20.00|2024-03-06 10:00:00.750000");
+    precise.restoreSaleRecord(later);
+    precise.restoreSaleRecord(early);
+    int64_t middle = 0;
+    Timestamp::parse("2024-03-06 10:00:00.5", middle);
+    coutBuf = std::cout.rdbuf(nullptr);
+    precise.saveToFile("test_precise_sales.txt");
+    SalesManager reloaded(&bookManager);
+    reloaded.loadFromFile("test_precise_sales.txt");
+    std::cout.rdbuf(coutBuf);
+    std::remove("test_precise_sales.txt");
+    std::remove("test_precise_sales.txt.rollup");
+    SaleRange before = precise.getSaleRecordsBetween(middle, middle + Timestamp::MICROS_PER_SECOND);
+    SaleRange after = reloaded.getSaleRecordsBetween(middle, middle + Timestamp::MICROS_PER_SECOND);
+    check(before.size() == 1 && after.size() == 1 && after[0].getQuantity() == 2
+          && reloaded.getAllSaleRecords()[0].getTimestamp() == early.getTimestamp(), "重新加载后保留微秒");
+    
+    std::cout << std::endl;
+}
+
+void testPurchaseBatch() {
+    std::cout << "=== 测试批量购买 ===" << std::endl;
+    
+    BookManager bookManager;
+    SalesManager salesManager(&bookManager);
+    bookManager.addBook(Book("数据结构", "清华大学出版社", "9787302000001", "严蔚敏", 5, 35.50));
+    bookManager.addBook(Book("操作系统", "机械工业出版社", "9787111000002", "汤小丹", 3, 49.00));
+    
+    std::streambuf* coutBuf = std::cout.rdbuf(nullptr);
+    PurchaseReceipt receipt = salesManager.purchaseBatch({{"9787302000001", 2}, {"9787111000002", 1}, {"9787302000001", 1}});
+    std::cout.rdbuf(coutBuf);
+    check(receipt.ok() && receipt.lines.size() == 3 && receipt.totalCents == 3 * 3550 + 4900
+          && receipt.lines[1].title == "操作系统" && receipt.lines[2].unitCents == 3550, "收据逐行对应、合计正确");
+    const auto& records = salesManager.getAllSaleRecords();
+    check(records.size() == 3 && records[0].getTimestamp() == receipt.saleTime && records[2].getTimestamp() == receipt.saleTime,
+          "整批记录共用一个销售时间");
+    check(bookManager.getStock("9787302000001") == 2 && bookManager.getStock("9787111000002") == 2
+          && salesManager.getSalesByIsbn("9787302000001")->unitsSold == 3, "按合并后的数量扣库存");
+    
+    // 任一行不通过则整批不生效
+    PurchaseReceipt failed = salesManager.purchaseBatch({{"9787111000002", 1}, {"9787302000001", 2}, {"9787302000001", 1}});
+    check(failed.status == PurchaseReceipt::Status::InsufficientStock && failed.failedLine == 2 && failed.lines.empty(),
+          "同一ISBN多行累计超出库存");
+    check(salesManager.purchaseBatch({{"9787111000002", 1}, {"9999999999", 1}}).status == PurchaseReceipt::Status::BookNotFound
+          && salesManager.purchaseBatch({{"9787111000002", 0}}).status == PurchaseReceipt::Status::InvalidQuantity
+          && salesManager.purchaseBatch({}).status == PurchaseReceipt::Status::Empty, "不存在的编号、无效数量和空批次");
+    check(records.size() == 3 && bookManager.getStock("9787302000001") == 2 && bookManager.getStock("9787111000002") == 2,
+          "失败的批次不修改库存和销售记录");
+    
+    // 整批写成日志中的一帧，恢复时逐条重放
+    const std::string booksFile = "test_batch_books.txt";
+    const std::string salesFile = "test_batch_sales.txt";
+    auto cleanup = [&]() {
+        for (const std::string& f : {booksFile, salesFile, salesFile + ".journal", SalesManager::rollupFileName(salesFile)}) {
+            std::remove(f.c_str());
+        }
+    };
+    cleanup();
+    coutBuf = std::cout.rdbuf(nullptr);
+    {
+        FileManager fileManager(booksFile, salesFile);
+        fileManager.saveAllData(&bookManager, &salesManager);
+        fileManager.enableJournal(&salesManager, SalesJournal::SyncPolicy::EveryRecord);
+        salesManager.purchaseBatch({{"9787302000001", 1}, {"9787111000002", 2}});
+        check(salesManager.getJournal()->getLastSeq() == 1, "一批只占一个日志序号");
+        salesManager.attachJournal(nullptr);
+    }
+    BookManager recoveredBooks;
+    SalesManager recoveredSales(&recoveredBooks);
+    FileManager(booksFile, salesFile).loadAllData(&recoveredBooks, &recoveredSales);
+    std::cout.rdbuf(coutBuf);
+    cleanup();
+    check(recoveredSales.getAllSaleRecords().size() == 5 && recoveredBooks.getStock("9787302000001") == 1
+          && recoveredBooks.getStock("9787111000002") == 0, "从日志恢复整批记录和库存");
+    
+    std::cout << std::endl;
+}
+
+void testConcurrentCatalog() {
+    std::cout << "=== 测试多线程并发购买与查询 ===" << std::endl;
+    
+    BookManager bookManager;
+    SalesManager salesManager(&bookManager);
+    StatisticsManager statisticsManager(&bookManager, &salesManager);
+    ConcurrentCatalog catalog(&bookManager, &salesManager);
+    const int books = 50, initialStock = 20;
+    std::vector<std::string> isbns;
+    std::ostringstream captured;
+    std::streambuf* coutBuf = std::cout.rdbuf(captured.rdbuf());
+    for (int i = 0; i < books; ++i) {
+        isbns.push_back("CC" + std::to_string(i));
+        catalog.addBook(Book("并发图书" + std::to_string(i), "出版社" + std::to_string(i % 5), isbns.back(),
+                             "作者", initialStock, 10.0 + i));
+    }
+    Book extra("临时图书", "出版社0", "CCX", "作者", 1, 1.0);
+    bool edited = catalog.addBook(extra) && !catalog.addBook(extra) && catalog.deleteBook("CCX") && !catalog.deleteBook("CCX");
+    std::cout.rdbuf(coutBuf);
+    check(edited && captured.str().empty() && catalog.read([](const BookManager& bm, const SalesManager&) {
+              return bm.getBookCount();
+          }) == books, "增删图书在锁内不向控制台输出");
+    check(catalog.restock("CC0", 5) && catalog.getStock("CC0") == initialStock + 5 && !catalog.restock("CC0", -1)
+          && catalog.findBookByIsbn("CC1")->getTitle() == "并发图书1" && !catalog.findBookByIsbn("CC99"), "单线程进货与查询");
+    const int totalStock = books * initialStock + 5;
+    
+    // 4个线程抢购（一篮1~3行），2个线程同时查询；每个快照里 库存+已售 必须等于总进货量
+    const int buyers = 4, attempts = 1500;
+    std::vector<std::vector<int>> sold(buyers, std::vector<int>(books, 0));
+    std::vector<int> receiptLines(buyers, 0);
+    std::atomic<int> buying(buyers);
+    std::atomic<int> badSnapshots(0), snapshots(0), failedSearches(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < buyers; ++t) {
+        threads.emplace_back([&, t] {
+            std::mt19937 rng(static_cast<unsigned>(t + 1));
+            for (int a = 0; a < attempts; ++a) {
+                std::vector<PurchaseLine> basket;
+                std::vector<int> picked;
+                for (int l = 0; l < 1 + static_cast<int>(rng() % 3); ++l) {
+                    picked.push_back(static_cast<int>(rng() % books));
+                    basket.push_back(PurchaseLine{isbns[picked.back()], 1 + static_cast<int>(rng() % 3)});
+                }
+                PurchaseReceipt receipt = catalog.purchase(basket);
+                if (receipt.ok()) {
+                    for (size_t l = 0; l < basket.size(); ++l) {
+                        sold[t][picked[l]] += basket[l].quantity;
+                    }
+                    receiptLines[t] += static_cast<int>(receipt.lines.size());
+                }
+            }
+            --buying;
+        });
+    }
+    for (int r = 0; r < 2; ++r) {
+        threads.emplace_back([&, r] {
+            while (buying > 0) {
+                bool consistent = catalog.read([&](const BookManager& bm, const SalesManager& sm) {
+                    long long units = 0;
+                    for (const auto& entry : sm.getAllIsbnSales()) {
+                        units += entry.unitsSold;
+                    }
+                    long long stock = 0;
+                    for (int value : bm.getStockColumn()) {
+                        if (value < 0) {
+                            return false;
+                        }
+                        stock += value;
+                    }
+                    return stock + units == totalStock;
+                });
+                badSnapshots += !consistent;
+                ++snapshots;
+                failedSearches += catalog.findBooksByPublisher("出版社" + std::to_string(r)).size() != books / 5;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    check(badSnapshots == 0 && failedSearches == 0, "并发查询看到的始终是一致的快照（" + std::to_string(snapshots) + "次）");
+    bool noOversell = true;
+    int totalSold = 0, totalLines = 0;
+    for (int i = 0; i < books; ++i) {
+        int units = 0;
+        for (int t = 0; t < buyers; ++t) {
+            units += sold[t][i];
+        }
+        const IsbnSales* sales = salesManager.getSalesByIsbn(isbns[i]);
+        int stock = catalog.getStock(isbns[i]);
+        noOversell = noOversell && stock >= 0 && stock + units == initialStock + (i == 0 ? 5 : 0)
+                     && (sales ? sales->unitsSold : 0) == units;
+        totalSold += units;
+    }
+    for (int t = 0; t < buyers; ++t) {
+        totalLines += receiptLines[t];
+    }
+    check(noOversell && totalSold > 0, "没有超卖：每本书 库存+售出 等于进货量，与销售汇总一致");
+    check(catalog.getSaleCount() == static_cast<size_t>(totalLines) && statisticsManager.verifyRunningStats(),
+          "销售记录数与成功收据一致，增量统计与全量重算一致");
+    
+    // 挂接日志后并发购买：校验和写日志在共享锁内进行，日志中的每一帧都对应一次已生效的购买
+    SalesJournal journal;
+    std::remove("test_catalog_journal.log");
+    journal.open("test_catalog_journal.log");
+    journal.setSyncPolicy(SalesJournal::SyncPolicy::EveryRecord);
+    catalog.write([&](BookManager&, SalesManager& sm) { sm.attachJournal(&journal); });
+    for (int i = 0; i < 2 * buyers; ++i) {
+        catalog.restock(isbns[i], 10);
+    }
+    size_t salesBefore = catalog.getSaleCount();
+    std::atomic<int> journaled(0);
+    threads.clear();
+    for (int t = 0; t < buyers; ++t) {
+        threads.emplace_back([&, t] {
+            for (int a = 0; a < 10; ++a) {
+                journaled += catalog.purchase({PurchaseLine{isbns[t], 1}, PurchaseLine{isbns[t + buyers], 1}}).ok();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    catalog.write([](BookManager&, SalesManager& sm) { sm.attachJournal(nullptr); });
+    journal.close();
+    size_t frames = 0, replayedLines = 0;
+    uint64_t previous = 0;
+    SalesJournal::replay("test_catalog_journal.log", 0, [&](uint64_t seq, const SaleRecord&) {
+        frames += seq != previous;
+        previous = seq;
+        ++replayedLines;
+    });
+    std::remove("test_catalog_journal.log");
+    check(journaled > 0 && frames == static_cast<size_t>(journaled.load())
+          && replayedLines == catalog.getSaleCount() - salesBefore && statisticsManager.verifyRunningStats(),
+          "并发购买的日志帧与生效的购买一一对应");
+    
+    std::cout << std::endl;
+}
+
 int main() {
     std::cout << "========================================" << std::endl;
     std::cout << "     图书管理系统功能测试" << std::endl;
@@ -177,6 +1718,28 @@ int main() {
         testSalesManager();
         testStatisticsManager();
         testFileManager();
+        testIsbnIndex();
+        testSecondaryIndex();
+        testParallelLoader();
+        testSalesJournal();
+        testAtomicSave();
+        testIncrementalSave();
+        testColumnStore();
+        testStatsKernels();
+        testRunningStats();
+        testRanking();
+        testOrderIndex();
+        testReorderAlerts();
+        testValueStorage();
+        testGetterReferences();
+        testStringPool();
+        testIsbnKey();
+        testCompactSaleRecord();
+        testSalesAggregates();
+        testSalesRollup();
+        testSaleTimeRange();
+        testPurchaseBatch();
+        testConcurrentCatalog();
         
         std::cout << "========================================" << std::endl;
         std::cout << "     所有测试完成！" << std::endl;
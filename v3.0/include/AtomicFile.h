@@ -0,0 +1,79 @@
+#ifndef ATOMICFILE_H
+#define ATOMICFILE_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstdio>
+#include <cstdint>
+
+// 原子文件写入：先写同目录下的临时文件"<目标>.tmp"，fsync后改名覆盖目标文件，再fsync所在目录
+// 任何一步失败（或写到一半进程被杀死）目标文件都保持上一次完整保存的内容
+class AtomicFile {
+private:
+    // 大块缓冲的输出缓冲区，满了才一次性写入临时文件
+    class Buffer : public std::streambuf {
+    public:
+        Buffer(AtomicFile& owner, size_t size);
+        bool flushBuffer();
+    protected:
+        int_type overflow(int_type ch) override;
+        int sync() override;
+    private:
+        AtomicFile& owner;
+        std::vector<char> data;
+    };
+
+    std::string targetPath;
+    std::string tempPath;
+    FILE* file;
+    uint64_t written;           // 已写入临时文件的字节数
+    int64_t crashAfter;         // 故障注入：写到该字节数时模拟进程被杀死，<0表示不注入
+    bool crashed;
+    bool committed;
+    Buffer buffer;
+    std::ostream out;
+
+    // 禁止拷贝
+    AtomicFile(const AtomicFile&) = delete;
+    AtomicFile& operator=(const AtomicFile&) = delete;
+
+    bool writeRaw(const char* data, size_t length);
+
+public:
+    static const size_t DEFAULT_BUFFER_SIZE = 1 << 20;
+
+    explicit AtomicFile(const std::string& target, size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+    // 未提交时删除临时文件，目标文件不受影响
+    ~AtomicFile();
+
+    bool isOpen() const { return file != nullptr; }
+
+    // 写入用的输出流
+    std::ostream& stream() { return out; }
+
+    // commit()的结果
+    enum class CommitResult {
+        Failed,                 // 目标文件没有改动
+        Replaced,               // 已改名覆盖目标文件，改名也已落盘
+        DirectorySyncFailed     // 已改名覆盖目标文件，但fsync目录失败：掉电后可能变回旧文件
+    };
+
+    // 刷新缓冲、fsync临时文件、改名覆盖目标文件并fsync目录
+    CommitResult commit();
+
+    // 放弃本次写入
+    void discard();
+
+    const std::string& getTempPath() const { return tempPath; }
+
+    // 测试用故障注入：此后创建的AtomicFile写出limit字节后模拟进程被杀死
+    // （临时文件残留、不改名、不清理），limit<0关闭注入
+    static void setCrashAfterBytes(int64_t limit);
+
+    // 测试用故障注入：此后的commit()在改名成功后按fsync目录失败处理
+    static void setFailDirectorySync(bool fail);
+};
+
+#endif // ATOMICFILE_H
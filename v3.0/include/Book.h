@@ -2,16 +2,25 @@
 #define BOOK_H
 
 #include <string>
+#include <memory>
+#include "TextArena.h"
 
 class Book {
 private:
-    std::string title;
-    std::string publisher;
-    std::string isbn;
-    std::string author;
+    // 字符串字段都存放在text指向的内存块中：加载书库时全部图书共用一块，
+    // 单独构造或修改的图书各用一块小的；复制Book只复制引用，不复制字符
+    std::shared_ptr<const TextArena> text;
+    TextRef title;
+    TextRef publisher;
+    TextRef isbn;
+    TextRef author;
     int stock;
     double price;
 
+    // 把四个字符串字段一起复制进新的内存块（setter和流式读取用）
+    void assignText(const TextRef& newTitle, const TextRef& newPublisher,
+                    const TextRef& newISBN, const TextRef& newAuthor);
+
 public:
     // constructor & deconstructor
     Book();  
@@ -23,11 +32,11 @@ public:
     // copy constructor
     Book(const Book& x);
     
-    // Getter
-    std::string getTitle() const;
-    std::string getPublisher() const;
-    std::string getISBN() const;
-    std::string getAuthor() const;
+    // Getter（字符串字段返回指向内存块的引用，查询和排序时不复制）
+    TextRef getTitle() const;
+    TextRef getPublisher() const;
+    TextRef getISBN() const;
+    TextRef getAuthor() const;
     int getStock() const;
     double getPrice() const;
     
@@ -42,6 +51,13 @@ public:
     // to_string函数
     std::string toString() const;
     
+    // 从内存中的二进制记录直接解析（格式同operator<<）
+    // 返回记录末尾的下一个位置；记录越界或长度非法时返回NULL
+    // 字符串字段复制进arena（批量加载时全部记录共用，容量取文件大小即可），不逐字段分配
+    const char* fromBinary(const char* data, const char* end, const std::shared_ptr<TextArena>& arena);
+    // 单条记录：字段复制进按记录大小分配的内存块
+    const char* fromBinary(const char* data, const char* end);
+    
     Book& operator=(const Book& x);
     friend std::ostream& operator<<(std::ostream& os, const Book& book);
     friend std::istream& operator>>(std::istream& is, Book& book);
@@ -3,7 +3,23 @@
 
 #include <vector>
 #include <string>
+#include <set>
+#include <utility>
 #include "Book.h"
+#include "NgramIndex.h"
+#include "AtomicFile.h"
+
+// 书库文件格式
+enum FileFormat {
+    FORMAT_LEGACY,      // 旧版：图书数量 + 逐条记录
+    FORMAT_CATALOG      // 带版本、分块CRC32C校验和ISBN尾部索引（见CatalogFile.h）
+};
+
+// 排行依据
+enum RankKey {
+    RANK_BY_PRICE,
+    RANK_BY_STOCK
+};
 
 class BookManager {
 private:
@@ -11,6 +27,37 @@ private:
     // 查找图书索引
     int findIndex(const std::string& isbn) const;
 
+    // 书名/作者/出版社的n-gram索引，文档编号即books下标
+    mutable NgramIndex titleIndex;
+    mutable NgramIndex authorIndex;
+    mutable NgramIndex publisherIndex;
+    mutable bool searchIndexStale;  // 删除图书后下标整体前移，留到下次查询时再重建
+    mutable long long totalStock;   // 随增删改增量维护的总库存量
+    mutable bool totalStockStale;   // 整体加载或外部直接修改后，留到下次读取时重算
+    // 有序索引：(价格, 记录编号) / (库存, 记录编号)，增删改和调库存时都增量维护
+    // 记录编号在图书加入时分配、之后不变，删除只需移除该书的两项，不必整体重建
+    typedef std::set<std::pair<double, size_t> > OrderIndex;
+    static const size_t NO_POSITION = static_cast<size_t>(-1);
+    mutable OrderIndex priceOrder;
+    mutable OrderIndex stockOrder;
+    mutable std::vector<size_t> recordIds;  // books[i]的记录编号
+    mutable std::vector<size_t> positions;  // 记录编号 -> books下标（已删除的为NO_POSITION）
+    mutable bool orderIndexStale;           // 只有通过getAllBooks()直接修改后才需要整体重建
+    void orderBook(size_t index);
+    void unorderBook(size_t index);
+    void rebuildOrderIndex() const;
+    void ensureOrderIndex() const;
+    // 区间查询：返回值在[low, high]内的图书下标（按值升序），O(log n + k)
+    std::vector<size_t> rangeIndices(const OrderIndex& index, double low, double high) const;
+    void indexBook(size_t index);
+    void unindexBook(size_t index);
+    void ensureSearchIndex() const;
+    // 模糊查询：返回字段包含keyword的图书下标（升序）
+    std::vector<size_t> matchIndices(const NgramIndex& index, TextRef (Book::*field)() const,
+                                     const std::string& keyword) const;
+    // 排行第[offset, offset+limit)名的图书下标：降序，并列时按books中的先后
+    std::vector<size_t> rankIndices(RankKey key, size_t offset, size_t limit) const;
+
 public:
     BookManager();
     ~BookManager();
@@ -37,23 +84,46 @@ public:
     // 删除
     bool deleteBook(const std::string& isbn);
     
+    // 调整库存（销售时delta为负），库存不足或图书不存在时返回false
+    bool updateStock(const std::string& isbn, int delta);
+    // 批量根据ISBN查找，一次遍历，结果与isbns逐个对应（不存在时为nullptr）
+    std::vector<const Book*> findByISBNs(const std::vector<std::string>& isbns) const;
+    // 批量查找下标：一次遍历books，结果与isbns逐个对应，不存在时为-1
+    std::vector<int> findIndices(const std::vector<std::string>& isbns) const;
+    // 批量调整库存：changes为(findIndices得到的下标, 变化量)，同一本书的多项合并计算，
+    // 全部可行才一起修改，否则（含下标越界）什么都不改并返回false
+    bool updateStocks(const std::vector<std::pair<int, int> >& changes);
+    
     /*全局功能*/
+    // 注意：通过非const版本（或findByISBN返回的指针）直接修改图书后，需要调用 invalidateSearchIndex()
     std::vector<Book>& getAllBooks();   // 获取所有图书
     const std::vector<Book>& getAllBooks() const;
         
     size_t getBookAmount() const;        // 图书总数
+    long long getTotalStock() const;    // 总库存量，O(1)
     void clear();                       // 清空所有图书
+    void invalidateSearchIndex();       // 标记模糊查询索引、有序索引和总库存量失效
     /*添加ISBN正确性检查功能？*/
     
 
-    // 按价格排序（降序）
+    // 按价格排序（降序），直接遍历有序索引，O(n)
     std::vector<Book*> sortByPrice();
-    // 按库存量排序（降序）
+    // 按库存量排序（降序），直接遍历有序索引，O(n)
     std::vector<Book*> sortByStock();
     
-    // 保存到文件
-    bool saveFile(const std::string& filename);
-    // 从文件加载
+    // 区间查询（闭区间，按值升序），O(log n + k)
+    std::vector<Book*> findByPriceRange(double low, double high);
+    std::vector<Book*> findByStockRange(int low, int high);
+    
+    // 排行榜：只做部分选择，前k名代价O(n log k)，不必整体排序
+    std::vector<Book*> topKByPrice(size_t k);
+    std::vector<Book*> topKByStock(size_t k);
+    // 分页：第offset名起的limit本（从0计），越过末尾时截断
+    std::vector<Book*> rankRange(RankKey key, size_t offset, size_t limit);
+    
+    // 保存到文件，结果同AtomicFile::commit()
+    AtomicFile::CommitResult saveFile(const std::string& filename, FileFormat format = FORMAT_LEGACY);
+    // 从文件加载（按文件头自动识别格式）
     bool loadFile(const std::string& filename);
 };
 
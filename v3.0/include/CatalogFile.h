@@ -0,0 +1,44 @@
+#ifndef CATALOGFILE_H
+#define CATALOGFILE_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "Book.h"
+#include "MappedFile.h"
+#include "AtomicFile.h"
+
+// 带版本与校验的二进制书库格式（与旧版books.dat并存，加载时按魔数自动识别）
+//
+//   文件头  : "BMSCATLG" | 版本(u16) | 字节序标记(u16) | 每块记录数(u32) | 记录总数(u64) | 头部CRC32C(u32) | 保留(u32)
+//   数据块  : 记录数(u32) | 负载长度(u32) | 负载CRC32C(u32) | 负载（记录格式同Book的operator<<）
+//   尾部索引: 块数(u32) | 各块偏移(u64)... | 条目数(u64) | 按ISBN升序的 (ISBN长度(u32), ISBN, 块号(u32), 块内偏移(u32))...
+//   文件尾  : 尾部索引偏移(u64) | 尾部索引长度(u32) | 尾部索引CRC32C(u32) | "BMSFOOT1"
+//
+// 整数按本机字节序写入，读取时用字节序标记判断是否与本机一致
+class CatalogFile {
+public:
+    static const uint16_t VERSION = 1;
+
+    // CRC32C（Castagnoli多项式）
+    static uint32_t crc32c(const char* data, size_t length, uint32_t crc = 0);
+
+    // 判断映射的文件是否为本格式
+    static bool isCatalogFile(const MappedFile& file);
+
+    // 写出整个书库，结果同AtomicFile::commit()
+    static AtomicFile::CommitResult write(const std::string& filename, const std::vector<Book>& books,
+                      uint32_t recordsPerBlock = 256);
+
+    // 读取并校验全部记录
+    static bool readAll(const MappedFile& file, std::vector<Book>& books);
+
+    // 借助尾部索引直接定位单条记录，只校验其所在的数据块
+    static bool readBook(const std::string& filename, const std::string& isbn, Book& book);
+
+    // 部分加载：只读取给定ISBN所在的数据块，找不到的ISBN被忽略
+    static bool readBooks(const std::string& filename, const std::vector<std::string>& isbns,
+                          std::vector<Book>& books);
+};
+
+#endif // CATALOGFILE_H
@@ -0,0 +1,36 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+
+// 只读内存映射文件：把整个文件映射进地址空间，按需由缺页中断读入
+// 用于大体量books.dat的零拷贝加载
+class MappedFile {
+private:
+    const char* mapped;
+    size_t length;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fd;
+#endif
+
+    // 禁止拷贝（映射句柄只能释放一次）
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+public:
+    MappedFile();
+    ~MappedFile();
+
+    bool open(const std::string& filename);     // 失败（含空文件）返回false
+    void close();
+
+    const char* data() const {return mapped;}
+    size_t size() const {return length;}
+    bool isOpen() const {return mapped != 0;}
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,37 @@
+#ifndef NGRAMINDEX_H
+#define NGRAMINDEX_H
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <stdint.h>
+#include "TextArena.h"
+
+// 基于UTF-8字符的n-gram倒排索引（单字 + 双字），用于加速"包含"查询
+// 中文书名按字符而不是按字节切分，所以两个汉字就能组成一个gram
+// 注意：查询只给出候选集，调用方仍需用 find 做最终校验
+class NgramIndex {
+private:
+    typedef std::vector<uint32_t> Postings;     // 升序排列的文档编号
+    std::unordered_map<uint64_t, Postings> postings;
+
+    // 把字符串拆成码点序列；strict为true时遇到非法UTF-8返回false
+    static bool decode(const TextRef& text, std::vector<uint32_t>& codepoints, bool strict);
+    // 提取去重后的gram键
+    static void extractGrams(const std::vector<uint32_t>& codepoints, std::vector<uint64_t>& grams);
+
+public:
+    NgramIndex();
+    ~NgramIndex();
+
+    // 登记/注销编号为id的文档
+    void add(uint32_t id, const TextRef& text);
+    void remove(uint32_t id, const TextRef& text);
+    void clear();
+
+    // 求包含query的候选文档编号（升序）
+    // 返回false表示索引无法处理该查询（空串或非法UTF-8），调用方应退回全表扫描
+    bool candidates(const std::string& query, std::vector<uint32_t>& result) const;
+};
+
+#endif // NGRAMINDEX_H
@@ -2,8 +2,40 @@
 #define SALESYS_H
 
 #include <string>
+#include <vector>
 #include "BookManager.h"
 
+// 批量购买中的一行
+struct PurchaseLine {
+    std::string isbn;
+    int quantity;
+};
+
+// 批量购买的结果：成功时lines与请求逐行对应；失败时库存没有任何改动，failedLine是第一条出问题的行
+struct Receipt {
+    enum Status {
+        OK,
+        EMPTY,              // 没有要购买的图书
+        INVALID_QUANTITY,   // 购买数量不是正数
+        BOOK_NOT_FOUND,     // 图书不存在
+        INSUFFICIENT_STOCK  // 库存不足（同一ISBN的多行按合计数量算）
+    };
+    struct Line {
+        std::string isbn;
+        std::string title;
+        int quantity;
+        double unitPrice;
+        double amount;
+    };
+    
+    Status status;
+    size_t failedLine;
+    std::vector<Line> lines;
+    double total;
+    
+    Receipt() : status(OK), failedLine(0), total(0.0) {}
+};
+
 class SaleSys {
 private:
     BookManager* bookManager;   // 使用指针，避免从头建立books对象
@@ -14,6 +46,8 @@ public:
     
     // 购买图书
     bool purchaseBook(const std::string& isbn, int quantity);
+    // 批量购买：一次遍历查找全部图书，全部校验通过后一起扣减库存，否则什么都不改
+    Receipt purchaseBatch(const std::vector<PurchaseLine>& lines);
     // 计算购买总价
     double totalConsume(const std::string& isbn, int quantity) const;
 };
@@ -16,7 +16,7 @@ public:
     // 获取图书总数
     size_t getTotalBooks() const;
     // 获取总库存量
-    int getTotalStock() const;
+    long long getTotalStock() const;
     
     // 按作者进行统计
     std::vector<Book*> getBooksByAuthor(const std::string& author);
@@ -26,6 +26,14 @@ public:
     // 按价格/库存量进行统计（降序）
     std::vector<Book*> getBooksSortedByPrice();
     std::vector<Book*> getBooksSortedByStock();
+    // 价格/库存量前k名（降序），只做部分排序
+    std::vector<Book*> getTopBooksByPrice(size_t k);
+    std::vector<Book*> getTopBooksByStock(size_t k);
+    
+    // 按价格区间统计
+    std::vector<Book*> getBooksInPriceRange(double low, double high);
+    // 库存预警：库存低于threshold的图书
+    std::vector<Book*> getLowStockBooks(int threshold);
 };
 
 #endif // STATISTICSSYSTEM_H
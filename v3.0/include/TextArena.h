@@ -0,0 +1,62 @@
+#ifndef TEXTARENA_H
+#define TEXTARENA_H
+
+#include <string>
+#include <memory>
+#include <iosfwd>
+#include <cstddef>
+#include <cstring>
+
+// 指向一段只读字符的引用（不拥有内存）；存进TextArena的字符串之后总跟着'\0'，可以直接c_str()
+// 从C字符串或std::string隐式构造时引用该字符串本身，只用于临时比较和查询
+class TextRef {
+private:
+    const char* ptr;
+    size_t len;
+
+public:
+    TextRef() : ptr(""), len(0) {}
+    TextRef(const char* data, size_t length) : ptr(data), len(length) {}
+    TextRef(const char* s) : ptr(s), len(std::strlen(s)) {}
+    TextRef(const std::string& s) : ptr(s.c_str()), len(s.size()) {}
+
+    const char* data() const {return ptr;}
+    const char* c_str() const {return ptr;}
+    size_t size() const {return len;}
+    size_t length() const {return len;}
+    bool empty() const {return len == 0;}
+    std::string str() const {return std::string(ptr, len);}
+    operator std::string() const {return str();}
+
+    // 同std::string::find，找不到时返回std::string::npos
+    size_t find(const TextRef& s) const;
+
+    friend bool operator==(const TextRef& a, const TextRef& b);
+    friend bool operator!=(const TextRef& a, const TextRef& b) {return !(a == b);}
+    friend bool operator<(const TextRef& a, const TextRef& b);
+    friend std::ostream& operator<<(std::ostream& os, const TextRef& s);
+};
+
+// 只追加的字符内存块：一次分配，存入的字符串地址不再变化
+// 加载书库时全部图书的字符串字段复制进同一块，代替逐字段分配std::string
+class TextArena {
+private:
+    std::unique_ptr<char[]> buffer;
+    size_t capacity;
+    size_t used;
+
+    // 禁止拷贝（TextRef指向块内地址）
+    TextArena(const TextArena&);
+    TextArena& operator=(const TextArena&);
+
+public:
+    explicit TextArena(size_t capacity);
+
+    // 复制length个字符并补'\0'，共占length + 1字节；容量不足时抛出std::length_error
+    TextRef store(const char* data, size_t length);
+    TextRef store(const TextRef& s) {return store(s.data(), s.size());}
+
+    size_t remaining() const {return capacity - used;}
+};
+
+#endif // TEXTARENA_H
@@ -0,0 +1,172 @@
+#include "../include/AtomicFile.h"
+#include <atomic>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    std::atomic<int64_t> crashAfterBytes(-1);
+    std::atomic<bool> failDirectorySync(false);
+
+    // 把FILE*中的数据真正写到磁盘
+    bool syncFile(FILE* file) {
+        if (std::fflush(file) != 0) {
+            return false;
+        }
+#ifdef _WIN32
+        return _commit(_fileno(file)) == 0;
+#else
+        return fsync(fileno(file)) == 0;
+#endif
+    }
+
+    // 用临时文件替换目标文件（同一文件系统内是原子的）
+    bool replaceFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+        return MoveFileExA(from.c_str(), to.c_str(),
+                           MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+    }
+
+    // fsync目标文件所在目录，使改名本身落盘（Windows由MOVEFILE_WRITE_THROUGH保证）
+    bool syncParentDirectory(const std::string& path) {
+#ifdef _WIN32
+        (void)path;
+        return true;
+#else
+        size_t slash = path.find_last_of('/');
+        std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+        int fd = ::open(dir.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        // 部分文件系统不支持对目录fsync，此时无法做得更多
+        bool ok = fsync(fd) == 0 || errno == EINVAL;
+        ::close(fd);
+        return ok;
+#endif
+    }
+}
+
+AtomicFile::Buffer::Buffer(AtomicFile& o, size_t size) : owner(o), data(size > 0 ? size : 1) {
+    setp(data.data(), data.data() + data.size());
+}
+
+// 把缓冲区内容写入临时文件
+bool AtomicFile::Buffer::flushBuffer() {
+    size_t length = static_cast<size_t>(pptr() - pbase());
+    setp(data.data(), data.data() + data.size());
+    return length == 0 || owner.writeRaw(data.data(), length);
+}
+
+AtomicFile::Buffer::int_type AtomicFile::Buffer::overflow(int_type ch) {
+    if (!flushBuffer()) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(ch);
+        pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+int AtomicFile::Buffer::sync() {
+    return flushBuffer() ? 0 : -1;
+}
+
+// 构造函数：创建（或覆盖上次残留的）临时文件
+AtomicFile::AtomicFile(const std::string& target, size_t bufferSize)
+    : targetPath(target), tempPath(target + ".tmp"), file(nullptr), written(0),
+      crashAfter(crashAfterBytes.load()), crashed(false), committed(false),
+      buffer(*this, bufferSize), out(&buffer) {
+    file = std::fopen(tempPath.c_str(), "wb");
+    if (file) {
+        // 自己做了大块缓冲，不需要stdio再缓冲一次
+        std::setvbuf(file, nullptr, _IONBF, 0);
+    } else {
+        out.setstate(std::ios::badbit);
+    }
+}
+
+// 析构函数
+AtomicFile::~AtomicFile() {
+    if (!committed && !crashed) {
+        discard();
+    } else if (file) {
+        std::fclose(file);
+    }
+}
+
+// 写入临时文件（故障注入在这里截断）
+bool AtomicFile::writeRaw(const char* data, size_t length) {
+    if (!file || crashed) {
+        return false;
+    }
+    if (crashAfter >= 0 && written + length > static_cast<uint64_t>(crashAfter)) {
+        // 模拟写到一半时进程被杀死：只写出限额内的部分就停止
+        size_t partial = static_cast<size_t>(static_cast<uint64_t>(crashAfter) - written);
+        std::fwrite(data, 1, partial, file);
+        written += partial;
+        crashed = true;
+        return false;
+    }
+    if (std::fwrite(data, 1, length, file) != length) {
+        return false;
+    }
+    written += length;
+    return true;
+}
+
+// 提交：刷新 -> fsync -> 改名 -> fsync目录
+AtomicFile::CommitResult AtomicFile::commit() {
+    if (!file || committed || crashed) {
+        return CommitResult::Failed;
+    }
+    if (!out.flush() || !buffer.flushBuffer() || crashed || !syncFile(file)) {
+        if (!crashed) {
+            discard();
+        }
+        return CommitResult::Failed;
+    }
+
+    bool closed = std::fclose(file) == 0;
+    file = nullptr;
+    if (!closed || !replaceFile(tempPath, targetPath)) {
+        std::remove(tempPath.c_str());
+        return CommitResult::Failed;
+    }
+    // 改名已经成功，目标文件就是新内容；目录没能落盘只影响掉电后能否保留这次改名
+    committed = true;
+    if (failDirectorySync.load() || !syncParentDirectory(targetPath)) {
+        return CommitResult::DirectorySyncFailed;
+    }
+    return CommitResult::Replaced;
+}
+
+// 放弃本次写入
+void AtomicFile::discard() {
+    if (file) {
+        std::fclose(file);
+        file = nullptr;
+    }
+    if (!committed) {
+        std::remove(tempPath.c_str());
+    }
+    out.setstate(std::ios::badbit);
+}
+
+void AtomicFile::setCrashAfterBytes(int64_t limit) {
+    crashAfterBytes.store(limit);
+}
+
+void AtomicFile::setFailDirectorySync(bool fail) {
+    failDirectorySync.store(fail);
+}
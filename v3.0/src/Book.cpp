@@ -1,25 +1,29 @@
 #include "../include/Book.h"
 #include <sstream>
 #include <iomanip>
+#include <cstring>
+#include <cstddef>
 
 Book::Book() : stock(0), price(0.0) {}
 
 Book::Book(const std::string& title, const std::string& publisher, 
            const std::string& isbn, const std::string& author, 
            int stock, double price) 
-    : title(title), publisher(publisher), isbn(isbn), author(author), 
-      stock(stock), price(price) {}
+    : stock(stock), price(price) {
+    assignText(title, publisher, isbn, author);
+}
 
 Book::~Book() {}
 
-// copy constructor
+// copy constructor（与原对象共用内存块）
 Book::Book(const Book& x) 
-    : title(x.title), publisher(x.publisher), isbn(x.isbn), 
+    : text(x.text), title(x.title), publisher(x.publisher), isbn(x.isbn), 
       author(x.author), stock(x.stock), price(x.price) {}
 
 // operator=
 Book& Book::operator=(const Book& x) {
     if (&x != this) {
+        text = x.text;
         title = x.title;
         publisher = x.publisher;
         isbn = x.isbn;
@@ -30,19 +34,31 @@ Book& Book::operator=(const Book& x) {
     return *this;
 }
 
+// 新内存块装下四个字段后再替换，参数可以指向旧内存块
+void Book::assignText(const TextRef& newTitle, const TextRef& newPublisher,
+                      const TextRef& newISBN, const TextRef& newAuthor) {
+    std::shared_ptr<TextArena> arena = std::make_shared<TextArena>(
+        newTitle.size() + newPublisher.size() + newISBN.size() + newAuthor.size() + 5);
+    title = arena->store(newTitle);
+    publisher = arena->store(newPublisher);
+    isbn = arena->store(newISBN);
+    author = arena->store(newAuthor);
+    text = arena;
+}
+
 // Getter
-std::string Book::getTitle()    const {return title;}
-std::string Book::getPublisher()const {return publisher;}
-std::string Book::getISBN()     const {return isbn;}
-std::string Book::getAuthor()   const {return author;}
+TextRef Book::getTitle()        const {return title;}
+TextRef Book::getPublisher()    const {return publisher;}
+TextRef Book::getISBN()         const {return isbn;}
+TextRef Book::getAuthor()       const {return author;}
 int Book::getStock()            const {return stock;}
 double Book::getPrice()         const {return price;}
 
 // Setter
-void Book::setTitle(const std::string& newTitle)        {title = newTitle;}
-void Book::setPublisher(const std::string& newPublisher){publisher = newPublisher;}
-void Book::setISBN(const std::string& newISBN)          {isbn = newISBN;}
-void Book::setAuthor(const std::string& newAuthor)      {author = newAuthor;}
+void Book::setTitle(const std::string& newTitle)        {assignText(newTitle, publisher, isbn, author);}
+void Book::setPublisher(const std::string& newPublisher){assignText(title, newPublisher, isbn, author);}
+void Book::setISBN(const std::string& newISBN)          {assignText(title, publisher, newISBN, author);}
+void Book::setAuthor(const std::string& newAuthor)      {assignText(title, publisher, isbn, newAuthor);}
 void Book::setStock(int newStock)                       {stock = newStock;}
 void Book::setPrice(double newPrice)                    {price = newPrice;}
 
@@ -61,19 +77,19 @@ std::ostream& operator<<(std::ostream& os, const Book& book) {
     // ISBN(长度 + 字符串)
     int isbnLen = book.isbn.length();
     os.write(reinterpret_cast<const char*>(&isbnLen), sizeof(isbnLen));
-    os.write(book.isbn.c_str(), isbnLen);
+    os.write(book.isbn.data(), isbnLen);
     // 书名
     int titleLen = book.title.length();
     os.write(reinterpret_cast<const char*>(&titleLen), sizeof(titleLen));
-    os.write(book.title.c_str(), titleLen);
+    os.write(book.title.data(), titleLen);
     // 作者
     int authorLen = book.author.length();
     os.write(reinterpret_cast<const char*>(&authorLen), sizeof(authorLen));
-    os.write(book.author.c_str(), authorLen);
+    os.write(book.author.data(), authorLen);
     // 出版社
     int publisherLen = book.publisher.length();
     os.write(reinterpret_cast<const char*>(&publisherLen), sizeof(publisherLen));
-    os.write(book.publisher.c_str(), publisherLen);
+    os.write(book.publisher.data(), publisherLen);
     // 库存 价格
     os.write(reinterpret_cast<const char*>(&book.stock), sizeof(book.stock));
     os.write(reinterpret_cast<const char*>(&book.price), sizeof(book.price));
@@ -83,6 +99,7 @@ std::ostream& operator<<(std::ostream& os, const Book& book) {
 
 // ===STAR: binary read===
 std::istream& operator>>(std::istream& is, Book& book) {
+    std::string isbn = book.isbn, title = book.title, author = book.author, publisher = book.publisher;
     // ISBN
     int isbnLen;
     is.read(reinterpret_cast<char*>(&isbnLen), sizeof(isbnLen));
@@ -90,7 +107,7 @@ std::istream& operator>>(std::istream& is, Book& book) {
         char* Temp = new char[isbnLen + 1]; // 'isbn+1'的原因：字符串的末尾有一个'\0'，倘若不处理会造成数组溢出
             is.read(Temp, isbnLen);
             Temp[isbnLen] = '\0';
-            book.isbn = Temp;
+            isbn = Temp;
         delete[] Temp;
     }
     // 读取书名
@@ -100,7 +117,7 @@ std::istream& operator>>(std::istream& is, Book& book) {
         char* Temp = new char[titleLen + 1];
             is.read(Temp, titleLen);
             Temp[titleLen] = '\0';
-            book.title = Temp;
+            title = Temp;
         delete[] Temp;
     }
     // 读取作者
@@ -110,7 +127,7 @@ std::istream& operator>>(std::istream& is, Book& book) {
         char* Temp = new char[authorLen + 1];
             is.read(Temp, authorLen);
             Temp[authorLen] = '\0';
-            book.author = Temp;
+            author = Temp;
         delete[] Temp;
     }
     // 读取出版社
@@ -120,12 +137,61 @@ std::istream& operator>>(std::istream& is, Book& book) {
         char* Temp = new char[publisherLen + 1];
             is.read(Temp, publisherLen);
             Temp[publisherLen] = '\0';
-            book.publisher = Temp;
+            publisher = Temp;
         delete[] Temp;
     }
+    book.assignText(title, publisher, isbn, author);
     // 读取库存和价格
     is.read(reinterpret_cast<char*>(&book.stock), sizeof(book.stock));
     is.read(reinterpret_cast<char*>(&book.price), sizeof(book.price));
     
     return is;
 }
+
+// ===从内存缓冲区解析（mmap加载用）===
+namespace {
+    // 读取"长度 + 字符串"字段，检查边界后返回指向缓冲区内的引用，不复制
+    const char* readField(const char* p, const char* end, TextRef& out) {
+        int len;
+        if (end - p < static_cast<std::ptrdiff_t>(sizeof(len))) {return NULL;}
+        std::memcpy(&len, p, sizeof(len));
+        p += sizeof(len);
+        if (len < 0 || end - p < len) {return NULL;}
+        out = TextRef(p, static_cast<size_t>(len));
+        return p + len;
+    }
+
+    // 解析整条记录：字符串字段先指向缓冲区，由调用方决定复制到哪个内存块
+    const char* readRecord(const char* p, const char* end, TextRef fields[4], int& stock, double& price) {
+        for (int i = 0; i < 4; ++i) {
+            if (!(p = readField(p, end, fields[i]))) {return NULL;}
+        }
+        if (end - p < static_cast<std::ptrdiff_t>(sizeof(stock) + sizeof(price))) {return NULL;}
+        std::memcpy(&stock, p, sizeof(stock));
+        p += sizeof(stock);
+        std::memcpy(&price, p, sizeof(price));
+        p += sizeof(price);
+        return p;
+    }
+}
+
+// 字段顺序：ISBN、书名、作者、出版社
+const char* Book::fromBinary(const char* data, const char* end, const std::shared_ptr<TextArena>& arena) {
+    TextRef fields[4];
+    const char* p = readRecord(data, end, fields, stock, price);
+    if (!p) {return NULL;}
+    isbn = arena->store(fields[0]);
+    title = arena->store(fields[1]);
+    author = arena->store(fields[2]);
+    publisher = arena->store(fields[3]);
+    text = arena;
+    return p;
+}
+
+const char* Book::fromBinary(const char* data, const char* end) {
+    TextRef fields[4];
+    const char* p = readRecord(data, end, fields, stock, price);
+    if (!p) {return NULL;}
+    assignText(fields[1], fields[3], fields[0], fields[2]);
+    return p;
+}
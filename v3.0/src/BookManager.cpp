@@ -2,8 +2,12 @@
 #include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <cstring>
+#include "../include/MappedFile.h"
+#include "../include/CatalogFile.h"
+#include "../include/AtomicFile.h"
 
-BookManager::BookManager() {}
+BookManager::BookManager() : searchIndexStale(false), totalStock(0), totalStockStale(false), orderIndexStale(false) {}
 BookManager::~BookManager() {}
 // 查找图书索引
 int BookManager::findIndex(const std::string& isbn) const {
@@ -15,11 +19,139 @@ int BookManager::findIndex(const std::string& isbn) const {
     return -1;
 }
 
+// 批量查找：先把要找的ISBN排好序，再遍历一次books逐本二分匹配（直接比较字节，不为每本书构造std::string）
+std::vector<int> BookManager::findIndices(const std::vector<std::string>& isbns) const {
+    std::vector<int> result(isbns.size(), -1);
+    std::vector<std::pair<TextRef, size_t> > wanted;
+    wanted.reserve(isbns.size());
+    for (size_t i=0; i<isbns.size(); ++i) {wanted.push_back(std::make_pair(TextRef(isbns[i]), i));}
+    std::sort(wanted.begin(), wanted.end());
+    
+    for (size_t b=0; b<books.size(); ++b) {
+        TextRef isbn = books[b].getISBN();
+        std::vector<std::pair<TextRef, size_t> >::const_iterator it =
+            std::lower_bound(wanted.begin(), wanted.end(), std::make_pair(isbn, size_t(0)));
+        for (; it != wanted.end() && it->first == isbn; ++it) {
+            if (result[it->second] == -1) {result[it->second] = static_cast<int>(b);}
+        }
+    }
+    return result;
+}
+
+// 登记/注销第index本书的模糊查询索引
+void BookManager::indexBook(size_t index) {
+    if (searchIndexStale) {return;}   // 反正要整体重建
+    uint32_t id = static_cast<uint32_t>(index);
+    titleIndex.add(id, books[index].getTitle());
+    authorIndex.add(id, books[index].getAuthor());
+    publisherIndex.add(id, books[index].getPublisher());
+}
+
+void BookManager::unindexBook(size_t index) {
+    if (searchIndexStale) {return;}
+    uint32_t id = static_cast<uint32_t>(index);
+    titleIndex.remove(id, books[index].getTitle());
+    authorIndex.remove(id, books[index].getAuthor());
+    publisherIndex.remove(id, books[index].getPublisher());
+}
+
+// 索引失效时整体重建
+void BookManager::ensureSearchIndex() const {
+    if (!searchIndexStale) {return;}
+    titleIndex.clear();
+    authorIndex.clear();
+    publisherIndex.clear();
+    for (size_t i=0; i<books.size(); ++i) {
+        uint32_t id = static_cast<uint32_t>(i);
+        titleIndex.add(id, books[i].getTitle());
+        authorIndex.add(id, books[i].getAuthor());
+        publisherIndex.add(id, books[i].getPublisher());
+    }
+    searchIndexStale = false;
+}
+
+void BookManager::invalidateSearchIndex() {
+    searchIndexStale = true;
+    totalStockStale = true;
+    orderIndexStale = true;
+}
+
+// 登记/注销第index本书的有序索引
+void BookManager::orderBook(size_t index) {
+    if (orderIndexStale) {return;}
+    priceOrder.insert(std::make_pair(books[index].getPrice(), recordIds[index]));
+    stockOrder.insert(std::make_pair(static_cast<double>(books[index].getStock()), recordIds[index]));
+}
+
+void BookManager::unorderBook(size_t index) {
+    if (orderIndexStale) {return;}
+    priceOrder.erase(std::make_pair(books[index].getPrice(), recordIds[index]));
+    stockOrder.erase(std::make_pair(static_cast<double>(books[index].getStock()), recordIds[index]));
+}
+
+// 整体构建：重新按下标分配记录编号，先排好序再按序插入（每次都插在末尾，不必查找位置）
+void BookManager::rebuildOrderIndex() const {
+    recordIds.resize(books.size());
+    positions.resize(books.size());
+    std::vector<std::pair<double, size_t> > prices(books.size()), stocks(books.size());
+    for (size_t i=0; i<books.size(); ++i) {
+        recordIds[i] = positions[i] = i;
+        prices[i] = std::make_pair(books[i].getPrice(), i);
+        stocks[i] = std::make_pair(static_cast<double>(books[i].getStock()), i);
+    }
+    std::sort(prices.begin(), prices.end());
+    std::sort(stocks.begin(), stocks.end());
+    priceOrder = OrderIndex(prices.begin(), prices.end());
+    stockOrder = OrderIndex(stocks.begin(), stocks.end());
+    orderIndexStale = false;
+}
+
+void BookManager::ensureOrderIndex() const {
+    if (orderIndexStale) {rebuildOrderIndex();}
+}
+
+// 区间查询：lower_bound定位起点后顺序取出
+std::vector<size_t> BookManager::rangeIndices(const OrderIndex& index, double low, double high) const {
+    ensureOrderIndex();
+    std::vector<size_t> result;
+    OrderIndex::const_iterator it = index.lower_bound(std::make_pair(low, static_cast<size_t>(0)));
+    for (; it != index.end() && it->first <= high; ++it) {result.push_back(positions[it->second]);}
+    return result;
+}
+
+// 模糊查询：先用n-gram倒排表求候选集，再逐个用find校验
+std::vector<size_t> BookManager::matchIndices(const NgramIndex& index, TextRef (Book::*field)() const,
+                                              const std::string& keyword) const {
+    ensureSearchIndex();
+    std::vector<size_t> result;
+    std::vector<uint32_t> candidates;
+    if (!index.candidates(keyword, candidates)) {
+        // 空串或非法UTF-8：退回全表扫描
+        for (size_t i=0; i<books.size(); ++i) {
+            if ((books[i].*field)().find(keyword) != std::string::npos) {result.push_back(i);}
+        }
+        return result;
+    }
+    for (size_t i=0; i<candidates.size(); ++i) {
+        if ((books[candidates[i]].*field)().find(keyword) != std::string::npos) {
+            result.push_back(candidates[i]);
+        }   // STAR：模糊查询，如果有字符串片段即查询成功
+    }
+    return result;
+}
+
 // 添加图书
 bool BookManager::addBook(const Book& book) {
     if (findIndex(book.getISBN()) != -1) {return false;}  // ISBN重复
     
     books.push_back(book);
+    if (!orderIndexStale) {
+        recordIds.push_back(positions.size());
+        positions.push_back(books.size() - 1);
+    }
+    indexBook(books.size() - 1);
+    orderBook(books.size() - 1);
+    totalStock += book.getStock();
     return true;    // 为什么要写成布尔函数？方便执行失败时返回错误
 }
 
@@ -39,63 +171,45 @@ const Book* BookManager::findByISBN(const std::string& isbn) const {
 // 根据书名查找图书
 std::vector<Book*> BookManager::findByTitle(const std::string& title) {
     std::vector<Book*> result;
-    for (auto& book : books) {
-        if (book.getTitle().find(title) != std::string::npos) {
-            result.push_back(&book);
-        }   // STAR：模糊查询，如果有字符串片段即查询成功
-    }
+    std::vector<size_t> hits = matchIndices(titleIndex, &Book::getTitle, title);
+    for (size_t i=0; i<hits.size(); ++i) {result.push_back(&books[hits[i]]);}
     return result;
 }
 
 std::vector<const Book*> BookManager::findByTitle(const std::string& title) const {
     std::vector<const Book*> result;
-    for (const auto& book : books) {
-        if (book.getTitle().find(title) != std::string::npos) {
-            result.push_back(&book);
-        }
-    }
+    std::vector<size_t> hits = matchIndices(titleIndex, &Book::getTitle, title);
+    for (size_t i=0; i<hits.size(); ++i) {result.push_back(&books[hits[i]]);}
     return result;
 }
 
 // 根据作者查找图书
 std::vector<Book*> BookManager::findByAuthor(const std::string& author) {
     std::vector<Book*> result;
-    for (auto& book : books) {
-        if (book.getAuthor().find(author) != std::string::npos) {
-            result.push_back(&book);
-        }
-    }
+    std::vector<size_t> hits = matchIndices(authorIndex, &Book::getAuthor, author);
+    for (size_t i=0; i<hits.size(); ++i) {result.push_back(&books[hits[i]]);}
     return result;
 }
 
 std::vector<const Book*> BookManager::findByAuthor(const std::string& author) const {
     std::vector<const Book*> result;
-    for (const auto& book : books) {
-        if (book.getAuthor().find(author) != std::string::npos) {
-            result.push_back(&book);
-        }
-    }
+    std::vector<size_t> hits = matchIndices(authorIndex, &Book::getAuthor, author);
+    for (size_t i=0; i<hits.size(); ++i) {result.push_back(&books[hits[i]]);}
     return result;
 }
 
 // 根据出版社查找图书
 std::vector<Book*> BookManager::findByPublisher(const std::string& publisher) {
     std::vector<Book*> result;
-    for (auto& book : books) {
-        if (book.getPublisher().find(publisher) != std::string::npos) {
-            result.push_back(&book);
-        }
-    }
+    std::vector<size_t> hits = matchIndices(publisherIndex, &Book::getPublisher, publisher);
+    for (size_t i=0; i<hits.size(); ++i) {result.push_back(&books[hits[i]]);}
     return result;
 }
 
 std::vector<const Book*> BookManager::findByPublisher(const std::string& publisher) const {
     std::vector<const Book*> result;
-    for (const auto& book : books) {
-        if (book.getPublisher().find(publisher) != std::string::npos) {
-            result.push_back(&book);
-        }
-    }
+    std::vector<size_t> hits = matchIndices(publisherIndex, &Book::getPublisher, publisher);
+    for (size_t i=0; i<hits.size(); ++i) {result.push_back(&books[hits[i]]);}
     return result;
 }
 
@@ -109,7 +223,12 @@ bool BookManager::updateBook(const std::string& isbn, const Book& newBook) {
         return false;  // 新的ISBN已存在
     }
     
+    unindexBook(index);
+    unorderBook(index);
+    totalStock += newBook.getStock() - books[index].getStock();
     books[index] = newBook;
+    indexBook(index);
+    orderBook(index);
     return true;
 }
 
@@ -118,10 +237,83 @@ bool BookManager::deleteBook(const std::string& isbn) {
     int index = findIndex(isbn);
     if (index == -1) {return false;} // 图书不存在
     
+    totalStock -= books[index].getStock();
+    unorderBook(index);
     books.erase(books.begin() + index); // vector库函数
+    searchIndexStale = true;            // 后续图书下标前移，索引延迟重建
+    if (!orderIndexStale) {
+        // 有序索引按记录编号登记，不受下标前移影响；只需更新后续图书的下标（与erase一样是线性的）
+        positions[recordIds[index]] = NO_POSITION;
+        recordIds.erase(recordIds.begin() + index);
+        for (size_t i=index; i<recordIds.size(); ++i) {positions[recordIds[i]] = i;}
+    }
+    return true;
+}
+
+
+// 调整库存
+bool BookManager::updateStock(const std::string& isbn, int delta) {
+    int index = findIndex(isbn);
+    if (index == -1) {return false;}
+    int stock = books[index].getStock() + delta;
+    if (stock < 0) {return false;}  // 库存不足
+    
+    unorderBook(index);
+    books[index].setStock(stock);
+    orderBook(index);
+    totalStock += delta;
+    return true;
+}
+
+// 批量根据ISBN查找
+std::vector<const Book*> BookManager::findByISBNs(const std::vector<std::string>& isbns) const {
+    std::vector<int> indices = findIndices(isbns);
+    std::vector<const Book*> result(indices.size(), nullptr);
+    for (size_t i=0; i<indices.size(); ++i) {
+        if (indices[i] != -1) {result[i] = &books[indices[i]];}
+    }
+    return result;
+}
+
+// 批量调整库存：下标由调用方用findIndices解析好，这里只按下标合并并全部检查，再一起修改
+bool BookManager::updateStocks(const std::vector<std::pair<int, int> >& changes) {
+    std::vector<std::pair<int, int> > merged(changes);   // (下标, 合计变化量)
+    for (size_t i=0; i<merged.size(); ++i) {
+        if (merged[i].first < 0 || static_cast<size_t>(merged[i].first) >= books.size()) {return false;}
+    }
+    std::sort(merged.begin(), merged.end());
+    size_t count = 0;
+    for (size_t i=0; i<merged.size(); ++i) {
+        if (count > 0 && merged[count-1].first == merged[i].first) {
+            merged[count-1].second += merged[i].second;
+        } else {
+            merged[count++] = merged[i];
+        }
+    }
+    merged.resize(count);
+    for (size_t i=0; i<merged.size(); ++i) {
+        if (books[merged[i].first].getStock() + merged[i].second < 0) {return false;}  // 库存不足
+    }
+    
+    for (size_t i=0; i<merged.size(); ++i) {
+        size_t index = static_cast<size_t>(merged[i].first);
+        unorderBook(index);
+        books[index].setStock(books[index].getStock() + merged[i].second);
+        orderBook(index);
+        totalStock += merged[i].second;
+    }
     return true;
 }
 
+// 总库存量（失效时重算一次）
+long long BookManager::getTotalStock() const {
+    if (totalStockStale) {
+        totalStock = 0;
+        for (size_t i=0; i<books.size(); ++i) {totalStock += books[i].getStock();}
+        totalStockStale = false;
+    }
+    return totalStock;
+}
 
 // 获取所有图书
 std::vector<Book>& BookManager::getAllBooks()             {return books;}
@@ -129,40 +321,108 @@ const std::vector<Book>& BookManager::getAllBooks() const {return books;}
 // 图书总数
 size_t BookManager::getBookAmount() const {return books.size();}
 // 清空所有图书
-void BookManager::clear() {books.clear();}
+void BookManager::clear() {
+    books.clear();
+    titleIndex.clear();
+    authorIndex.clear();
+    publisherIndex.clear();
+    searchIndexStale = false;
+    totalStock = 0;
+    totalStockStale = false;
+    priceOrder.clear();
+    stockOrder.clear();
+    recordIds.clear();
+    positions.clear();
+    orderIndexStale = false;
+}
 
 
-// 按价格排序（decreasing）
+// 按价格排序（decreasing）：有序索引本身就是排好的，倒序取出即可
 std::vector<Book*> BookManager::sortByPrice() {
+    ensureOrderIndex();
     std::vector<Book*> result;
-    for (auto& book : books) {
-        result.push_back(&book);
-    }   // 复制一个临时数组
-    
-    std::sort(result.begin(), result.end(), 
-    [](Book* a, Book* b)->bool{return a->getPrice() > b->getPrice();});    // STAR: lambda表达式
-    
+    result.reserve(books.size());
+    for (OrderIndex::reverse_iterator it = priceOrder.rbegin(); it != priceOrder.rend(); ++it) {
+        result.push_back(&books[positions[it->second]]);
+    }
     return result;
 }
 
 // 按库存量排序（decreasing）
 std::vector<Book*> BookManager::sortByStock() {
+    ensureOrderIndex();
     std::vector<Book*> result;
-    for (auto& book : books) {
-        result.push_back(&book);
+    result.reserve(books.size());
+    for (OrderIndex::reverse_iterator it = stockOrder.rbegin(); it != stockOrder.rend(); ++it) {
+        result.push_back(&books[positions[it->second]]);
     }
-    
-    std::sort(result.begin(), result.end(), 
-    [](Book* a, Book* b)->bool{return a->getStock() > b->getStock();});
-    
+    return result;
+}
+
+// 价格区间查询
+std::vector<Book*> BookManager::findByPriceRange(double low, double high) {
+    std::vector<Book*> result;
+    std::vector<size_t> hits = rangeIndices(priceOrder, low, high);
+    for (size_t i=0; i<hits.size(); ++i) {result.push_back(&books[hits[i]]);}
+    return result;
+}
+
+// 库存区间查询
+std::vector<Book*> BookManager::findByStockRange(int low, int high) {
+    std::vector<Book*> result;
+    std::vector<size_t> hits = rangeIndices(stockOrder, low, high);
+    for (size_t i=0; i<hits.size(); ++i) {result.push_back(&books[hits[i]]);}
+    return result;
+}
+
+// 排行选择：只保证[offset, end)内有序，其余位置不排
+std::vector<size_t> BookManager::rankIndices(RankKey key, size_t offset, size_t limit) const {
+    std::vector<size_t> result;
+    if (offset >= books.size() || limit == 0) {return result;}
+    size_t end = std::min(books.size(), offset + std::min(limit, books.size() - offset));
+
+    // 先取出比较字段，选择时不必反复跳到Book对象里
+    std::vector<std::pair<double, size_t> > keys(books.size());
+    for (size_t i=0; i<books.size(); ++i) {
+        keys[i].first = key == RANK_BY_PRICE ? books[i].getPrice() : static_cast<double>(books[i].getStock());
+        keys[i].second = i;
+    }
+    // 值降序，并列时下标升序
+    struct Before {
+        bool operator()(const std::pair<double, size_t>& a, const std::pair<double, size_t>& b) const {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        }
+    };
+    if (offset > 0) {
+        std::nth_element(keys.begin(), keys.begin() + offset, keys.end(), Before());
+    }
+    std::partial_sort(keys.begin() + offset, keys.begin() + end, keys.end(), Before());
+
+    result.reserve(end - offset);
+    for (size_t i=offset; i<end; ++i) {result.push_back(keys[i].second);}
+    return result;
+}
+
+std::vector<Book*> BookManager::topKByPrice(size_t k) {return rankRange(RANK_BY_PRICE, 0, k);}
+std::vector<Book*> BookManager::topKByStock(size_t k) {return rankRange(RANK_BY_STOCK, 0, k);}
+
+std::vector<Book*> BookManager::rankRange(RankKey key, size_t offset, size_t limit) {
+    std::vector<size_t> indices = rankIndices(key, offset, limit);
+    std::vector<Book*> result;
+    result.reserve(indices.size());
+    for (size_t i=0; i<indices.size(); ++i) {result.push_back(&books[indices[i]]);}
     return result;
 }
 
 // 保存到文件
-bool BookManager::saveFile(const std::string& filename){
-    std::ofstream file(filename, std::ios::binary);
+AtomicFile::CommitResult BookManager::saveFile(const std::string& filename, FileFormat format){
+    if (format == FORMAT_CATALOG) {return CatalogFile::write(filename, books);}
+
+    // 先写临时文件再改名覆盖，写到一半失败时原文件保持不变
+    AtomicFile atomic(filename);
+    if (!atomic.isOpen()) {return AtomicFile::CommitResult::Failed;}  // 失败1
+    std::ostream& file = atomic.stream();
 
-    if (!file) {return false;}  // 失败1
     try {
         int amount = static_cast<int>(books.size());    // 图书总数
         file.write(reinterpret_cast<const char*>(&amount), sizeof(amount));
@@ -171,44 +431,48 @@ bool BookManager::saveFile(const std::string& filename){
         for (const auto& book : books) {
             file << book;
         }
-        
-        file.close();
 
-        return true;
-    }catch (...) {  // ...代指多种类型的异常
-        if (file.is_open()) {
-            file.close();
-        }
-        return false;           // 失败2
+        return file ? atomic.commit() : AtomicFile::CommitResult::Failed;     // 失败2：写入或落盘失败
+    }catch (...) {  // 异常时atomic析构会删除临时文件，原文件不变
+        return AtomicFile::CommitResult::Failed;           // 失败3
     }
 }
 
-// 从文件加载
+// 从文件加载（内存映射，记录在映射区内原地校验并解析）
 bool BookManager::loadFile(const std::string& filename) {
-    std::ifstream file(filename, std::ios::binary);
+    MappedFile file;
+    if (!file.open(filename)) {return false;}
 
-    if (!file) {return false;}
-    try {
-        // 读取图书数量
-        int amount;
-        file.read(reinterpret_cast<char*>(&amount), sizeof(amount));
-        
-        // 清空现有图书
-        books.clear();
-        
-        // 读取每本图书
-        for (int i = 0; i < amount; ++i) {
-            Book book;
-            file >> book;
-            books.push_back(book);
-        }
-        
-        file.close();
+    if (CatalogFile::isCatalogFile(file)) {
+        if (!CatalogFile::readAll(file, books)) {return false;}
+        invalidateSearchIndex();
+        rebuildOrderIndex();    // 有序索引在加载时立即构建，首次查询不再付出重建代价
         return true;
-    } catch (...) {
-        if (file.is_open()) {
-            file.close();
-        }
-        return false;
     }
+
+    const char* p = file.data();
+    const char* end = p + file.size();
+
+    // 读取图书数量
+    int amount;
+    if (file.size() < sizeof(amount)) {return false;}
+    std::memcpy(&amount, p, sizeof(amount));
+    p += sizeof(amount);
+    // 每条记录至少包含4个长度字段 + 库存 + 价格，借此拒绝明显损坏的数量
+    const size_t minRecord = 4 * sizeof(int) + sizeof(int) + sizeof(double);
+    if (amount < 0 || static_cast<size_t>(amount) > file.size() / minRecord) {return false;}
+
+    // 先解析到临时容器，全部成功后再替换，截断的文件不会留下半份数据
+    // 字符串字段统一复制进一块与文件等大的内存（每个字段的长度前缀足够放下'\0'），不逐字段分配
+    std::shared_ptr<TextArena> arena = std::make_shared<TextArena>(file.size());
+    std::vector<Book> loaded(static_cast<size_t>(amount));
+    for (int i = 0; i < amount; ++i) {
+        p = loaded[i].fromBinary(p, end, arena);
+        if (!p) {return false;}
+    }
+
+    books.swap(loaded);
+    invalidateSearchIndex();
+    rebuildOrderIndex();
+    return true;
 }
@@ -0,0 +1,300 @@
+#include "../include/CatalogFile.h"
+#include "../include/AtomicFile.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+
+namespace {
+    const char HEADER_MAGIC[8] = {'B', 'M', 'S', 'C', 'A', 'T', 'L', 'G'};
+    const char FOOTER_MAGIC[8] = {'B', 'M', 'S', 'F', 'O', 'O', 'T', '1'};
+    const uint16_t ENDIAN_MARK = 0xFEFF;    // 反序读出为0xFFFE说明字节序不同
+    const size_t HEADER_SIZE = 32;
+    const size_t BLOCK_HEADER_SIZE = 12;
+    const size_t TRAILER_SIZE = 24;
+    const size_t ENTRY_SIZE = 16;           // ISBN偏移 | ISBN长度 | 块号 | 块内偏移
+
+    template <typename T>
+    void put(std::string& out, T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    template <typename T>
+    T get(const char* p) {
+        T value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    // 写文件时的索引条目
+    struct IndexEntry {
+        std::string isbn;
+        uint32_t block;
+        uint32_t offset;
+        bool operator<(const IndexEntry& x) const {return isbn < x.isbn;}
+    };
+
+    // 从尾部索引解析出的文件结构
+    struct Layout {
+        uint64_t recordCount;
+        std::vector<uint64_t> blockOffsets;
+        uint64_t entryCount;
+        const char* entries;        // 定长条目数组
+        const char* strings;        // ISBN字符串表
+        size_t stringsLength;
+    };
+
+    // 校验文件头、文件尾与尾部索引
+    bool parseLayout(const MappedFile& file, Layout& layout) {
+        if (!CatalogFile::isCatalogFile(file)) {return false;}
+        const char* base = file.data();
+        size_t size = file.size();
+        if (size < HEADER_SIZE + TRAILER_SIZE) {return false;}
+
+        if (get<uint16_t>(base + 8) != CatalogFile::VERSION) {return false;}
+        if (get<uint16_t>(base + 10) != ENDIAN_MARK) {return false;}
+        if (CatalogFile::crc32c(base, 24) != get<uint32_t>(base + 24)) {return false;}
+        layout.recordCount = get<uint64_t>(base + 16);
+
+        const char* trailer = base + size - TRAILER_SIZE;
+        if (std::memcmp(trailer + 16, FOOTER_MAGIC, sizeof(FOOTER_MAGIC)) != 0) {return false;}
+        uint64_t footerOffset = get<uint64_t>(trailer);
+        uint32_t footerLength = get<uint32_t>(trailer + 8);
+        if (footerOffset < HEADER_SIZE || footerOffset + footerLength != size - TRAILER_SIZE) {return false;}
+        const char* footer = base + footerOffset;
+        if (CatalogFile::crc32c(footer, footerLength) != get<uint32_t>(trailer + 12)) {return false;}
+
+        // 尾部索引内容已通过CRC，这里只需检查结构长度自洽
+        const char* p = footer;
+        const char* end = footer + footerLength;
+        if (end - p < 4) {return false;}
+        uint32_t blockCount = get<uint32_t>(p);
+        p += 4;
+        if (static_cast<uint64_t>(end - p) < static_cast<uint64_t>(blockCount) * 8 + 8) {return false;}
+        layout.blockOffsets.resize(blockCount);
+        for (uint32_t i = 0; i < blockCount; ++i, p += 8) {
+            layout.blockOffsets[i] = get<uint64_t>(p);
+            if (layout.blockOffsets[i] + BLOCK_HEADER_SIZE > footerOffset) {return false;}
+        }
+        layout.entryCount = get<uint64_t>(p);
+        p += 8;
+        if (static_cast<uint64_t>(end - p) / ENTRY_SIZE < layout.entryCount) {return false;}
+        layout.entries = p;
+        layout.strings = p + layout.entryCount * ENTRY_SIZE;
+        layout.stringsLength = static_cast<size_t>(end - layout.strings);
+        return true;
+    }
+
+    // 定位第index块的负载；verify为true时同时校验CRC
+    bool loadBlock(const MappedFile& file, const Layout& layout, uint32_t index,
+                   const char*& payload, uint32_t& length, uint32_t& count, bool verify = true) {
+        if (index >= layout.blockOffsets.size()) {return false;}
+        const char* block = file.data() + layout.blockOffsets[index];
+        count = get<uint32_t>(block);
+        length = get<uint32_t>(block + 4);
+        uint64_t next = index + 1 < layout.blockOffsets.size()
+                      ? layout.blockOffsets[index + 1]
+                      : file.size() - TRAILER_SIZE;     // 最后一块之后紧跟尾部索引，由调用方保证不越界
+        if (layout.blockOffsets[index] + BLOCK_HEADER_SIZE + length > next) {return false;}
+        payload = block + BLOCK_HEADER_SIZE;
+        return !verify || CatalogFile::crc32c(payload, length) == get<uint32_t>(block + 8);
+    }
+
+    // 在尾部索引中二分查找ISBN
+    bool findEntry(const Layout& layout, const std::string& isbn, uint32_t& block, uint32_t& offset) {
+        uint64_t lo = 0, hi = layout.entryCount;
+        while (lo < hi) {
+            uint64_t mid = lo + (hi - lo) / 2;
+            const char* entry = layout.entries + mid * ENTRY_SIZE;
+            uint32_t strOffset = get<uint32_t>(entry);
+            uint32_t strLength = get<uint32_t>(entry + 4);
+            if (static_cast<uint64_t>(strOffset) + strLength > layout.stringsLength) {return false;}
+            int cmp = isbn.compare(0, std::string::npos, layout.strings + strOffset, strLength);
+            if (cmp == 0) {
+                block = get<uint32_t>(entry + 8);
+                offset = get<uint32_t>(entry + 12);
+                return true;
+            }
+            if (cmp < 0) {hi = mid;}
+            else {lo = mid + 1;}
+        }
+        return false;
+    }
+
+    // CRC32C查找表（Castagnoli多项式，按8字节切片）
+    struct Crc32cTable {
+        uint32_t t[8][256];
+        Crc32cTable() {
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k) {c = (c & 1) ? (c >> 1) ^ 0x82F63B78u : c >> 1;}
+                t[0][i] = c;
+            }
+            for (uint32_t i = 0; i < 256; ++i) {
+                for (int k = 1; k < 8; ++k) {t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];}
+            }
+        }
+    };
+
+    const Crc32cTable& crcTable() {
+        static const Crc32cTable table;     // C++11保证局部静态变量的线程安全初始化
+        return table;
+    }
+
+    // 从已校验的块负载中解析单条记录
+    bool readRecord(const char* payload, uint32_t length, uint32_t offset, Book& book) {
+        if (offset >= length) {return false;}
+        return book.fromBinary(payload + offset, payload + length) != NULL;
+    }
+}
+
+// 查表法CRC32C（每次处理8字节，按小端主机展开）
+uint32_t CatalogFile::crc32c(const char* data, size_t length, uint32_t crc) {
+    const uint32_t (*table)[256] = crcTable().t;
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+    crc = ~crc;
+    while (length >= 8) {
+        uint32_t lo = get<uint32_t>(reinterpret_cast<const char*>(p)) ^ crc;
+        uint32_t hi = get<uint32_t>(reinterpret_cast<const char*>(p + 4));
+        crc = table[7][lo & 0xFF] ^ table[6][(lo >> 8) & 0xFF] ^ table[5][(lo >> 16) & 0xFF] ^ table[4][lo >> 24]
+            ^ table[3][hi & 0xFF] ^ table[2][(hi >> 8) & 0xFF] ^ table[1][(hi >> 16) & 0xFF] ^ table[0][hi >> 24];
+        p += 8;
+        length -= 8;
+    }
+    while (length--) {crc = (crc >> 8) ^ table[0][(crc ^ *p++) & 0xFF];}
+    return ~crc;
+}
+
+bool CatalogFile::isCatalogFile(const MappedFile& file) {
+    return file.size() >= sizeof(HEADER_MAGIC)
+        && std::memcmp(file.data(), HEADER_MAGIC, sizeof(HEADER_MAGIC)) == 0;
+}
+
+AtomicFile::CommitResult CatalogFile::write(const std::string& filename, const std::vector<Book>& books,
+                                            uint32_t recordsPerBlock) {
+    if (recordsPerBlock == 0) {recordsPerBlock = 1;}
+    AtomicFile atomic(filename);
+    if (!atomic.isOpen()) {return AtomicFile::CommitResult::Failed;}
+    std::ostream& file = atomic.stream();
+
+    // 文件头
+    std::string header(HEADER_MAGIC, sizeof(HEADER_MAGIC));
+    put<uint16_t>(header, VERSION);
+    put<uint16_t>(header, ENDIAN_MARK);
+    put<uint32_t>(header, recordsPerBlock);
+    put<uint64_t>(header, books.size());
+    put<uint32_t>(header, crc32c(header.data(), header.size()));
+    put<uint32_t>(header, 0);
+    file.write(header.data(), header.size());
+
+    // 数据块
+    uint64_t offset = HEADER_SIZE;
+    std::vector<uint64_t> blockOffsets;
+    std::vector<IndexEntry> entries(books.size());
+    for (size_t first = 0; first < books.size(); first += recordsPerBlock) {
+        size_t last = std::min(books.size(), first + recordsPerBlock);
+        std::ostringstream payload(std::ios::binary);
+        for (size_t i = first; i < last; ++i) {
+            entries[i].isbn = books[i].getISBN();
+            entries[i].block = static_cast<uint32_t>(blockOffsets.size());
+            entries[i].offset = static_cast<uint32_t>(payload.tellp());
+            payload << books[i];
+        }
+        std::string data = payload.str();
+        std::string blockHeader;
+        put<uint32_t>(blockHeader, static_cast<uint32_t>(last - first));
+        put<uint32_t>(blockHeader, static_cast<uint32_t>(data.size()));
+        put<uint32_t>(blockHeader, crc32c(data.data(), data.size()));
+        file.write(blockHeader.data(), blockHeader.size());
+        file.write(data.data(), data.size());
+        blockOffsets.push_back(offset);
+        offset += blockHeader.size() + data.size();
+    }
+
+    // 尾部索引：按ISBN排序，便于二分查找
+    std::sort(entries.begin(), entries.end());
+    std::string footer;
+    put<uint32_t>(footer, static_cast<uint32_t>(blockOffsets.size()));
+    for (size_t i = 0; i < blockOffsets.size(); ++i) {put<uint64_t>(footer, blockOffsets[i]);}
+    put<uint64_t>(footer, entries.size());
+    std::string strings;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        put<uint32_t>(footer, static_cast<uint32_t>(strings.size()));
+        put<uint32_t>(footer, static_cast<uint32_t>(entries[i].isbn.size()));
+        put<uint32_t>(footer, entries[i].block);
+        put<uint32_t>(footer, entries[i].offset);
+        strings += entries[i].isbn;
+    }
+    footer += strings;
+    file.write(footer.data(), footer.size());
+
+    // 文件尾
+    std::string trailer;
+    put<uint64_t>(trailer, offset);
+    put<uint32_t>(trailer, static_cast<uint32_t>(footer.size()));
+    put<uint32_t>(trailer, crc32c(footer.data(), footer.size()));
+    trailer.append(FOOTER_MAGIC, sizeof(FOOTER_MAGIC));
+    file.write(trailer.data(), trailer.size());
+
+    return file ? atomic.commit() : AtomicFile::CommitResult::Failed;
+}
+
+bool CatalogFile::readAll(const MappedFile& file, std::vector<Book>& books) {
+    Layout layout;
+    if (!parseLayout(file, layout)) {return false;}
+
+    std::shared_ptr<TextArena> arena = std::make_shared<TextArena>(file.size());    // 全部记录的字符串字段
+    std::vector<Book> loaded;
+    loaded.reserve(static_cast<size_t>(std::min<uint64_t>(layout.recordCount, file.size())));
+    for (uint32_t b = 0; b < layout.blockOffsets.size(); ++b) {
+        const char* payload;
+        uint32_t length, count;
+        if (!loadBlock(file, layout, b, payload, length, count)) {return false;}
+        const char* p = payload;
+        const char* end = payload + length;
+        for (uint32_t i = 0; i < count; ++i) {
+            loaded.push_back(Book());
+            p = loaded.back().fromBinary(p, end, arena);
+            if (!p) {return false;}
+        }
+        if (p != end) {return false;}
+    }
+    if (loaded.size() != layout.recordCount) {return false;}
+
+    books.swap(loaded);
+    return true;
+}
+
+bool CatalogFile::readBook(const std::string& filename, const std::string& isbn, Book& book) {
+    MappedFile file;
+    Layout layout;
+    if (!file.open(filename) || !parseLayout(file, layout)) {return false;}
+
+    uint32_t block, offset, length, count;
+    const char* payload;
+    if (!findEntry(layout, isbn, block, offset)) {return false;}
+    if (!loadBlock(file, layout, block, payload, length, count)) {return false;}
+    return readRecord(payload, length, offset, book);
+}
+
+bool CatalogFile::readBooks(const std::string& filename, const std::vector<std::string>& isbns,
+                            std::vector<Book>& books) {
+    MappedFile file;
+    Layout layout;
+    if (!file.open(filename) || !parseLayout(file, layout)) {return false;}
+
+    // 每个数据块只校验一次
+    std::vector<char> verified(layout.blockOffsets.size(), 0);
+    std::vector<Book> loaded;
+    for (size_t i = 0; i < isbns.size(); ++i) {
+        uint32_t block, offset, length, count;
+        const char* payload;
+        if (!findEntry(layout, isbns[i], block, offset)) {continue;}
+        if (!loadBlock(file, layout, block, payload, length, count, !verified[block])) {return false;}
+        verified[block] = 1;
+        loaded.push_back(Book());
+        if (!readRecord(payload, length, offset, loaded.back())) {return false;}
+    }
+    books.swap(loaded);
+    return true;
+}
@@ -4,6 +4,7 @@
 #include <FL/Fl_Group.H>
 #include <FL/Fl_Box.H>
 #include <sstream>
+#include <cstdio>
 #include <iomanip>
 #include <iostream>
 
@@ -61,24 +62,22 @@ public:
                     // 绘制文本
                     fl_color(FL_BLACK);
                     
-                    // 获取图书数据
-                    auto books = mainWindow->getBookManager()->getAllBooks();
+                    // 获取图书数据（引用，每画一格都复制整个书库会拖慢重绘）
+                    const std::vector<Book>& books = mainWindow->getBookManager()->getAllBooks();
                     if (R < static_cast<int>(books.size())) {
                         const Book& book = books[R];
-                        std::string text;
+                        // 字符串列直接画图书内部的字符串，只有数值列需要格式化
+                        char buffer[32] = "";
+                        const char* text = buffer;
                         switch (C) {
-                            case 0: text = book.getISBN(); break;
-                            case 1: text = book.getTitle(); break;
-                            case 2: text = book.getAuthor(); break;
-                            case 3: text = book.getPublisher(); break;
-                            case 4: text = std::to_string(book.getStock()); break;
-                            case 5: 
-                                std::stringstream ss;
-                                ss << "¥" << std::fixed << std::setprecision(2) << book.getPrice();
-                                text = ss.str();
-                                break;
+                            case 0: text = book.getISBN().c_str(); break;
+                            case 1: text = book.getTitle().c_str(); break;
+                            case 2: text = book.getAuthor().c_str(); break;
+                            case 3: text = book.getPublisher().c_str(); break;
+                            case 4: std::snprintf(buffer, sizeof(buffer), "%d", book.getStock()); break;
+                            case 5: std::snprintf(buffer, sizeof(buffer), "¥%.2f", book.getPrice()); break;
                         }
-                        fl_draw(text.c_str(), X + 5, Y, W, H, FL_ALIGN_LEFT);
+                        fl_draw(text, X + 5, Y, W, H, FL_ALIGN_LEFT);
                     }
                 }
                 fl_pop_clip();
@@ -506,28 +505,40 @@ void MainWindow::handleStatistics() {
     ss << "图书种类: " << statsSystem->getTotalBooks() << " 种\n";
     ss << "总库存量: " << statsSystem->getTotalStock() << " 本\n";
     
-    ss << "\n↓按价格排序\n";
-    auto sortedByPrice = statsSystem->getBooksSortedByPrice();
+    // 只列出前20名，不对整个书库排序
+    const size_t topCount = 20;
+    ss << "\n↓按价格排序（前" << topCount << "名）\n";
+    auto sortedByPrice = statsSystem->getTopBooksByPrice(topCount);
     for (size_t i = 0; i < sortedByPrice.size(); ++i) {
         Book* book = sortedByPrice[i];
         ss << (i + 1) << ". " << book->getTitle() 
            << " - ¥" << book->getPrice() << "\n";
     }
     
-    ss << "\n↓按库存排序\n";
-    auto sortedByStock = statsSystem->getBooksSortedByStock();
+    ss << "\n↓按库存排序（前" << topCount << "名）\n";
+    auto sortedByStock = statsSystem->getTopBooksByStock(topCount);
     for (size_t i = 0; i < sortedByStock.size(); ++i) {
         Book* book = sortedByStock[i];
         ss << (i + 1) << ". " << book->getTitle() 
            << " - " << book->getStock() << " 本\n";
     }
     
+    const int lowStock = 5;
+    std::vector<Book*> lowStockBooks = statsSystem->getLowStockBooks(lowStock);
+    ss << "\n↓库存预警（低于" << lowStock << "本，共" << lowStockBooks.size() << "种）\n";
+    for (size_t i = 0; i < lowStockBooks.size() && i < topCount; ++i) {
+        ss << lowStockBooks[i]->getTitle() << " - " << lowStockBooks[i]->getStock() << " 本\n";
+    }
+    
     showMessage(ss.str());
 }
-// 二进制文件存储
+// 二进制文件存储（带校验与尾部索引的书库格式，加载时按魔数识别，旧版文件仍可读取）
 void MainWindow::handleSave() {
-    if (bookManager->saveFile("../data/books.dat")) {
+    AtomicFile::CommitResult result = bookManager->saveFile("../data/books.dat", FORMAT_CATALOG);
+    if (result == AtomicFile::CommitResult::Replaced) {
         showMessage("数据保存成功！\n文件位置: ../data/books.dat");
+    } else if (result == AtomicFile::CommitResult::DirectorySyncFailed) {
+        showError("数据已写入，但目录同步失败！\n掉电后可能恢复为上次保存的内容");
     } else {
         showError("数据保存失败！");
     }
@@ -0,0 +1,91 @@
+#include "../include/MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile() : mapped(0), length(0), fileHandle(0), mappingHandle(0) {}
+
+bool MappedFile::open(const std::string& filename) {
+    close();
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {return false;}
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    fileHandle = file;
+    mappingHandle = mapping;
+    mapped = static_cast<const char*>(view);
+    length = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (mapped) {UnmapViewOfFile(mapped);}
+    if (mappingHandle) {CloseHandle(static_cast<HANDLE>(mappingHandle));}
+    if (fileHandle) {CloseHandle(static_cast<HANDLE>(fileHandle));}
+    mapped = 0;
+    length = 0;
+    fileHandle = 0;
+    mappingHandle = 0;
+}
+
+#else
+
+MappedFile::MappedFile() : mapped(0), length(0), fd(-1) {}
+
+bool MappedFile::open(const std::string& filename) {
+    close();
+    int file = ::open(filename.c_str(), O_RDONLY);
+    if (file < 0) {return false;}
+
+    struct stat st;
+    if (fstat(file, &st) != 0 || st.st_size == 0) {
+        ::close(file);
+        return false;
+    }
+    void* view = mmap(0, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    if (view == MAP_FAILED) {
+        ::close(file);
+        return false;
+    }
+    madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);  // 顺序读，提示内核预读
+    fd = file;
+    mapped = static_cast<const char*>(view);
+    length = static_cast<size_t>(st.st_size);
+    return true;
+}
+
+void MappedFile::close() {
+    if (mapped) {munmap(const_cast<char*>(mapped), length);}
+    if (fd >= 0) {::close(fd);}
+    mapped = 0;
+    length = 0;
+    fd = -1;
+}
+
+#endif
+
+MappedFile::~MappedFile() {close();}
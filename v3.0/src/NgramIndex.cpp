@@ -0,0 +1,142 @@
+#include "../include/NgramIndex.h"
+#include <algorithm>
+#include <iterator>
+
+namespace {
+    const uint64_t UNIGRAM_FLAG = 1ULL << 63;   // 单字gram的标志位，避免与双字gram冲突
+    const uint32_t INVALID_BASE = 0x110000;     // 非法字节映射到合法码点范围之外
+
+    // 在升序列表other中保留与cur相同的元素
+    void intersect(std::vector<uint32_t>& cur, const std::vector<uint32_t>& other) {
+        std::vector<uint32_t> out;
+        out.reserve(cur.size());
+        if (other.size() > cur.size() * 16) {
+            // 长度悬殊时逐个二分查找
+            std::vector<uint32_t>::const_iterator pos = other.begin();
+            for (size_t i = 0; i < cur.size(); ++i) {
+                pos = std::lower_bound(pos, other.end(), cur[i]);
+                if (pos == other.end()) {break;}
+                if (*pos == cur[i]) {out.push_back(cur[i]);}
+            }
+        } else {
+            std::set_intersection(cur.begin(), cur.end(), other.begin(), other.end(),
+                                  std::back_inserter(out));
+        }
+        cur.swap(out);
+    }
+}
+
+NgramIndex::NgramIndex() {}
+NgramIndex::~NgramIndex() {}
+
+// UTF-8解码
+bool NgramIndex::decode(const TextRef& text, std::vector<uint32_t>& codepoints, bool strict) {
+    codepoints.clear();
+    const unsigned char* s = reinterpret_cast<const unsigned char*>(text.data());
+    size_t n = text.size();
+    size_t i = 0;
+    while (i < n) {
+        unsigned char c = s[i];
+        size_t len = 0;
+        uint32_t cp = 0;
+        if (c < 0x80)               {len = 1; cp = c;}
+        else if ((c & 0xE0) == 0xC0) {len = 2; cp = c & 0x1F;}
+        else if ((c & 0xF0) == 0xE0) {len = 3; cp = c & 0x0F;}
+        else if ((c & 0xF8) == 0xF0) {len = 4; cp = c & 0x07;}
+
+        bool ok = len > 0 && i + len <= n;
+        for (size_t k = 1; ok && k < len; ++k) {
+            if ((s[i + k] & 0xC0) != 0x80) {ok = false;}
+            else {cp = (cp << 6) | (s[i + k] & 0x3F);}
+        }
+        if (!ok) {
+            if (strict) {return false;}
+            codepoints.push_back(INVALID_BASE + c);     // 非法字节单独成字
+            ++i;
+            continue;
+        }
+        codepoints.push_back(cp);
+        i += len;
+    }
+    return true;
+}
+
+// 单字gram：标志位 | 码点；双字gram：前一码点 << 32 | 后一码点
+void NgramIndex::extractGrams(const std::vector<uint32_t>& codepoints, std::vector<uint64_t>& grams) {
+    grams.clear();
+    for (size_t i = 0; i < codepoints.size(); ++i) {
+        grams.push_back(UNIGRAM_FLAG | codepoints[i]);
+        if (i + 1 < codepoints.size()) {
+            grams.push_back((static_cast<uint64_t>(codepoints[i]) << 32) | codepoints[i + 1]);
+        }
+    }
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+}
+
+void NgramIndex::add(uint32_t id, const TextRef& text) {
+    std::vector<uint32_t> codepoints;
+    std::vector<uint64_t> grams;
+    decode(text, codepoints, false);
+    extractGrams(codepoints, grams);
+    for (size_t i = 0; i < grams.size(); ++i) {
+        Postings& list = postings[grams[i]];
+        if (list.empty() || list.back() < id) {
+            list.push_back(id);     // 顺序追加是最常见的情况
+        } else {
+            Postings::iterator pos = std::lower_bound(list.begin(), list.end(), id);
+            if (pos == list.end() || *pos != id) {list.insert(pos, id);}
+        }
+    }
+}
+
+void NgramIndex::remove(uint32_t id, const TextRef& text) {
+    std::vector<uint32_t> codepoints;
+    std::vector<uint64_t> grams;
+    decode(text, codepoints, false);
+    extractGrams(codepoints, grams);
+    for (size_t i = 0; i < grams.size(); ++i) {
+        std::unordered_map<uint64_t, Postings>::iterator it = postings.find(grams[i]);
+        if (it == postings.end()) {continue;}
+        Postings& list = it->second;
+        Postings::iterator pos = std::lower_bound(list.begin(), list.end(), id);
+        if (pos != list.end() && *pos == id) {list.erase(pos);}
+        if (list.empty()) {postings.erase(it);}
+    }
+}
+
+void NgramIndex::clear() {postings.clear();}
+
+// 查询：取出所有gram的倒排表，从最短的开始求交集
+bool NgramIndex::candidates(const std::string& query, std::vector<uint32_t>& result) const {
+    result.clear();
+    std::vector<uint32_t> codepoints;
+    if (query.empty() || !decode(query, codepoints, true)) {return false;}
+
+    std::vector<uint64_t> grams;
+    if (codepoints.size() == 1) {
+        grams.push_back(UNIGRAM_FLAG | codepoints[0]);
+    } else {
+        // 双字gram已经隐含了单字信息，只用双字求交集
+        for (size_t i = 0; i + 1 < codepoints.size(); ++i) {
+            grams.push_back((static_cast<uint64_t>(codepoints[i]) << 32) | codepoints[i + 1]);
+        }
+        std::sort(grams.begin(), grams.end());
+        grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    }
+
+    std::vector<const Postings*> lists;
+    for (size_t i = 0; i < grams.size(); ++i) {
+        std::unordered_map<uint64_t, Postings>::const_iterator it = postings.find(grams[i]);
+        if (it == postings.end()) {return true;}    // 某个gram从未出现，结果必为空
+        lists.push_back(&it->second);
+    }
+    std::sort(lists.begin(), lists.end(),
+    [](const Postings* a, const Postings* b)->bool{return a->size() < b->size();});
+
+    result = *lists[0];
+    for (size_t i = 1; i < lists.size() && !result.empty(); ++i) {
+        intersect(result, *lists[i]);
+    }
+    return true;
+}
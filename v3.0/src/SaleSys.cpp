@@ -10,8 +10,65 @@ bool SaleSys::purchaseBook(const std::string& isbn, int quantity) {
     if (! book) {return false; }                 // 图书不存在
     if (! isSuft(book, quantity)) {return false;} // 库存不足，或购买数量为负
     
-    book->setStock(book->getStock() - quantity);
-    return true;
+    return bookManager->updateStock(isbn, -quantity);  // 经由BookManager，总库存量随之更新
+}
+
+// 批量购买
+Receipt SaleSys::purchaseBatch(const std::vector<PurchaseLine>& lines) {
+    Receipt receipt;
+    if (lines.empty()) {
+        receipt.status = Receipt::EMPTY;
+        return receipt;
+    }
+    
+    std::vector<std::string> isbns;
+    isbns.reserve(lines.size());
+    for (size_t i=0; i<lines.size(); ++i) {isbns.push_back(lines[i].isbn);}
+    std::vector<int> indices = bookManager->findIndices(isbns);   // 修改库存时直接沿用，不再重新查找
+    const std::vector<Book>& books = bookManager->getAllBooks();
+    std::vector<const Book*> found(indices.size(), nullptr);
+    for (size_t i=0; i<indices.size(); ++i) {
+        if (indices[i] != -1) {found[i] = &books[indices[i]];}
+    }
+    
+    // 先全部校验，同一本书的多行累计检查库存
+    std::vector<std::pair<const Book*, int> > demand;   // 篮子通常很小，线性查找即可
+    std::vector<std::pair<int, int> > changes;   // (下标, 变化量)
+    changes.reserve(lines.size());
+    receipt.lines.reserve(lines.size());
+    for (size_t i=0; i<lines.size(); ++i) {
+        Receipt::Status status = Receipt::OK;
+        if (lines[i].quantity <= 0) {
+            status = Receipt::INVALID_QUANTITY;
+        } else if (!found[i]) {
+            status = Receipt::BOOK_NOT_FOUND;
+        } else {
+            size_t d = 0;
+            while (d < demand.size() && demand[d].first != found[i]) {++d;}
+            if (d == demand.size()) {demand.push_back(std::make_pair(found[i], 0));}
+            demand[d].second += lines[i].quantity;
+            if (! isSuft(found[i], demand[d].second)) {status = Receipt::INSUFFICIENT_STOCK;}
+        }
+        if (status != Receipt::OK) {
+            Receipt failed;
+            failed.status = status;
+            failed.failedLine = i;
+            return failed;
+        }
+        
+        Receipt::Line line;
+        line.isbn = found[i]->getISBN();
+        line.title = found[i]->getTitle();
+        line.quantity = lines[i].quantity;
+        line.unitPrice = found[i]->getPrice();
+        line.amount = line.unitPrice * line.quantity;
+        receipt.lines.push_back(line);
+        receipt.total += line.amount;
+        changes.push_back(std::make_pair(indices[i], -line.quantity));
+    }
+    
+    bookManager->updateStocks(changes);   // 已全部校验，不会失败
+    return receipt;
 }
 
 // 总消费
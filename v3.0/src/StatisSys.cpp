@@ -8,14 +8,9 @@ size_t StatisSys::getTotalBooks() const {
     return bookManager->getBookAmount();
 }
 
-// 获取总库存量
-int StatisSys::getTotalStock() const {
-    int totalStock = 0;
-    const auto& books = bookManager->getAllBooks();
-    for (const auto& book : books) {
-        totalStock += book.getStock();
-    }
-    return totalStock;
+// 获取总库存量（BookManager增量维护，不再逐本累加）
+long long StatisSys::getTotalStock() const {
+    return bookManager->getTotalStock();
 }
 
 // 获取特定作者的所有图书
@@ -34,3 +29,15 @@ std::vector<Book*> StatisSys::getBooksSortedByPrice() {
 std::vector<Book*> StatisSys::getBooksSortedByStock() {
     return bookManager->sortByStock();
 }
+std::vector<Book*> StatisSys::getTopBooksByPrice(size_t k) {
+    return bookManager->topKByPrice(k);
+}
+std::vector<Book*> StatisSys::getTopBooksByStock(size_t k) {
+    return bookManager->topKByStock(k);
+}
+std::vector<Book*> StatisSys::getBooksInPriceRange(double low, double high) {
+    return bookManager->findByPriceRange(low, high);
+}
+std::vector<Book*> StatisSys::getLowStockBooks(int threshold) {
+    return bookManager->findByStockRange(0, threshold - 1);
+}
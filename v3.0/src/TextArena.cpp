@@ -0,0 +1,37 @@
+#include "../include/TextArena.h"
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+
+size_t TextRef::find(const TextRef& s) const {
+    const char* end = ptr + len;
+    const char* pos = std::search(ptr, end, s.ptr, s.ptr + s.len);
+    if (pos == end && s.len > 0) {return std::string::npos;}
+    return static_cast<size_t>(pos - ptr);
+}
+
+bool operator==(const TextRef& a, const TextRef& b) {
+    return a.len == b.len && std::memcmp(a.ptr, b.ptr, a.len) == 0;
+}
+
+bool operator<(const TextRef& a, const TextRef& b) {
+    int c = std::memcmp(a.ptr, b.ptr, std::min(a.len, b.len));
+    return c != 0 ? c < 0 : a.len < b.len;
+}
+
+std::ostream& operator<<(std::ostream& os, const TextRef& s) {
+    return os.write(s.data(), static_cast<std::streamsize>(s.size()));
+}
+
+// 不初始化内存，大书库加载时不必先把整块清零
+TextArena::TextArena(size_t capacity) : buffer(new char[capacity]), capacity(capacity), used(0) {}
+
+TextRef TextArena::store(const char* data, size_t length) {
+    if (length >= capacity - used) {throw std::length_error("TextArena: capacity exceeded");}
+    char* dest = buffer.get() + used;
+    std::memcpy(dest, data, length);
+    dest[length] = '\0';
+    used += length + 1;
+    return TextRef(dest, length);
+}
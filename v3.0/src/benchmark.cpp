@@ -0,0 +1,185 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include "../include/BookManager.h"
+#include "../include/CatalogFile.h"
+
+// 性能基准测试（不依赖FLTK）
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedMs(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+}
+
+// 用常见词随机拼出合成书名，近似真实书库的中文/英文混合分布
+// 直接写入底层容器（合成ISBN保证不重复），避免addBook的逐本查重主导构造时间
+static void buildCatalog(BookManager& manager, size_t n) {
+    std::vector<Book>& books = manager.getAllBooks();
+    books.reserve(n);
+    const char* words[] = {"程序设计", "数据结构", "算法", "导论", "C++", "Java", "Python", "实战",
+                           "原理", "操作系统", "计算机", "网络", "数据库", "机器学习", "深度",
+                           "入门", "精通", "编译", "设计模式", "分布式", "系统", "高级", "教程", "基础"};
+    const size_t wordCount = sizeof(words) / sizeof(words[0]);
+    const char* publishers[] = {"清华大学出版社", "人民邮电出版社", "机械工业出版社", "电子工业出版社"};
+    std::srand(42);
+    for (size_t i=0; i<n; ++i) {
+        std::string title;
+        int parts = 2 + std::rand() % 3;
+        for (int k=0; k<parts; ++k) {title += words[std::rand() % wordCount];}
+        title += "(第" + std::to_string(1 + std::rand() % 9) + "版)";
+        books.push_back(Book(title, publishers[i % 4], std::to_string(9780000000000ULL + i),
+                             "作者" + std::to_string(i % 20000), 10, 50.0));
+    }
+    manager.invalidateSearchIndex();
+}
+
+// 旧实现：逐本std::string::find
+static size_t scanTitle(const BookManager& manager, const std::string& keyword) {
+    size_t hits = 0;
+    const std::vector<Book>& books = manager.getAllBooks();
+    for (size_t i=0; i<books.size(); ++i) {
+        if (books[i].getTitle().find(keyword) != std::string::npos) {++hits;}
+    }
+    return hits;
+}
+
+// 旧实现：通过operator>>逐条读取books.dat
+static size_t streamLoad(const std::string& filename) {
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    int amount = 0;
+    file.read(reinterpret_cast<char*>(&amount), sizeof(amount));
+    std::vector<Book> books;
+    for (int i = 0; i < amount; ++i) {
+        Book book;
+        file >> book;
+        books.push_back(book);
+    }
+    return books.size();
+}
+
+// 冷启动加载：operator>> 流式读取 vs 内存映射加载
+static void benchLoad(BookManager& manager) {
+    const std::string filename = "benchmark_books.dat";
+    manager.saveFile(filename);
+
+    Clock::time_point start = Clock::now();
+    size_t streamed = streamLoad(filename);
+    double streamMs = elapsedMs(start, Clock::now());
+
+    BookManager loaded;
+    start = Clock::now();
+    bool ok = loaded.loadFile(filename);
+    double mappedMs = elapsedMs(start, Clock::now());
+    std::remove(filename.c_str());
+
+    std::cout << "加载 " << streamed << " 本 | operator>>: " << streamMs << " ms"
+              << " | 内存映射(含构建有序索引): " << mappedMs << " ms"
+              << (ok && loaded.getBookAmount() == streamed ? "" : " (加载结果不一致!)") << std::endl;
+}
+
+// 书库格式：整体加载（逐块校验CRC）vs 借助尾部索引的部分加载
+static void benchCatalog(BookManager& manager) {
+    const std::string filename = "benchmark_catalog.dat";
+    Clock::time_point start = Clock::now();
+    bool saved = manager.saveFile(filename, FORMAT_CATALOG) != AtomicFile::CommitResult::Failed;
+    double saveMs = elapsedMs(start, Clock::now());
+
+    BookManager loaded;
+    start = Clock::now();
+    bool ok = saved && loaded.loadFile(filename);
+    double loadMs = elapsedMs(start, Clock::now());
+
+    const std::vector<Book>& books = manager.getAllBooks();
+    std::vector<std::string> isbns;
+    for (size_t i=0; i<100 && !books.empty(); ++i) {isbns.push_back(books[std::rand() % books.size()].getISBN().str());}
+    std::vector<Book> partial;
+    start = Clock::now();
+    bool partialOk = CatalogFile::readBooks(filename, isbns, partial);
+    double partialMs = elapsedMs(start, Clock::now());
+
+    Book single;
+    start = Clock::now();
+    bool singleOk = !isbns.empty() && CatalogFile::readBook(filename, isbns[0], single);
+    double singleMs = elapsedMs(start, Clock::now());
+    std::remove(filename.c_str());
+
+    std::cout << "书库格式 " << books.size() << " 本 | 保存: " << saveMs << " ms | 整体加载(含校验与索引): " << loadMs << " ms"
+              << " | 部分加载" << isbns.size() << "本: " << partialMs << " ms | 单条读取: " << singleMs << " ms"
+              << (ok && loaded.getBookAmount() == books.size() && partialOk && partial.size() == isbns.size() && singleOk
+                  ? "" : " (加载结果不一致!)") << std::endl;
+}
+
+// 价格前20名：遍历有序索引 vs 部分选择；以及价格区间查询 vs 全表扫描
+static void benchRanking(BookManager& manager) {
+    std::vector<Book>& books = manager.getAllBooks();
+    for (size_t i=0; i<books.size(); ++i) {books[i].setPrice(10.0 + std::rand() % 9000 / 100.0);}
+    manager.invalidateSearchIndex();
+
+    Clock::time_point start = Clock::now();
+    std::vector<Book*> sorted = manager.sortByPrice();
+    double sortMs = elapsedMs(start, Clock::now());
+
+    start = Clock::now();
+    std::vector<Book*> top = manager.topKByPrice(20);
+    double topMs = elapsedMs(start, Clock::now());
+
+    bool same = top.size() == 20;
+    for (size_t i=0; same && i<top.size(); ++i) {same = top[i]->getPrice() == sorted[i]->getPrice();}
+    std::cout << "价格前20名 | 有序索引遍历(含首次重建): " << sortMs << " ms | topKByPrice: " << topMs << " ms"
+              << (same ? "" : " (结果不一致!)") << std::endl;
+
+    start = Clock::now();
+    size_t scanned = 0;
+    for (size_t i=0; i<books.size(); ++i) {
+        if (books[i].getPrice() >= 30.0 && books[i].getPrice() <= 30.5) {++scanned;}
+    }
+    double scanMs = elapsedMs(start, Clock::now());
+
+    start = Clock::now();
+    size_t indexed = manager.findByPriceRange(30.0, 30.5).size();
+    double rangeMs = elapsedMs(start, Clock::now());
+    std::cout << "价格区间[30, 30.5] | 全表扫描: " << scanMs << " ms | 有序索引: " << rangeMs << " ms"
+              << " | 命中 " << indexed << (indexed == scanned ? "" : " (结果不一致!)") << std::endl;
+}
+
+int main() {
+    const size_t n = 1000000;
+    BookManager manager;
+
+    Clock::time_point start = Clock::now();
+    buildCatalog(manager, n);
+    std::cout << "构造 " << n << " 本合成书库: " << elapsedMs(start, Clock::now()) << " ms" << std::endl;
+
+    // 首次查询会构建索引，单独计时
+    start = Clock::now();
+    manager.findByTitle("热身");
+    std::cout << "构建n-gram索引: " << elapsedMs(start, Clock::now()) << " ms" << std::endl;
+
+    const char* keywords[] = {"程序设计", "机器学习实战", "C++算法", "编译原理导论", "第7版", "不存在的书"};
+    std::cout << std::fixed << std::setprecision(2);
+    for (size_t k=0; k<sizeof(keywords) / sizeof(keywords[0]); ++k) {
+        std::string keyword = keywords[k];
+
+        start = Clock::now();
+        size_t scanHits = scanTitle(manager, keyword);
+        double scanMs = elapsedMs(start, Clock::now());
+
+        start = Clock::now();
+        size_t indexHits = manager.findByTitle(keyword).size();
+        double indexMs = elapsedMs(start, Clock::now());
+
+        std::cout << std::setw(16) << keyword << " | 全表扫描: " << std::setw(9) << scanMs << " ms"
+                  << " | n-gram索引: " << std::setw(9) << indexMs << " ms"
+                  << " | 命中 " << indexHits << (indexHits == scanHits ? "" : " (结果不一致!)") << std::endl;
+    }
+
+    benchLoad(manager);
+    benchCatalog(manager);
+    benchRanking(manager);
+    return 0;
+}
@@ -0,0 +1,241 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cstdio>
+#include <cstring>
+#include "../include/Book.h"
+#include "../include/BookManager.h"
+#include "../include/CatalogFile.h"
+#include "../include/MappedFile.h"
+#include "../include/SaleSys.h"
+
+// 功能测试（不依赖FLTK）
+
+// 断言辅助函数：通过时打印✓，失败时抛出异常并由main统一报告
+static void check(bool condition, const std::string& message) {
+    if (!condition) {
+        throw std::runtime_error("✗ " + message);
+    }
+    std::cout << "✓ " << message << std::endl;
+}
+
+static std::string readWhole(const std::string& filename) {
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    std::ostringstream data;
+    data << file.rdbuf();
+    return data.str();
+}
+
+static void writeWhole(const std::string& filename, const std::string& data) {
+    std::ofstream file(filename.c_str(), std::ios::binary | std::ios::trunc);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+static bool sameBook(const Book& a, const Book& b) {
+    return a.getTitle() == b.getTitle() && a.getPublisher() == b.getPublisher() && a.getISBN() == b.getISBN()
+        && a.getAuthor() == b.getAuthor() && a.getStock() == b.getStock() && a.getPrice() == b.getPrice();
+}
+
+// 合成书库：ISBN故意不按写入顺序排列，检验尾部索引的排序
+static std::vector<Book> makeBooks(size_t n) {
+    std::vector<Book> books;
+    for (size_t i = 0; i < n; ++i) {
+        size_t id = (i * 7919) % n;
+        books.push_back(Book("书名" + std::to_string(id) + (id % 3 == 0 ? "（第2版）" : ""),
+                             "出版社" + std::to_string(id % 5), std::to_string(9787000000000ULL + id),
+                             "作者" + std::to_string(id % 17), static_cast<int>(id % 50), 10.0 + id * 0.25));
+    }
+    return books;
+}
+
+static void testCatalogRoundTrip() {
+    std::cout << "=== 测试 书库文件格式读写 ===" << std::endl;
+
+    const std::string filename = "test_catalog.dat";
+    std::vector<Book> books = makeBooks(1000);
+    check(CatalogFile::write(filename, books, 64) == AtomicFile::CommitResult::Replaced, "写出整个书库（每块64条）");
+
+    MappedFile file;
+    std::vector<Book> loaded;
+    check(file.open(filename) && CatalogFile::isCatalogFile(file) && CatalogFile::readAll(file, loaded),
+          "按魔数识别并读取全部记录");
+    bool same = loaded.size() == books.size();
+    for (size_t i = 0; same && i < books.size(); ++i) {same = sameBook(loaded[i], books[i]);}
+    check(same, "读出的记录与写入的逐条一致且顺序不变");
+    file.close();
+
+    BookManager manager;
+    check(manager.loadFile(filename) && manager.getBookAmount() == books.size(), "BookManager按新格式加载");
+    check(manager.saveFile(filename, FORMAT_CATALOG) == AtomicFile::CommitResult::Replaced && file.open(filename)
+          && CatalogFile::readAll(file, loaded) && loaded.size() == books.size(), "BookManager按新格式保存后可再次读取");
+    file.close();
+
+    // 改名成功但目录同步失败时单独报告，文件已是新内容
+    AtomicFile::setFailDirectorySync(true);
+    AtomicFile::CommitResult result = CatalogFile::write(filename, books, 128);
+    AtomicFile::setFailDirectorySync(false);
+    check(result == AtomicFile::CommitResult::DirectorySyncFailed && file.open(filename)
+          && CatalogFile::readAll(file, loaded) && loaded.size() == books.size(), "目录同步失败与写入失败区分开");
+    file.close();
+
+    std::vector<Book> empty;
+    check(CatalogFile::write(filename, empty) == AtomicFile::CommitResult::Replaced && file.open(filename) && CatalogFile::readAll(file, loaded)
+          && loaded.empty(), "空书库也能读写");
+    file.close();
+
+    std::remove(filename.c_str());
+    std::cout << std::endl;
+}
+
+static void testCatalogIndex() {
+    std::cout << "=== 测试 书库文件尾部索引 ===" << std::endl;
+
+    const std::string filename = "test_catalog_index.dat";
+    std::vector<Book> books = makeBooks(1000);
+    CatalogFile::write(filename, books, 64);
+
+    Book found;
+    check(CatalogFile::readBook(filename, books[500].getISBN().str(), found) && sameBook(found, books[500]),
+          "借助尾部索引读取单条记录");
+    check(!CatalogFile::readBook(filename, "9999999999999", found), "不存在的ISBN返回false");
+
+    std::vector<std::string> isbns;
+    isbns.push_back(books[999].getISBN().str());
+    isbns.push_back("不存在");
+    isbns.push_back(books[0].getISBN().str());
+    isbns.push_back(books[1].getISBN().str());
+    std::vector<Book> partial;
+    check(CatalogFile::readBooks(filename, isbns, partial) && partial.size() == 3 && sameBook(partial[0], books[999])
+          && sameBook(partial[1], books[0]) && sameBook(partial[2], books[1]),
+          "部分加载按请求顺序返回，找不到的ISBN被忽略");
+
+    std::remove(filename.c_str());
+    std::cout << std::endl;
+}
+
+static void testCatalogCorruption() {
+    std::cout << "=== 测试 书库文件损坏检测 ===" << std::endl;
+
+    const std::string filename = "test_catalog_bad.dat";
+    std::vector<Book> books = makeBooks(300);
+    CatalogFile::write(filename, books, 64);
+    const std::string original = readWhole(filename);
+    const size_t headerSize = 32, blockHeaderSize = 12;
+    MappedFile file;
+    std::vector<Book> loaded;
+    Book found;
+
+    // 第一块负载中改一个字节：整体读取失败，其他块中的单条记录仍可读
+    std::string data = original;
+    data[headerSize + blockHeaderSize + 5] ^= 0x40;
+    writeWhole(filename, data);
+    check(file.open(filename) && !CatalogFile::readAll(file, loaded), "数据块CRC不符时整体读取失败");
+    file.close();
+    check(!CatalogFile::readBook(filename, books[0].getISBN().str(), found)
+          && CatalogFile::readBook(filename, books[299].getISBN().str(), found) && sameBook(found, books[299]),
+          "只校验被读取的数据块");
+
+    // 尾部索引中改一个字节
+    data = original;
+    data[data.size() - 24 - 3] ^= 0x01;
+    writeWhole(filename, data);
+    check(file.open(filename) && !CatalogFile::readAll(file, loaded)
+          && !CatalogFile::readBook(filename, books[299].getISBN().str(), found), "尾部索引CRC不符时拒绝读取");
+    file.close();
+
+    // 截掉文件尾的一部分
+    writeWhole(filename, original.substr(0, original.size() - 10));
+    check(file.open(filename) && CatalogFile::isCatalogFile(file) && !CatalogFile::readAll(file, loaded)
+          && !CatalogFile::readBook(filename, books[0].getISBN().str(), found), "文件尾被截断时拒绝读取");
+    file.close();
+
+    // 版本号不符（头部CRC重新计算，确认是版本检查拒绝的）
+    data = original;
+    uint16_t version = CatalogFile::VERSION + 1;
+    std::memcpy(&data[8], &version, sizeof(version));
+    uint32_t headerCrc = CatalogFile::crc32c(data.data(), 24);
+    std::memcpy(&data[24], &headerCrc, sizeof(headerCrc));
+    writeWhole(filename, data);
+    BookManager manager;
+    check(file.open(filename) && !CatalogFile::readAll(file, loaded) && !manager.loadFile(filename),
+          "版本号不符时拒绝读取");
+    file.close();
+
+    // 失败的读取不改动已有结果
+    loaded = books;
+    writeWhole(filename, original.substr(0, original.size() - 10));
+    file.open(filename);
+    CatalogFile::readAll(file, loaded);
+    file.close();
+    check(loaded.size() == books.size() && sameBook(loaded[0], books[0]), "读取失败时不改动输出参数");
+
+    std::remove(filename.c_str());
+    std::cout << std::endl;
+}
+
+static void testBatchPurchase() {
+    std::cout << "=== 测试 批量查找与批量购买 ===" << std::endl;
+
+    BookManager manager;
+    manager.addBook(Book("三体", "重庆出版社", "9787536692930", "刘慈欣", 10, 23.0));
+    manager.addBook(Book("活着", "作家出版社", "9787506365437", "余华", 3, 20.0));
+    manager.addBook(Book("围城", "人民文学出版社", "9787020090006", "钱锺书", 5, 19.0));
+
+    std::vector<std::string> isbns;
+    isbns.push_back("9787020090006");
+    isbns.push_back("不存在");
+    isbns.push_back("9787536692930");
+    isbns.push_back("9787020090006");
+    std::vector<int> indices = manager.findIndices(isbns);
+    check(indices.size() == 4 && indices[0] == 2 && indices[1] == -1 && indices[2] == 0 && indices[3] == 2,
+          "findIndices结果与请求逐个对应，重复的ISBN得到相同下标");
+
+    std::vector<std::pair<int, int> > changes;
+    changes.push_back(std::make_pair(1, -2));
+    changes.push_back(std::make_pair(1, -2));
+    check(!manager.updateStocks(changes) && manager.getAllBooks()[1].getStock() == 3, "同一本书合计库存不足时不做任何修改");
+    changes.push_back(std::make_pair(3, 1));
+    check(!manager.updateStocks(changes), "下标越界时返回false");
+
+    SaleSys sales(&manager);
+    std::vector<PurchaseLine> lines(3);
+    lines[0].isbn = "9787536692930"; lines[0].quantity = 2;
+    lines[1].isbn = "9787506365437"; lines[1].quantity = 3;
+    lines[2].isbn = "9787536692930"; lines[2].quantity = 1;
+    Receipt receipt = sales.purchaseBatch(lines);
+    check(receipt.status == Receipt::OK && receipt.lines.size() == 3 && receipt.total == 23.0 * 3 + 20.0 * 3,
+          "批量购买成功并计算总价");
+    check(manager.findByISBN("9787536692930")->getStock() == 7 && manager.findByISBN("9787506365437")->getStock() == 0
+          && manager.getTotalStock() == 12, "批量购买按查找到的下标扣减库存");
+
+    lines[1].quantity = 1;
+    receipt = sales.purchaseBatch(lines);
+    check(receipt.status == Receipt::INSUFFICIENT_STOCK && receipt.failedLine == 1
+          && manager.findByISBN("9787536692930")->getStock() == 7, "任一行失败时库存没有改动");
+    std::cout << std::endl;
+}
+
+int main() {
+    std::cout << "========================================" << std::endl;
+    std::cout << "     图书管理系统功能测试" << std::endl;
+    std::cout << "========================================" << std::endl;
+
+    try {
+        testCatalogRoundTrip();
+        testCatalogIndex();
+        testCatalogCorruption();
+        testBatchPurchase();
+
+        std::cout << "========================================" << std::endl;
+        std::cout << "     所有测试完成！" << std::endl;
+        std::cout << "========================================" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "测试过程中发生错误: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}